@@ -10,12 +10,21 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "loopStreamer.h"
+#include "decodedAudioCache.h"
+#include "loudnessAnalyser.h"
+#include <atomic>
 
 //==============================================================================
-class MainContentComponent   : public juce::AudioAppComponent
+class AudioLoopingComponent  : public juce::AudioAppComponent,
+                               private juce::Thread
 {
 public:
-    MainContentComponent()
+    /*  Pass false to build the component without opening an audio device, for hosts that
+        call prepareToPlay() / getNextAudioBlock() themselves (see offlineRender.cpp).
+    */
+    explicit AudioLoopingComponent (bool openAudioDevice = true)
+        : juce::Thread ("Loop loader")
     {
         addAndMakeVisible (openButton);
         openButton.setButtonText ("Open...");
@@ -29,56 +38,106 @@ public:
 		levelSlider.setRange(0.0,1.0);
 		levelSlider.onValueChange = [this]{currentLevel = (float) levelSlider.getValue();};
 
+        addAndMakeVisible (loopRangeSlider);
+        loopRangeSlider.setSliderStyle (juce::Slider::TwoValueHorizontal);
+        loopRangeSlider.setTextBoxStyle (juce::Slider::NoTextBox, false, 0, 0);
+        loopRangeSlider.setEnabled (false);
+        loopRangeSlider.onValueChange = [this] { loopRangeChanged(); };
+
         formatManager.registerBasicFormats();
+        streamingThread.startThread (juce::Thread::Priority::high);
+
+        // the device stays open for the lifetime of the component; loading a file only
+        // swaps the engine pointer that getNextAudioBlock() reads
+        if (openAudioDevice)
+            setAudioChannels (0, 2);
+
+        startThread();
     }
 
-    ~MainContentComponent() override
+    ~AudioLoopingComponent() override
     {
+        stopThread (4000);
         shutdownAudio();
+
+        currentEngine = nullptr;
+        engines.clear();
     }
 
-    void prepareToPlay (int, double) override {}
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override
+    {
+        // the outgoing engine renders into this during a switch, so it is sized for the whole fade
+        fadeLength = juce::jmax (1, juce::roundToInt (sampleRate * engineFadeSeconds));
+        fadeBuffer.setSize (2, juce::jmax (samplesPerBlockExpected, fadeLength));
+        fadeRemaining = 0;
+    }
 
     void getNextAudioBlock (const juce::AudioSourceChannelInfo& bufferToFill) override
     {
-		auto level = currentLevel;
+		// the loudness gain rides on the existing level ramp, so a new value never clicks
+		auto level = currentLevel * normalisationGain.load();
 		auto startLevel = juce::approximatelyEqual(level,previousLevel) ? level:previousLevel;
 
-        auto numInputChannels = fileBuffer.getNumChannels();
-        auto numOutputChannels = bufferToFill.buffer->getNumChannels();
+        auto* engine = acquireEngine();
 
-        auto outputSamplesRemaining = bufferToFill.numSamples;                              
-        auto outputSamplesOffset = bufferToFill.startSample;                                
+        // the engine copies from its current chunk, wrapping at the loop seam by itself
+        if (engine != nullptr)
+            engine->render (*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+        else
+            bufferToFill.clearActiveBufferRegion();
 
-        while (outputSamplesRemaining > 0)
-        {
-            auto bufferSamplesRemaining = fileBuffer.getNumSamples() - position;            
-            auto samplesThisTime = juce::jmin (outputSamplesRemaining, bufferSamplesRemaining);
+        if (fadeRemaining > 0)
+            crossfadeFromOutgoingEngine (bufferToFill);
 
-            for (auto channel = 0; channel < numOutputChannels; ++channel)
-            {
-                bufferToFill.buffer->copyFrom (channel,                                     
-                                               outputSamplesOffset,                         
-                                               fileBuffer,                                  
-                                               channel % numInputChannels,                  
-                                               position,                                    
-                                               samplesThisTime);
-				bufferToFill.buffer->applyGainRamp(channel,outputSamplesOffset,samplesThisTime,startLevel,level);
-            }
+        for (auto channel = 0; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+			bufferToFill.buffer->applyGainRamp(channel,bufferToFill.startSample,bufferToFill.numSamples,startLevel,level);
+
+		previousLevel = level;
+    }
 
-            outputSamplesRemaining -= samplesThisTime;                                      
-            outputSamplesOffset += samplesThisTime;                                     
-            position += samplesThisTime;                                                
+    void releaseResources() override {}
 
-            if (position == fileBuffer.getNumSamples())
-                position = 0;                                                               
+    //==============================================================================
+    /*  Same request as the Open... button, without the file chooser. The engine is
+        built on the loader thread; isFileLoaded() turns true once it is playing.
+    */
+    void openFile (const juce::File& file)
+    {
+        {
+            const juce::ScopedLock sl (requestLock);
+            fileToOpen = file;
         }
-		previousLevel = level;
+
+        notify();
+    }
+
+    bool isFileLoaded() const noexcept      { return currentEngine.load() != nullptr; }
+
+    DecodedAudioCache& getDecodedCache()    { return *decodedCache; }
+
+    /*  Plays the loop at LoudnessAnalyser::targetLufs once the file has been measured in the
+        background; the gain is picked up by the loader thread within half a second.
+    */
+    void setLoudnessNormalisation (bool shouldNormalise)
+    {
+        normalise = shouldNormalise;
+        notify();
     }
 
-    void releaseResources() override
+    /*  True from opening a file until its loudness gain is in use (or known to be unavailable). */
+    bool isLoudnessPending() const noexcept { return loudnessPending.load(); }
+
+    void setLevel (float newLevel)
     {
-        fileBuffer.setSize (0, 0);
+        levelSlider.setValue (newLevel, juce::sendNotificationSync);
+    }
+
+    /*  Engines built after this call wait for their chunks instead of underrunning, so
+        call it before openFile(). Only meant for offline rendering.
+    */
+    void setNonRealtime (bool isNonRealtime)
+    {
+        nonRealtime = isNonRealtime;
     }
 
     void resized() override
@@ -86,14 +145,13 @@ public:
         openButton .setBounds (10, 10, getWidth() - 20, 20);
         clearButton.setBounds (10, 40, getWidth() - 20, 20);
 		levelSlider.setBounds (10,70,getWidth()-20,20);
+        loopRangeSlider.setBounds (10, 100, getWidth() - 20, 20);
     }
 
 private:
     void openButtonClicked()
     {
-        shutdownAudio();                                                                            // [1]
-
-        chooser = std::make_unique<juce::FileChooser> ("Select a Wave file shorter than 2 seconds to play...",
+        chooser = std::make_unique<juce::FileChooser> ("Select a Wave file to loop...",
                                                        juce::File{},
                                                        "*.wav");
         auto chooserFlags = juce::FileBrowserComponent::openMode
@@ -106,50 +164,224 @@ private:
             if (file == juce::File{})
                 return;
 
-            std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file)); // [2]
+            openFile (file);
+        });
+    }
+
+    void clearButtonClicked()
+    {
+        clearRequested = true;
+        loopRangeSlider.setEnabled (false);
+        notify();
+    }
+
+    void loopRangeChanged()
+    {
+        // slider values are whole samples, so the loop points are sample accurate
+        requestedLoopStart = (juce::int64) loopRangeSlider.getMinValue();
+        requestedLoopEnd   = (juce::int64) loopRangeSlider.getMaxValue();
+        loopRangeDirty = true;
+        notify();
+    }
+
+    //==========================================================================
+    /*  Audio thread: takes the current engine and publishes it as the one in use, so the
+        loader never frees it while it plays. The re-check closes the window between reading
+        currentEngine and publishing engineInUse.
+
+        When the current engine has changed, the one that was playing is published as
+        engineFadingOut first, so it stays alive while crossfadeFromOutgoingEngine() fades
+        it out. A switch requested during a fade waits for the fade to finish.
+    */
+    StreamingLoopEngine* acquireEngine() noexcept
+    {
+        auto* previous = engineInUse.load();
+
+        if (fadeRemaining > 0 || currentEngine.load() == previous)
+            return previous;
+
+        engineFadingOut = previous;
+        fadeRemaining = previous != nullptr ? fadeLength : 0;
+
+        auto* engine = currentEngine.load();
+
+        for (;;)
+        {
+            engineInUse = engine;
+            auto* latest = currentEngine.load();
+
+            if (latest == engine)
+                break;
+
+            engine = latest;
+        }
+
+        // switched back before the block: nothing to fade, and one engine can't play twice
+        if (engine == previous)
+        {
+            engineFadingOut = nullptr;
+            fadeRemaining = 0;
+        }
+
+        return engine;
+    }
+
+    /*  Audio thread: mixes the outgoing engine under the block that was just rendered,
+        with linear ramps from old to new over fadeLength samples.
+    */
+    void crossfadeFromOutgoingEngine (const juce::AudioSourceChannelInfo& bufferToFill) noexcept
+    {
+        auto& buffer = *bufferToFill.buffer;
+        auto numSamples = juce::jmin (bufferToFill.numSamples, fadeRemaining);
+        auto startGain = (float) (fadeLength - fadeRemaining) / (float) fadeLength;
+        auto endGain = (float) (fadeLength - fadeRemaining + numSamples) / (float) fadeLength;
+
+        if (auto* outgoing = engineFadingOut.load())
+            outgoing->render (fadeBuffer, 0, numSamples);
+        else
+            fadeBuffer.clear (0, numSamples);
+
+        for (auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            buffer.applyGainRamp (channel, bufferToFill.startSample, numSamples, startGain, endGain);
+            buffer.addFromWithRamp (channel, bufferToFill.startSample,
+                                    fadeBuffer.getReadPointer (channel % fadeBuffer.getNumChannels()),
+                                    numSamples, 1.0f - startGain, 1.0f - endGain);
+        }
+
+        fadeRemaining -= numSamples;
+
+        if (fadeRemaining == 0)
+            engineFadingOut = nullptr;
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            checkForFileToOpen();
+            checkForLoopRangeChange();
+            checkForLoudness();
+            checkForEnginesToFree();
+            wait (500);
+        }
+    }
+
+    void checkForFileToOpen()
+    {
+        if (clearRequested.exchange (false))
+            currentEngine = nullptr;
+
+        juce::File file;
+
+        {
+            const juce::ScopedLock sl (requestLock);
+            std::swap (file, fileToOpen);
+        }
 
-            if (reader.get() != nullptr)
+        if (file == juce::File{})
+            return;
+
+        loudnessPending = normalise.load();
+        loudness->analyse (file);
+        loudnessFile = file;
+
+        // through the shared cache, so each pass over the loop after the first is a copy from memory
+        std::unique_ptr<juce::AudioFormatReader> reader (decodedCache->wrap (formatManager.createReaderFor (file), file)); // [2]
+
+        if (reader.get() == nullptr || reader->lengthInSamples <= 0)
+            return;
+
+        // the engine only ever holds two chunks of the file in memory, so any length works.
+        // it is built and prefilled here, then published with a single pointer store
+        auto lengthInSamples = reader->lengthInSamples;
+        auto* engine = engines.add (new StreamingLoopEngine (reader.release(), streamingThread));
+        engine->setNonRealtime (nonRealtime.load());
+        engine->prefill();
+
+        currentEngine = engine;
+
+        juce::Component::SafePointer<AudioLoopingComponent> safeThis (this);
+
+        juce::MessageManager::callAsync ([safeThis, lengthInSamples]
+        {
+            if (auto* comp = safeThis.getComponent())
             {
-                auto duration = (float) reader->lengthInSamples / reader->sampleRate;               // [3]
-
-                if (duration < 2)
-                {
-                    fileBuffer.setSize ((int) reader->numChannels, (int) reader->lengthInSamples);  // [4]
-                    reader->read (&fileBuffer,                                                      // [5]
-                                  0,                                                                //  [5.1]
-                                  (int) reader->lengthInSamples,                                    //  [5.2]
-                                  0,                                                                //  [5.3]
-                                  true,                                                             //  [5.4]
-                                  true);                                                            //  [5.5]
-                    position = 0;                                                                   // [6]
-                    setAudioChannels (0, (int) reader->numChannels);                                // [7]
-                }
-                else
-                {
-                    // handle the error that the file is 2 seconds or longer..
-                }
+                comp->loopRangeSlider.setRange (0.0, (double) lengthInSamples, 1.0);
+                comp->loopRangeSlider.setMinAndMaxValues (0.0, (double) lengthInSamples, juce::dontSendNotification);
+                comp->loopRangeSlider.setEnabled (true);
             }
         });
     }
 
-    void clearButtonClicked()
+    void checkForLoopRangeChange()
     {
-        shutdownAudio();
+        if (! loopRangeDirty.exchange (false))
+            return;
+
+        if (auto* engine = currentEngine.load())
+            engine->setLoopRange (requestedLoopStart.load(), requestedLoopEnd.load());
+    }
+
+    void checkForLoudness()
+    {
+        auto gain = 1.0f;
+
+        if (normalise.load() && loudnessFile != juce::File{})
+            gain = loudness->getNormalisationGain (loudnessFile);
+
+        normalisationGain = gain;
+
+        // files that can't be measured keep unity gain once the analyser has given up on them
+        if (loudnessPending.load() && (! normalise.load() || loudness->getResult (loudnessFile).has_value() || ! loudness->isBusy()))
+            loudnessPending = false;
+    }
+
+    void checkForEnginesToFree()
+    {
+        // an engine can go once it is neither current, playing nor fading out on the audio thread;
+        // deleting it here keeps the deallocation off the audio thread. engineInUse is read
+        // before engineFadingOut, the reverse of the order the audio thread stores them in
+        for (auto i = engines.size(); --i >= 0;)
+        {
+            auto* engine = engines.getUnchecked (i);
+
+            if (engine != currentEngine.load() && engine != engineInUse.load() && engine != engineFadingOut.load())
+                engines.remove (i);
+        }
     }
 
     //==========================================================================
     juce::TextButton openButton;
     juce::TextButton clearButton;
 	juce::Slider levelSlider; 
+    juce::Slider loopRangeSlider;
 
     std::unique_ptr<juce::FileChooser> chooser;
 
     juce::AudioFormatManager formatManager;
-    juce::AudioSampleBuffer fileBuffer;
+    juce::SharedResourcePointer<DecodedAudioCache> decodedCache;    // shared with the player when both live in one process
+    juce::TimeSliceThread streamingThread { "Loop streaming" };
+    juce::SharedResourcePointer<LoudnessAnalyser> loudness;         // measures each opened file on worker threads, shared with the player
+    juce::File loudnessFile;                                        // loader thread only
+
+    juce::OwnedArray<StreamingLoopEngine> engines;                  // loader thread only
+    std::atomic<StreamingLoopEngine*> currentEngine { nullptr };    // published to the audio thread
+    std::atomic<StreamingLoopEngine*> engineInUse { nullptr };      // set by the audio thread, the engine it plays
+    std::atomic<StreamingLoopEngine*> engineFadingOut { nullptr };  // set by the audio thread during a switch
+
+    static constexpr double engineFadeSeconds = 0.005;              // old to new engine, so opening or clearing never clicks
+    juce::AudioBuffer<float> fadeBuffer;                            // audio thread, sized in prepareToPlay()
+    int fadeLength = 0, fadeRemaining = 0;                          // audio thread
+
+    juce::CriticalSection requestLock;
+    juce::File fileToOpen;
+    std::atomic<bool> clearRequested { false }, loopRangeDirty { false }, nonRealtime { false }, normalise { true }, loudnessPending { false };
+    std::atomic<float> normalisationGain { 1.0f };
+    std::atomic<juce::int64> requestedLoopStart { 0 }, requestedLoopEnd { 0 };
 
-    int position;
 	float currentLevel = 0.0f, previousLevel = 0.0f;
 
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainContentComponent)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioLoopingComponent)
 
 };
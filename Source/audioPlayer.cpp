@@ -48,6 +48,7 @@ class Application: public juce:: JUCEApplication{
         };
         
         std::unique_ptr<MainWindow> mainWindow;
+        juce::SharedResourcePointer<StartupProfiler> startupProfiler; // first holder, so startup is timed from here
                             
     
     
@@ -62,8 +63,13 @@ class Application: public juce:: JUCEApplication{
             return "1.0.0";
         }
         
-        void initialise(const juce::String&) override{
-            mainWindow.reset( new MainWindow(getApplicationName(), new MainContentComponent,*this));
+        void initialise(const juce::String& commandLine) override{
+            // --fast-startup paints the window before the formats and the audio device are set up
+            auto deferStartup = commandLine.contains("--fast-startup");
+            startupProfiler->mark("initialise");
+            
+            mainWindow.reset( new MainWindow(getApplicationName(), new MainContentComponent(true, deferStartup),*this));
+            startupProfiler->mark("window");
         }
         
         void shutdown() override {
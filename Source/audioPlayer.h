@@ -11,6 +11,21 @@
 #pragma once
 #include <JuceHeader.h>
 #include <iostream>
+#include "readAheadSource.h"
+#include "mappedWavReader.h"
+#include "playlistSource.h"
+#include "thumbnailDiskCache.h"
+#include "waveformPyramid.h"
+#include "timecodeDisplay.h"
+#include "parametricEq.h"
+#include "callbackTelemetry.h"
+#include "decodedAudioCache.h"
+#include "mediaLibrary.h"
+#include "spectrumAnalyser.h"
+#include "loudnessAnalyser.h"
+#include "transportCommandQueue.h"
+#include "stemMixer.h"
+#include "startupProfiler.h"
 
 class MainContentComponent: public juce::ChangeListener, public juce::AudioAppComponent, private juce::Timer
 { 
@@ -29,49 +44,173 @@ class MainContentComponent: public juce::ChangeListener, public juce::AudioAppCo
         juce::TextButton openButton_;
         juce::TextButton playButton_;
         juce::TextButton stopButton_;
-        juce::Label currentPositionLabel_;
+        TimecodeDisplay currentPositionLabel_ {20.0f}; // formats and draws the time without allocating per tick
         
         //length of audio file
         int lengthInSecond_;
         
         // Declare thumbnail
+        // the cache is declared first because thumbnail_ is constructed with a reference to it.
+        // finished thumbnails are kept on disk, so known files show their waveform immediately
+        PersistentThumbnailCache thumbnailCache_;
         juce::AudioThumbnail thumbnail_;
-        juce::AudioThumbnailCache thumbnailCache_;
         
         std::unique_ptr<juce::FileChooser> chooser; // pointer control the file
     
         juce::AudioFormatManager formatManager; // variable to register a audio format
-        std::unique_ptr<juce::AudioFormatReaderSource> readerSource; // pointer of AudioFormatReaderSource class to check if audio playback pass to
-        juce::AudioTransportSource transportSource; // variable to listen to the state's change
+        WaveformPyramid waveformPyramid_ {formatManager, juce::SystemStats::getNumCpus(), PersistentThumbnailCache::getDefaultDirectory()}; // multi-resolution min/max/RMS summary, built on all cores and cached beside the thumbnails
+        MediaLibrary library_ {formatManager}; // files under the library folders with their header details, indexed on disk
+        MediaLibraryList libraryList_ {library_}; // shown over the waveform from the library button
+        // measured in the background and cached on disk, one table for the whole process;
+        // declared before playlist_, whose loader asks it for gains
+        juce::SharedResourcePointer<LoudnessAnalyser> loudness_;
+        std::atomic<bool> normalise_ {true};
+        juce::ToggleButton normaliseButton_ {"Normalise loudness"};
+        juce::TextButton libraryButton_;
+        double visibleStart_ = 0.0, visibleEnd_ = 0.0; // zoomed part of the file in seconds, an empty range shows everything
+        juce::Image waveformImage_; // waveform rendered once, redrawn only when the thumbnail, size or zoom changes
+        bool waveformDirty_ = true;
+        int playheadX_ = -1; // x of the playhead drawn last, -1 when it is outside the visible range
+        juce::TimeSliceThread readAheadThread_ {"Audio read-ahead"}; // background thread that reads the file ahead of the playhead
+        std::atomic<bool> useMemoryMapping_ {true}; // play WAV files through a memory-mapped reader
+        juce::SharedResourcePointer<DecodedAudioCache> decodedCache_; // decoded chunks shared with every other reader in the process
+        // queue of files; the next one is opened, buffered and resampled in the background so tracks follow without a gap.
+        // the seek index scans whole files with plain readers, which leave the decoded cache to the playing tracks
+        GaplessPlaylistSource playlist_ {[this] (const juce::File& file) { return openReader_(file); }, readAheadThread_,
+                                         [this] (const juce::File& file) { return formatManager.createReaderFor(file); }};
+        int displayedTrackIndex_ = -1; // track whose waveform is on screen
+        // play/pause/stop/seek go to the audio thread through a FIFO; what it did comes back through another
+        QueuedTransportSource transportSource {playlist_};
+        // stems: several files at once in sync, with a transport of their own; the callback plays one of the two
+        StemMixerSource stems_ {readAheadThread_};
+        QueuedTransportSource stemTransport_ {stems_};
+        std::atomic<bool> stemMode_ {false};
+        StemMixerPanel stemPanel_ {stems_}; // gain, pan and mute per stem, shown over the waveform
+        juce::TextButton stemsButton_;
+        juce::ToggleButton loopButton_ {"Loop track"};
+        ParametricEq equaliser_; // eight-band EQ applied to whatever the transport produces
+        juce::OwnedArray<juce::Slider> eqSliders_; // one gain slider per EQ band
+        juce::OwnedArray<juce::Label> eqLabels_;
+        CallbackTelemetry telemetry_; // per-callback timing, written by the audio thread and collected in timerCallback()
+        juce::Label telemetryLabel_;
+        juce::TextButton exportTelemetryButton_;
+        juce::ComboBox resamplingQualityBox_; // resampler quality for files opened from now on
+        SpectrumAnalyser analyser_; // FFTs of the output on its own thread, fed from the callback through a FIFO
+        SpectrumDisplay spectrumDisplay_ {analyser_};
+        int timerTicks_ = 0;
+        juce::SharedResourcePointer<StartupProfiler> startupProfiler_; // the clock was started by the application
+        bool opensAudioDevice_ = true;
+        bool formatsPending_ = true, devicePending_ = false; // deferred startup: done after the first frame
+        bool firstFrameShown_ = false, startupReported_ = false;
         TransportState state_; // enum of state
         
         void timerCallback() override{
-            if(transportSource.isPlaying()) {
-                juce::RelativeTime position(transportSource.getCurrentPosition());
-                auto minutes = ((int) position.inMinutes()) % 60;
-                auto seconds = ((int) position.inSeconds()) % 60;
-                auto millis = ((int) position.inMilliseconds()) % 1000;
-                auto full_minutes = ((int) lengthInSecond_ / 60);
-                auto full_seconds = ((int) lengthInSecond_ - (full_minutes * 60));
-                auto full_millis = ((int) 0);
-                auto positionString = juce::String::formatted("%02d:%02d:%03d/%02d:%02d:%03d",minutes,seconds,millis,full_minutes,full_seconds,full_millis);
-                
-                currentPositionLabel_.setText(positionString,juce::dontSendNotification);
+            /*
+            * only the strips around the old and new playhead are repainted, the waveform
+            * itself comes from waveformImage_. the display repaints itself when its text changes.
+            */
+            // drain the callback timings every tick so the FIFO never fills; the text is refreshed twice a second
+            telemetry_.collect();
+            collectTransportEvents_();
+            
+            if(++timerTicks_ % 25 == 0)
+                updateTelemetryLabel_();
+            
+            if(! startupReported_ && startupProfiler_->getFirstAudioMs() >= 0.0){
+                startupReported_ = true;
+                juce::Logger::writeToLog(startupProfiler_->getReport());
+            }
+            
+            spectrumDisplay_.refresh();
+            
+            // the playlist moved on to its next track: show that track's waveform
+            auto trackIndex = playlist_.getCurrentTrackIndex();
+            
+            if(! stemMode_.load() && trackIndex >= 0 && trackIndex != displayedTrackIndex_){
+                displayedTrackIndex_ = trackIndex;
+                showTrack_(playlist_.getFile(trackIndex));
             }
-            else {
-                currentPositionLabel_.setText("Stopped",juce::dontSendNotification);
+            
+            auto& transport = activeTransport_();
+            lengthInSecond_ = (int) transport.getLengthInSeconds();
+            
+            if(transport.isPlaying())
+                currentPositionLabel_.setTime(transport.getCurrentPosition(), (double) lengthInSecond_);
+            else
+                currentPositionLabel_.setMessage("Stopped");
+            
+            auto newPlayheadX = getPlayheadX_();
+            
+            if(newPlayheadX != playheadX_){
+                repaintPlayhead_(playheadX_);
+                repaintPlayhead_(newPlayheadX);
+                playheadX_ = newPlayheadX;
+            }
+        }
+        
+        int getPlayheadX_() const{
+            auto thumbnailBounds = getThumbnailBounds_();
+            auto visible = getVisibleRange_();
+            auto audioPosition = activeTransport_().getCurrentPosition();
+            
+            if(thumbnail_.getNumChannels() == 0 || visible.isEmpty() || ! visible.contains(audioPosition))
+                return -1;
+            
+            return thumbnailBounds.getX() + juce::roundToInt((audioPosition - visible.getStart()) / visible.getLength() * thumbnailBounds.getWidth());
+        }
+        
+        void repaintPlayhead_(int x){
+            if(x >= 0){
+                auto thumbnailBounds = getThumbnailBounds_();
+                repaint(x - 2, thumbnailBounds.getY(), 4, thumbnailBounds.getHeight());
             }
+        }
+        
+        void updateTelemetryLabel_(){
+            const auto& summary = telemetry_.getSummary();
+            auto cache = decodedCache_->getStats();
+            auto analyser = analyser_.getCost();
             
-            repaint();
+            telemetryLabel_.setText("block " + juce::String(summary.lastBlockSize) + " @ " + juce::String(summary.sampleRate, 0) + " Hz\n"
+                                    + "load " + juce::String(summary.averageLoad * 100.0, 1) + "% avg, "
+                                    + juce::String(summary.worstLoad * 100.0, 1) + "% worst\n"
+                                    + "worst " + juce::String(summary.worstMs, 3) + " ms, "
+                                    + juce::String(summary.deadlineMisses) + " missed deadlines\n"
+                                    + juce::String(summary.callbacks) + " callbacks, " + juce::String(summary.blockSizeChanges) + " size changes\n"
+                                    + "cache " + juce::String(cache.getHitRate() * 100.0, 1) + "% hits, "
+                                    + juce::String((double) cache.bytesUsed / (1024.0 * 1024.0), 1) + " MB, "
+                                    + "analyser " + juce::String(analyser.averageUs, 2) + " us/callback",
+                                    juce::dontSendNotification);
+        }
+        
+        void exportTelemetryButtonClicked_(){
+            chooser = std::make_unique<juce::FileChooser> ("Save callback timings as CSV ...", juce::File{}, "*.csv");
+            auto chooserFlags = juce::FileBrowserComponent::saveMode |
+                                juce::FileBrowserComponent::canSelectFiles |
+                                juce::FileBrowserComponent::warnAboutOverwriting;
+            
+            chooser->launchAsync(chooserFlags, [this] (const juce::FileChooser& filechooser){
+                auto file = filechooser.getResult();
+                
+                if(file != juce::File{}){
+                    telemetry_.collect();
+                    telemetry_.exportCsv(file.withFileExtension("csv"));
+                }
+            });
+        }
+        
+        void invalidateWaveform_(){
+            waveformDirty_ = true;
+            repaint(getThumbnailBounds_());
         }
         
         
         void changeState_(TransportState newState) {
             /*
-            * At Stopped state, disable stopButton, enable playButton, reset transportSource position back to the beginning of the file
-            * At Stating state, playButton is disabled as the user has already push playing, the AudioTransportSource object also start playing
-            * At Playing state, stopButton is able activate, this state happen when the AudioTransportSource object report a change via changeListenerCallback() 
-            * At Stopping state, AudioTransportSource object stop playing audio.
+            * At Stopped state, disable stopButton, enable playButton; the stop command has already rewound to the beginning of the file
+            * At Stating state, playButton is disabled as the user has already push playing, a play command is sent to the audio thread
+            * At Playing state, stopButton is able activate, this state happen when the audio thread confirms the start (see transportEventReceived_())
+            * At Stopping state, a stop command is sent; it fades out and rewinds before it is confirmed.
             *
             */
             if(state_ != newState){
@@ -82,10 +221,9 @@ class MainContentComponent: public juce::ChangeListener, public juce::AudioAppCo
                         stopButton_.setEnabled(false);
                         stopButton_.setButtonText("Stop");
                         playButton_.setButtonText("Start");
-                        transportSource.setPosition(0.0);
                         break;
                     case Starting:
-                        transportSource.start();
+                        activeTransport_().play();
                         break;
                     case Playing:
                         stopButton_.setEnabled(true);
@@ -93,10 +231,10 @@ class MainContentComponent: public juce::ChangeListener, public juce::AudioAppCo
                         playButton_.setButtonText("Pause");
                         break;
                     case Stopping:
-                        transportSource.stop();
+                        activeTransport_().stop();
                         break;
                     case Pausing:
-                        transportSource.stop();
+                        activeTransport_().pause();
                         break;
                     case Paused:
                         playButton_.setButtonText("Resume");
@@ -114,40 +252,102 @@ class MainContentComponent: public juce::ChangeListener, public juce::AudioAppCo
         */
         
         void openButtonClicked_(){
-            chooser = std::make_unique<juce::FileChooser> ("Select a Wave file to play ...", juce::File{},"*.wav");
+            // every format registered in formatManager (WAV, AIFF, FLAC, Ogg Vorbis...)
+            chooser = std::make_unique<juce::FileChooser> ("Select audio files to play ...", juce::File{}, formatManager.getWildcardForAllFormats());
             //openMode: user can choose an existing file with attention
             //canSelecFiles: user can select file
+            //canSelectMultipleItems: the selected files are queued and played back to back
             auto chooserFlags = juce::FileBrowserComponent::openMode |
-                                juce::FileBrowserComponent::canSelectFiles; 
+                                juce::FileBrowserComponent::canSelectFiles |
+                                juce::FileBrowserComponent::canSelectMultipleItems;
             // pop up chooser object
             chooser->launchAsync(chooserFlags, [this] (const juce::FileChooser& filechooser){
-                auto file = filechooser.getResult();
+                auto files = filechooser.getResults();
                 // if the audio is selected sucessfully at external folder
-                if(file != juce::File{}){ 
-                    // create audio format for the selected file
-                    // formatManager.createRenderFor(file) will return nullptr if the file is not the format
-                    // that AudioFormatManager can manage.
-                    auto* reader = formatManager.createReaderFor(file);                  
-                    if(reader != nullptr){
-                        // create a new object of AudioFormatReaderSource to handle the AudioFormatReader object
-                        // and delete AudioFormatReader if no logner needed.
-                        auto newSource = std::make_unique<juce::AudioFormatReaderSource> (reader,true);
-                        //AudioFormatReaderSource object connect with AudioTransportSource that begin used in getNextAudioBlock()
-                        //
-                        transportSource.setSource(newSource.get(),0,nullptr,reader->sampleRate);
-                        playButton_.setEnabled(true);
-                        thumbnail_.setSource (new juce::FileInputSource (file));
-                        // Since AudioTransportSource now be our newlly allocated AudioFormatReaderSource object.
-                        // we can save the AudioFormatReaderSource object in our readerSource member.
-                        // To do this, we must transfer the ownership from newSource by std::make_unique.release()
-                        readerSource.reset(newSource.release());
-                        lengthInSecond_ = reader->lengthInSamples / reader->sampleRate;
+                if(! files.isEmpty())
+                    loadFiles(files);
+            });
+        }
+        
+        void stemsButtonClicked_(){
+            juce::PopupMenu menu;
+            menu.addItem(1, "Open stems ...");
+            menu.addItem(2, stemPanel_.isVisible() ? "Hide mixer" : "Show mixer", stems_.getNumTracks() > 0);
+            
+            menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&stemsButton_), [this] (int result){
+                if(result == 1){
+                    chooser = std::make_unique<juce::FileChooser> ("Select the stems to play together ...", juce::File{}, formatManager.getWildcardForAllFormats());
+                    
+                    chooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles | juce::FileBrowserComponent::canSelectMultipleItems,
+                                         [this] (const juce::FileChooser& filechooser){
+                        auto files = filechooser.getResults();
                         
-                    }
+                        if(! files.isEmpty()){
+                            loadStems(files);
+                            libraryList_.setVisible(false);
+                            stemPanel_.setVisible(true);
+                        }
+                    });
+                }
+                else if(result == 2){
+                    stemPanel_.setVisible(! stemPanel_.isVisible());
                 }
             });
         }
         
+        void libraryButtonClicked_(){
+            juce::PopupMenu menu;
+            menu.addItem(1, libraryList_.isVisible() ? "Hide library" : "Show library");
+            menu.addItem(2, "Add folder ...");
+            menu.addItem(3, library_.isScanning() ? "Scanning ..." : "Rescan", ! library_.isScanning() && ! library_.getFolders().isEmpty());
+            
+            menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&libraryButton_), [this] (int result){
+                if(result == 1){
+                    libraryList_.setVisible(! libraryList_.isVisible());
+                }
+                else if(result == 2){
+                    chooser = std::make_unique<juce::FileChooser> ("Add a folder to the library ...", juce::File{});
+                    
+                    chooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectDirectories,
+                                         [this] (const juce::FileChooser& filechooser){
+                        auto folder = filechooser.getResult();
+                        
+                        if(folder.isDirectory()){
+                            library_.addFolder(folder);
+                            libraryList_.setVisible(true);
+                        }
+                    });
+                }
+                else if(result == 3){
+                    library_.rescan();
+                }
+            });
+        }
+        
+        void showTrack_(const juce::File& file){
+            thumbnail_.setSource (new KeyedFileInputSource (file));
+            // the thumbnail is shown until the pyramid has been built
+            waveformPyramid_.build(file);
+            visibleStart_ = visibleEnd_ = 0.0;
+            invalidateWaveform_();
+        }
+
+        juce::AudioFormatReader* openReader_(const juce::File& file){
+            /*
+            * uncompressed WAV files are memory mapped when possible, so samples are converted
+            * straight from the mapping. anything else, or a mapping that fails, falls back to
+            * the buffered stream reader from formatManager, read through the decoded audio
+            * cache so a file played again isn't decoded again. mapped files skip the cache,
+            * their pages already stay in memory.
+            */
+            if(useMemoryMapping_){
+                if(auto mappedReader = createMappedWavReader(file))
+                    return mappedReader.release();
+            }
+
+            return decodedCache_->wrap(formatManager.createReaderFor(file), file);
+        }
+        
         void playButtonClicked_(){
             if ((state_ == Stopped) || (state_ ==Paused))   
                 changeState_(Starting);
@@ -157,10 +357,106 @@ class MainContentComponent: public juce::ChangeListener, public juce::AudioAppCo
         }
         
         void stopButtonClicked_(){
-            if(state_ == Paused)
+            // also from Paused: the stop command rewinds, and the audio thread confirms it
+            changeState_(Stopping);
+        }
+        
+        QueuedTransportSource& activeTransport_(){
+            return stemMode_.load() ? stemTransport_ : transportSource;
+        }
+        
+        const QueuedTransportSource& activeTransport_() const{
+            return stemMode_.load() ? stemTransport_ : transportSource;
+        }
+        
+        void collectTransportEvents_(){
+            // both are drained so neither FIFO fills; only the transport being heard drives the buttons
+            for(auto* transport : {&transportSource, &stemTransport_}){
+                auto isActive = transport == &activeTransport_();
+                
+                transport->collectEvents([this, isActive] (const QueuedTransportSource::Event& event){
+                    if(isActive)
+                        transportEventReceived_(event);
+                });
+            }
+        }
+        
+        void switchTransport_(bool toStems){
+            /*
+            * the transport left behind is told to stop; it stops getting blocks at once, so the
+            * stop (and its rewind) is applied silently the next time it is heard
+            */
+            if(toStems != stemMode_.load()){
+                activeTransport_().stop();
+                stemMode_ = toStems;
                 changeState_(Stopped);
-            else
-                changeState_(Stopping);
+                
+                // the loop button is one setting for both transports
+                activeTransport_().setLooping(loopButton_.getToggleState());
+            }
+        }
+        
+        void initialiseFormats_(){
+            /*
+            * everything that needs the formats: the library index and the read-ahead thread.
+            * the buttons that open files wait for it
+            */
+            if(! formatsPending_)
+                return;
+            
+            formatsPending_ = false;
+            formatManager.registerBasicFormats();// register a basic format method()
+            startupProfiler_->mark("formats");
+            
+            // the index from the last session is shown at once, the rescan only opens files that changed.
+            // hosts without a device (the offline bench) leave the user's library alone
+            if(opensAudioDevice_ && library_.loadIndex())
+                library_.rescan();
+            startupProfiler_->mark("library index");
+            
+            readAheadThread_.startThread(juce::Thread::Priority::high); // disk reads happen here instead of in the audio callback
+            
+            openButton_.setEnabled(true);
+            libraryButton_.setEnabled(true);
+            stemsButton_.setEnabled(true);
+        }
+        
+        void openAudioDevice_(){
+            // probing the devices is the slow part of startup
+            if(! devicePending_)
+                return;
+            
+            devicePending_ = false;
+            // the playlist already resamples every track to the device rate, so the transport plays it as it is
+            setAudioChannels (0, 2);
+            startupProfiler_->mark("audio device");
+        }
+        
+        void transportEventReceived_(const QueuedTransportSource::Event& event){
+            /*
+            * the state follows what the audio thread has done, in the order it did it
+            */
+            switch(event.type){
+                case QueuedTransportSource::Event::started:
+                    changeState_(Playing);
+                    break;
+                case QueuedTransportSource::Event::paused:
+                    changeState_(Paused);
+                    break;
+                case QueuedTransportSource::Event::stopped:
+                    changeState_(Stopped);
+                    break;
+                case QueuedTransportSource::Event::reachedEnd:
+                    // the queue played out: rewind it, like a stop
+                    activeTransport_().seek(0);
+                    changeState_(Stopped);
+                    break;
+                case QueuedTransportSource::Event::loopingChanged:
+                    loopButton_.setToggleState(event.looping, juce::dontSendNotification);
+                    break;
+                case QueuedTransportSource::Event::seeked:
+                    break;
+            }
         }
                 
             
@@ -170,7 +466,19 @@ class MainContentComponent: public juce::ChangeListener, public juce::AudioAppCo
         
     
     public:
-        MainContentComponent(): state_(Stopped),thumbnailCache_(5),thumbnail_(512,formatManager,thumbnailCache_){
+        /*
+        * pass false to build the player without opening an audio device, for hosts that
+        * call prepareToPlay()/getNextAudioBlock() themselves (see offlineRender.cpp).
+        *
+        * with deferStartup the constructor only builds the UI. the formats, the library
+        * index and the audio device follow once the first frame is on screen, each from its
+        * own message, and the buttons that open files are enabled when the formats are in.
+        */
+        explicit MainContentComponent(bool openAudioDevice = true, bool deferStartup = false): state_(Stopped),thumbnailCache_(PersistentThumbnailCache::getDefaultDirectory(), 64 * 1024 * 1024),thumbnail_(512,formatManager,thumbnailCache_){
+            startupProfiler_->mark("components");
+            opensAudioDevice_ = openAudioDevice;
+            devicePending_ = openAudioDevice;
+            
             // initialization of buttons
             juce::Component::addAndMakeVisible(&openButton_);
             openButton_.setButtonText("Choose song");
@@ -190,31 +498,304 @@ class MainContentComponent: public juce::ChangeListener, public juce::AudioAppCo
             stopButton_.setEnabled(false);
             
             juce::Component::addAndMakeVisible(&currentPositionLabel_);
-            currentPositionLabel_.setText("Stopped",juce::dontSendNotification);
-			currentPositionLabel_.setFont(juce::Font(20.0f));
+            currentPositionLabel_.setMessage("Stopped");
+            
+            for(auto band = 0; band < ParametricEq::numBands; ++band){
+                auto* slider = eqSliders_.add(new juce::Slider(juce::Slider::LinearVertical, juce::Slider::TextBoxBelow));
+                slider->setRange(-12.0, 12.0, 0.1);
+                slider->setValue(0.0, juce::dontSendNotification);
+                slider->setTextBoxStyle(juce::Slider::TextBoxBelow, false, 44, 16);
+                slider->setDoubleClickReturnValue(true, 0.0);
+                // only an atomic is written here, the audio thread smooths it into new coefficients
+                slider->onValueChange = [this, band, slider]{ equaliser_.setBandGain(band, (float) slider->getValue()); };
+                juce::Component::addAndMakeVisible(slider);
+                
+                auto* label = eqLabels_.add(new juce::Label({}, ParametricEq::getBandName(band)));
+                label->setJustificationType(juce::Justification::centred);
+                juce::Component::addAndMakeVisible(label);
+            }
             
+            juce::Component::addAndMakeVisible(&telemetryLabel_);
+            telemetryLabel_.setJustificationType(juce::Justification::topLeft);
+            telemetryLabel_.setFont(juce::Font(13.0f));
             
+            juce::Component::addAndMakeVisible(&exportTelemetryButton_);
+            exportTelemetryButton_.setButtonText("Export timings");
+            exportTelemetryButton_.onClick = [this]{exportTelemetryButtonClicked_();};
             
-            formatManager.registerBasicFormats();// register a basic format method()
-            transportSource.addChangeListener(this); // add a listener so that we can respond to changes in its state
+            juce::Component::addAndMakeVisible(&resamplingQualityBox_);
+            resamplingQualityBox_.setTooltip("Resampling quality for files whose rate differs from the device");
             
-            setAudioChannels (0, 2);
+            for(auto quality : {PolyphaseResamplingSource::Quality::draft, PolyphaseResamplingSource::Quality::standard, PolyphaseResamplingSource::Quality::mastering})
+                resamplingQualityBox_.addItem(juce::String("Resampling: ") + PolyphaseResamplingSource::getQualityName(quality), (int) quality + 1);
+            
+            resamplingQualityBox_.setSelectedId((int) playlist_.getResamplingQuality() + 1, juce::dontSendNotification);
+            resamplingQualityBox_.onChange = [this]{
+                auto quality = (PolyphaseResamplingSource::Quality) (resamplingQualityBox_.getSelectedId() - 1);
+                playlist_.setResamplingQuality(quality);
+                stems_.setResamplingQuality(quality);
+            };
+            
+            juce::Component::addAndMakeVisible(&spectrumDisplay_);
+            
+            juce::Component::addAndMakeVisible(&loopButton_);
+            loopButton_.setTooltip("Repeat the current track");
+            loopButton_.onClick = [this]{activeTransport_().setLooping(loopButton_.getToggleState());};
+            
+            juce::Component::addAndMakeVisible(&normaliseButton_);
+            normaliseButton_.setTooltip("Play every file at the same loudness (EBU R128, measured in the background)");
+            normaliseButton_.setToggleState(normalise_.load(), juce::dontSendNotification);
+            normaliseButton_.onClick = [this]{setLoudnessNormalisation(normaliseButton_.getToggleState());};
+            
+            juce::Component::addAndMakeVisible(&libraryButton_);
+            libraryButton_.setButtonText("Library");
+            libraryButton_.onClick = [this]{libraryButtonClicked_();};
+            
+            juce::Component::addAndMakeVisible(&stemsButton_);
+            stemsButton_.setButtonText("Stems");
+            stemsButton_.onClick = [this]{stemsButtonClicked_();};
+            
+            juce::Component::addChildComponent(&stemPanel_);
+            
+            juce::Component::addChildComponent(&libraryList_);
+            libraryList_.onFilesChosen = [this] (const juce::Array<juce::File>& files){
+                libraryList_.setVisible(false);
+                loadFiles(files);
+            };
             
             //thumbnail
             thumbnail_.addChangeListener(this);
+            waveformPyramid_.addChangeListener(this);
+            stems_.addChangeListener(this);
+            
+            // a file measured after its track was opened ramps to its gain while playing
+            loudness_->addChangeListener(this);
+            playlist_.setGainProvider([this] (const juce::File& file){
+                return normalise_.load() ? loudness_->getNormalisationGain(file) : 1.0f;
+            });
             startTimer (20);
             
+            if(deferStartup){
+                openButton_.setEnabled(false);
+                libraryButton_.setEnabled(false);
+                stemsButton_.setEnabled(false);
+            }
+            else{
+                completeStartup();
+            }
+            
         }
         
         ~MainContentComponent() override{
+            // the analyser is shared and may outlive this component
+            loudness_->removeChangeListener(this);
             shutdownAudio();
         }
         
+        /*
+        * does whatever deferStartup left for later, at once. the message loop calls it after
+        * the first frame; hosts without one (the bench) call it themselves
+        */
+        void completeStartup(){
+            initialiseFormats_();
+            openAudioDevice_();
+        }
+        
+        /*
+        * depth of the read-ahead buffer used for files opened after this call.
+        * larger values ride out slower disks at the cost of memory.
+        */
+        void setReadAheadMs(int milliseconds){
+            playlist_.setReadAheadMs(milliseconds);
+            stems_.setReadAheadMs(milliseconds);
+        }
+        
+        /*
+        * overlap between the end of one track and the start of the next, 0 for a plain gapless switch
+        */
+        void setCrossfadeMs(int milliseconds){
+            playlist_.setCrossfadeMs(milliseconds);
+        }
+        
+        /*
+        * choose between the memory-mapped WAV path and the buffered stream reader
+        * for files opened after this call.
+        */
+        void setUseMemoryMapping(bool shouldMap){
+            useMemoryMapping_ = shouldMap;
+        }
+        
+        ReadAheadAudioSource::Stats getReadAheadStats() const{
+            return playlist_.getReadAheadStats();
+        }
+        
+        /*
+        * the same steps as the buttons, for hosts without a mouse
+        */
+        void loadFiles(const juce::Array<juce::File>& files){
+            initialiseFormats_();
+            
+            // the playlist opens the readers on its own loader thread; files that
+            // AudioFormatManager can't read are skipped there
+            switchTransport_(false);
+            stemPanel_.setVisible(false);
+            playlist_.setPlaylist(files);
+            
+            if(normalise_.load())
+                for(const auto& file : files)
+                    loudness_->analyse(file);
+            
+            playButton_.setEnabled(true);
+            displayedTrackIndex_ = 0;
+            showTrack_(files.getFirst());
+        }
+        
+        /*
+        * plays `files` together in sync through the stem mixer instead of one after another.
+        * the mixer opens and buffers them on its loader thread; the panel and the play button
+        * follow its change message. the waveform shows the first of them
+        */
+        void loadStems(const juce::Array<juce::File>& files){
+            initialiseFormats_();
+            switchTransport_(true);
+            playlist_.setPlaylist({});
+            playButton_.setEnabled(false);
+            
+            stems_.setFiles(files, [this] (const juce::File& file) { return openReader_(file); });
+            showTrack_(files.getFirst());
+        }
+        
+        /* true until the stems from loadStems() can be played */
+        bool isStemLoading() const{
+            return stems_.isLoading();
+        }
+        
+        StemMixerSource& getStemMixer(){
+            return stems_;
+        }
+        
+        void startPlayback(){
+            // hosts without a message loop never get the timer, so the state is brought up to date here
+            collectTransportEvents_();
+            
+            if((state_ == Stopped) || (state_ == Paused))
+                changeState_(Starting);
+        }
+        
+        bool isPlaying() const{
+            return activeTransport_().isPlaying();
+        }
+        
+        /* true once the thumbnail and the pyramid of the shown track are done, or the pyramid gave up */
+        bool isWaveformComplete() const{
+            return thumbnail_.isFullyLoaded() && (waveformPyramid_.isComplete() || waveformPyramid_.hasFailed());
+        }
+        
+        void setEqBandGain(int band, float gainDb){
+            if(auto* slider = eqSliders_[band])
+                slider->setValue(gainDb, juce::sendNotificationSync); // goes through onValueChange like a slider drag
+        }
+        
+        /*
+        * offline rendering: the playlist waits for its loader and read-ahead buffers
+        * instead of playing silence, so the output doesn't depend on disk speed
+        */
+        void setNonRealtime(bool isNonRealtime){
+            playlist_.setNonRealtime(isNonRealtime);
+            stems_.setNonRealtime(isNonRealtime);
+        }
+        
+        /* quality of the resampler for files loaded after this call */
+        void setResamplingQuality(PolyphaseResamplingSource::Quality quality){
+            resamplingQualityBox_.setSelectedId((int) quality + 1, juce::sendNotificationSync);
+        }
+        
+        /*
+        * moves the playhead to `seconds` in the current track. if the track has a decoded seek
+        * point within `snapSeconds`, the seek goes there instead and audio restarts in the next block.
+        */
+        void seekTo(double seconds, double snapSeconds){
+            // stems have no seek points, they all move to the exact sample together
+            if(stemMode_.load()){
+                stemTransport_.setPosition(juce::jmax(0.0, seconds));
+            }
+            else{
+                playlist_.noteSeekRequested();
+                transportSource.setPosition(playlist_.snapToSeekPoint(juce::jmax(0.0, seconds), snapSeconds));
+            }
+        }
+        
+        /* seconds between the seek points of the current track, 0 while it has none */
+        double getSeekPointSpacing() const{
+            return playlist_.getSeekPointSpacing();
+        }
+        
+        double getLengthInSeconds() const{
+            return activeTransport_().getLengthInSeconds();
+        }
+        
+        bool isSeekIndexComplete() const{
+            return playlist_.isSeekIndexComplete();
+        }
+        
+        /*
+        * plays every track at LoudnessAnalyser::targetLufs once it has been measured. turning it
+        * on measures the queued files that aren't known yet; tracks already playing ramp to the new gain.
+        */
+        void setLoudnessNormalisation(bool shouldNormalise){
+            normalise_ = shouldNormalise;
+            normaliseButton_.setToggleState(shouldNormalise, juce::dontSendNotification);
+            
+            if(shouldNormalise)
+                for(auto i = 0; i < playlist_.getNumFiles(); ++i)
+                    loudness_->analyse(playlist_.getFile(i));
+            
+            playlist_.refreshGains();
+        }
+        
+        bool isLoudnessAnalysisComplete() const{
+            return ! loudness_->isBusy();
+        }
+        
+        /* the bench turns the analyser off to measure what it adds to the callback */
+        void setAnalyserEnabled(bool shouldBeEnabled){
+            analyser_.setEnabled(shouldBeEnabled);
+        }
+        
+        SpectrumAnalyser::Cost getAnalyserCost() const{
+            return analyser_.getCost();
+        }
+        
+        DecodedAudioCache& getDecodedCache(){
+            return *decodedCache_;
+        }
+        
+        juce::Array<GaplessPlaylistSource::SeekLatency> getSeekLatencyStats(){
+            return playlist_.getSeekLatencyStats();
+        }
+        
         void resized() override{
+            invalidateWaveform_();
             openButton_.setBounds(10,getHeight()-100,70,70);
             playButton_.setBounds(90,getHeight()-100,70,70);
             stopButton_.setBounds(170,getHeight()-100,70,70);
             currentPositionLabel_.setBounds(260,getHeight()-70,170,30);
+            resamplingQualityBox_.setBounds(260,getHeight()-110,170,24);
+            libraryButton_.setBounds(260,getHeight()-150,170,30);
+            normaliseButton_.setBounds(10,getHeight()-140,240,24);
+            loopButton_.setBounds(10,getHeight()-165,240,24);
+            libraryList_.setBounds(getThumbnailBounds_());
+            stemsButton_.setBounds(260,getHeight()-185,170,30);
+            stemPanel_.setBounds(getThumbnailBounds_());
+            spectrumDisplay_.setBounds(getWidth()-250,10,240,getHeight()-200);
+            
+            for(auto band = 0; band < eqSliders_.size(); ++band){
+                eqLabels_[band]->setBounds(450 + band * 50,getHeight()-180,50,20);
+                eqSliders_[band]->setBounds(450 + band * 50,getHeight()-160,50,150);
+            }
+            
+            telemetryLabel_.setBounds(870,getHeight()-180,getWidth()-880,85);
+            exportTelemetryButton_.setBounds(870,getHeight()-90,120,30);
         }
         
         
@@ -228,28 +809,38 @@ class MainContentComponent: public juce::ChangeListener, public juce::AudioAppCo
         void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override {
             /* pass the prepareToPlay() callback funtion to any AudioSource object
             */
+            telemetry_.prepare(samplesPerBlockExpected, sampleRate);
             transportSource.prepareToPlay(samplesPerBlockExpected, sampleRate);
+            stemTransport_.prepareToPlay(samplesPerBlockExpected, sampleRate);
+            equaliser_.prepare(sampleRate, samplesPerBlockExpected, 2);
+            analyser_.prepare(sampleRate);
         }
         
         void releaseResources() override{
             /* pass th releaseResource() callback function to AudioSource object
             */
             transportSource.releaseResources();
+            stemTransport_.releaseResources();
+            equaliser_.reset();
         }
         
         void getNextAudioBlock(const juce::AudioSourceChannelInfo& bufferToFill) override{
         /*
-        * check if input has audio playback by checking readerSource pointer
-        * if not then clear the buffer 
-        * else recursively call gertNextAudioBlock().
+        * the transport clears the buffer while it is stopped or the playlist is empty,
+        * otherwise it pulls the next block from the playlist (or the stem mixer, whichever
+        * was loaded last). the EQ then runs in place,
+        * and is skipped while every band is flat. the analyser only copies the result into
+        * its FIFO, the FFTs run on its own thread.
         *
+        * the whole callback is timed; the measurement only reads the clock and writes one
+        * record into a lock-free FIFO.
         */
-        
-            if(readerSource.get() == nullptr){
-                bufferToFill.clearActiveBufferRegion();
-                return;
-            }
-            transportSource.getNextAudioBlock(bufferToFill);
+            const CallbackTelemetry::ScopedCallback measureCallback(telemetry_, bufferToFill.numSamples);
+            startupProfiler_->markFirstAudio();
+            
+            (stemMode_.load() ? stemTransport_ : transportSource).getNextAudioBlock(bufferToFill);
+            equaliser_.process(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
+            analyser_.pushBlock(*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
         }
         
         
@@ -257,7 +848,7 @@ class MainContentComponent: public juce::ChangeListener, public juce::AudioAppCo
         
         /*
         
-                                 RESPONDING TO AudioTransportSource CHANGES
+                                 RESPONDING TO CHANGES
         
         
         */
@@ -270,25 +861,25 @@ class MainContentComponent: public juce::ChangeListener, public juce::AudioAppCo
         * the ChangeBroadcaster hold a list of listeners to which it broadcasts a message when ChangeBroadcaster::sendChangeMessage() method is called
         * where ChangeListener is a class to receive callbacks() after sendChangeMessage() is called
         *
-        * When chnages in the transportSource are reported, the changeListenerCallback() will be called.
+        * the transport reports through its own event FIFO instead, see transportEventReceived_().
         */
-            if(source == &transportSource){
-                if(transportSource.isPlaying()){
-                    changeState_(Playing);
-                }
-                else if((state_ == Stopping) || (state_ == Playing))
-                    changeState_(Stopped);
-                else if(state_ == Pausing)
-                    changeState_(Paused);
+            if(source == &thumbnail_ || source == &waveformPyramid_)
+                    thumbnailChanged();
+            
+            if(source == &stems_){
+                stemPanel_.refresh();
+                
+                if(stemMode_.load())
+                    playButton_.setEnabled(stems_.getNumTracks() > 0);
             }
             
-            if(source == &thumbnail_)
-                    thumbnailChanged();
+            if(source == &loudness_.getObject())
+                playlist_.refreshGains();
         }
         
         
         void thumbnailChanged(){
-            repaint();
+            invalidateWaveform_();
         }
           
         
@@ -300,13 +891,96 @@ class MainContentComponent: public juce::ChangeListener, public juce::AudioAppCo
         
         */
         
+        juce::Rectangle<int> getThumbnailBounds_() const{
+            // the spectrum takes the 250 pixels on the right
+            return {10,10,getWidth()  -270,getHeight()-200};
+        }
+        
+        juce::Range<double> getVisibleRange_() const{
+            // an empty zoom range means the whole file is visible
+            if(visibleEnd_ > visibleStart_)
+                return {visibleStart_, visibleEnd_};
+            
+            return {0.0, thumbnail_.getTotalLength()};
+        }
+        
+        void mouseDown(const juce::MouseEvent& e) override{
+            seekToMouse_(e, false);
+        }
+        
+        void mouseDrag(const juce::MouseEvent& e) override{
+            seekToMouse_(e, true);
+        }
+        
+        void seekToMouse_(const juce::MouseEvent& e, bool scrubbing){
+            /*
+            * click or drag on the waveform to move the playhead. a click snaps to a seek point
+            * less than a pixel away, scrubbing to one within half the anchor spacing, so
+            * dragging keeps hitting decoded audio and doesn't stutter.
+            */
+            auto thumbnailBounds = getThumbnailBounds_();
+            auto visible = getVisibleRange_();
+            
+            if(thumbnail_.getNumChannels() == 0 || visible.isEmpty() || ! thumbnailBounds.contains(e.getMouseDownPosition()))
+                return;
+            
+            auto x = juce::jlimit(thumbnailBounds.getX(), thumbnailBounds.getRight(), e.x);
+            auto seconds = visible.getStart() + visible.getLength() * (x - thumbnailBounds.getX()) / thumbnailBounds.getWidth();
+            auto secondsPerPixel = visible.getLength() / thumbnailBounds.getWidth();
+            
+            seekTo(seconds, scrubbing ? juce::jmax(secondsPerPixel, SeekIndex::anchorSpacingSeconds * 0.5) : secondsPerPixel);
+        }
+        
+        void mouseWheelMove(const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override{
+            /*
+            * zoom in/out around the mouse position. the pyramid picks the level that
+            * matches the new samples-per-pixel ratio when the waveform is redrawn.
+            */
+            auto thumbnailBounds = getThumbnailBounds_();
+            auto audioLength = thumbnail_.getTotalLength();
+            
+            if(audioLength <= 0.0 || ! thumbnailBounds.contains(e.getPosition()))
+                return;
+            
+            auto visible = getVisibleRange_();
+            auto anchor = visible.getStart() + visible.getLength() * (e.position.x - (float) thumbnailBounds.getX()) / thumbnailBounds.getWidth();
+            auto newLength = juce::jlimit(juce::jmin(0.01, audioLength), audioLength, visible.getLength() * std::pow(0.8, wheel.deltaY * 5.0));
+            auto newStart = juce::jlimit(0.0, audioLength - newLength, anchor - (anchor - visible.getStart()) * newLength / visible.getLength());
+            
+            visibleStart_ = newStart;
+            visibleEnd_ = newStart + newLength;
+            invalidateWaveform_();
+        }
+        
         void paint(juce::Graphics& g) override{
-            juce::Rectangle<int> thumbnailBounds(10,10,getWidth()  -20,getHeight()-200);
+            auto thumbnailBounds = getThumbnailBounds_();
             
             if(thumbnail_.getNumChannels() == 0)
                 paintIfNoFileLoaded(g,thumbnailBounds);
             else
                 paintIfFileLoaded(g,thumbnailBounds);
+            
+            if(! firstFrameShown_){
+                firstFrameShown_ = true;
+                startupProfiler_->markFirstFrame();
+                
+                // deferred startup: the formats first, then the device, so the window can repaint in between
+                if(formatsPending_ || devicePending_){
+                    juce::Component::SafePointer<MainContentComponent> safeThis (this);
+                    
+                    juce::MessageManager::callAsync ([safeThis]{
+                        if(safeThis == nullptr)
+                            return;
+                        
+                        safeThis->initialiseFormats_();
+                        
+                        juce::MessageManager::callAsync ([safeThis]{
+                            if(safeThis != nullptr)
+                                safeThis->openAudioDevice_();
+                        });
+                    });
+                }
+            }
         }
         
         void paintIfNoFileLoaded (juce::Graphics& g, const juce::Rectangle<int>& thumbnailBounds) {
@@ -317,22 +991,53 @@ class MainContentComponent: public juce::ChangeListener, public juce::AudioAppCo
         }
         
         void paintIfFileLoaded (juce::Graphics& g, const juce::Rectangle<int>& thumbnailBounds){
-            g.setColour (juce::Colours::black);
-            g.fillRect (thumbnailBounds);
- 
-            g.setColour (juce::Colours::wheat);
- 
-            auto audioLength = (float) thumbnail_.getTotalLength();                               // [12]
-            thumbnail_.drawChannels (g, thumbnailBounds, 0.0, audioLength, 1.0f);
+            /*
+            * the waveform is only re-rendered when it was invalidated or the size/scale changed,
+            * a playhead repaint just blits the strip of waveformImage_ inside the clip region
+            */
+            auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+            auto imageWidth = juce::roundToInt((float) thumbnailBounds.getWidth() * scale);
+            auto imageHeight = juce::roundToInt((float) thumbnailBounds.getHeight() * scale);
+            
+            if(waveformDirty_ || waveformImage_.getWidth() != imageWidth || waveformImage_.getHeight() != imageHeight){
+                renderWaveformImage_(thumbnailBounds.getWidth(), thumbnailBounds.getHeight(), scale);
+                waveformDirty_ = false;
+            }
+            
+            g.drawImage (waveformImage_, thumbnailBounds.toFloat());
  
             g.setColour (juce::Colours::green);
- 
-            auto audioPosition = (float) transportSource.getCurrentPosition();
-            auto drawPosition = (audioPosition / audioLength) * (float) thumbnailBounds.getWidth()
-                            + (float) thumbnailBounds.getX();                                // [13]
+            
+            // playheadX_ is kept by timerCallback(), which repaints the strips it moves between
+            if(playheadX_ < 0)
+                return;
+            
+            auto drawPosition = (float) playheadX_;                                              // [13]
             g.drawLine (drawPosition, (float) thumbnailBounds.getY(), drawPosition,
                     (float) thumbnailBounds.getBottom(), 2.0f);                              // [14]
         }
+        
+        void renderWaveformImage_(int width, int height, float scale){
+            waveformImage_ = juce::Image(juce::Image::RGB, juce::jmax(1, juce::roundToInt((float) width * scale)),
+                                         juce::jmax(1, juce::roundToInt((float) height * scale)), false);
+            
+            juce::Graphics g(waveformImage_);
+            g.addTransform(juce::AffineTransform::scale(scale));
+            juce::Rectangle<int> area(0, 0, width, height);
+            
+            g.setColour (juce::Colours::black);
+            g.fillRect (area);
+ 
+            g.setColour (juce::Colours::wheat);
+ 
+            auto visible = getVisibleRange_();                                                    // [12]
+            
+            // the pyramid can resolve any zoom level; until it is built fall back to the thumbnail
+            if(waveformPyramid_.isComplete())
+                waveformPyramid_.drawChannels (g, area, visible.getStart(), visible.getEnd(), 1.0f);
+            else
+                thumbnail_.drawChannels (g, area, visible.getStart(), visible.getEnd(), 1.0f);
+        }
             
     
 };
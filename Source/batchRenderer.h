@@ -0,0 +1,346 @@
+/*
+  ==============================================================================
+
+    batchRenderer.h
+    Created: 17 Oct 2026 12:50:13am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "loopStreamer.h"
+#include "loudnessAnalyser.h"
+#include "parametricEq.h"
+#include "polyphaseResampler.h"
+
+/*
+* Renders whole files to WAV or FLAC through the same stages the player runs at playback:
+* loudness normalisation, level, the polyphase resampler and the parametric EQ, with an
+* optional loop range written back to back a number of times. Repeats go through the
+* looper's StreamingLoopEngine, so every seam gets the same crossfade the looper plays.
+*
+* Every file is one job on a ThreadPool with a thread per core. Decoding and encoding are
+* most of the work, so a job runs all three stages of its file itself, one block at a time:
+* read, process, write. Nothing but that block is held, so memory stays at about
+* numThreads x blockSize x channels however long the files are.
+*
+* Output goes to a TemporaryFile that replaces the target only once the file is complete.
+* cancel() stops every job at its next block; unfinished files leave nothing behind.
+*/
+class BatchRenderer
+{
+    public:
+        enum class Format{ wav, flac };
+
+        struct Options{
+            juce::File outputFolder;
+            Format format = Format::wav;
+            int bitsPerSample = 24;
+            double sampleRate = 0.0;                    // 0 keeps the rate of each file
+            PolyphaseResamplingSource::Quality quality = PolyphaseResamplingSource::Quality::standard;
+            bool normalise = false;
+            float level = 1.0f;
+            std::array<float, ParametricEq::numBands> eqGainsDb {};
+            juce::Range<double> loopSeconds;            // empty for the whole file
+            int loops = 1;                              // passes over the loop range, each seam crossfaded
+            int blockSize = 4096;
+            int numThreads = juce::SystemStats::getNumCpus();
+        };
+
+        struct FileResult{
+            enum class Status{ pending, written, failed, cancelled };
+
+            juce::File input, output;
+            Status status = Status::pending;
+            juce::String error;
+            double audioSeconds = 0.0;                  // written, at the output rate
+            double renderMs = 0.0;
+            juce::int64 bytesWritten = 0;
+        };
+
+        using FileCallback = std::function<void(const FileResult&)>;
+
+        /* `loudness` supplies and caches the normalisation gains; without one they are measured every time */
+        explicit BatchRenderer(juce::AudioFormatManager& formatManager, LoudnessAnalyser* loudness = nullptr)
+            : formatManager_(formatManager), loudness_(loudness) {}
+
+        static const char* getExtension(Format format){
+            return format == Format::flac ? ".flac" : ".wav";
+        }
+
+        /*
+        * renders every input and returns once all of them are done or cancel() was called.
+        * `onFileDone` is called from the worker that finished the file.
+        */
+        std::vector<FileResult> run(const juce::Array<juce::File>& inputs, const Options& options, const FileCallback& onFileDone = {}){
+            std::vector<FileResult> results((size_t) inputs.size());
+
+            // named up front, so two inputs with the same name never race for one output
+            juce::StringArray usedNames;
+
+            for(auto i = 0; i < inputs.size(); ++i){
+                auto& result = results[(size_t) i];
+                result.input = inputs[i];
+
+                auto name = inputs[i].getFileNameWithoutExtension();
+
+                for(auto suffix = 2; usedNames.contains(name, true) || options.outputFolder.getChildFile(name + getExtension(options.format)) == inputs[i]; ++suffix)
+                    name = inputs[i].getFileNameWithoutExtension() + " (" + juce::String(suffix) + ")";
+
+                usedNames.add(name);
+                result.output = options.outputFolder.getChildFile(name + getExtension(options.format));
+            }
+
+            options.outputFolder.createDirectory();
+
+            {
+                juce::ThreadPool pool(juce::jmax(1, options.numThreads));
+
+                for(auto& result : results)
+                    pool.addJob(new RenderJob(*this, options, result, onFileDone), true);
+
+                while(pool.getNumJobs() > 0){
+                    if(cancelled_.load()){
+                        // running jobs see shouldExit() at their next block, queued ones never start
+                        pool.removeAllJobs(true, 30000);
+                        break;
+                    }
+
+                    juce::Thread::sleep(20);
+                }
+            }
+
+            for(auto& result : results)
+                if(result.status == FileResult::Status::pending)
+                    result.status = FileResult::Status::cancelled;
+
+            return results;
+        }
+
+        /* may be called from any thread, including a signal handler */
+        void cancel() noexcept{
+            cancelled_ = true;
+        }
+
+        bool isCancelled() const noexcept{
+            return cancelled_.load();
+        }
+
+    private:
+        class RenderJob: public juce::ThreadPoolJob
+        {
+            public:
+                RenderJob(BatchRenderer& owner, const Options& options, FileResult& result, const FileCallback& onFileDone)
+                    : juce::ThreadPoolJob("Render " + result.input.getFileName()),
+                      owner_(owner), options_(options), result_(result), onFileDone_(onFileDone) {}
+
+                JobStatus runJob() override{
+                    auto startMs = juce::Time::getMillisecondCounterHiRes();
+
+                    if(shouldStop_())
+                        return jobHasFinished;
+
+                    result_.error = render_();
+                    result_.renderMs = juce::Time::getMillisecondCounterHiRes() - startMs;
+                    // audioSeconds is only set once the file is in place
+                    result_.status = result_.error.isNotEmpty() ? FileResult::Status::failed
+                                   : result_.audioSeconds > 0.0 ? FileResult::Status::written
+                                                                : FileResult::Status::cancelled;
+
+                    if(result_.status == FileResult::Status::written)
+                        result_.bytesWritten = result_.output.getSize();
+
+                    if(onFileDone_)
+                        onFileDone_(result_);
+
+                    return jobHasFinished;
+                }
+
+            private:
+                BatchRenderer& owner_;
+                const Options& options_;
+                FileResult& result_;
+                const FileCallback& onFileDone_;
+
+                bool shouldStop_(){
+                    return shouldExit() || owner_.isCancelled();
+                }
+
+                juce::String render_(){
+                    std::unique_ptr<juce::AudioFormatReader> reader(owner_.formatManager_.createReaderFor(result_.input));
+
+                    if(reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0)
+                        return "can't read the file";
+
+                    auto numChannels = (int) reader->numChannels;
+                    auto sourceRate = reader->sampleRate;
+                    auto outputRate = options_.sampleRate > 0.0 ? options_.sampleRate : sourceRate;
+
+                    // the gain the player would apply: measured over the whole file, not the loop range
+                    auto gain = options_.level;
+
+                    if(options_.normalise){
+                        auto stop = [this] { return shouldStop_(); };
+                        auto loudness = owner_.loudness_ != nullptr ? owner_.loudness_->measureNow(result_.input, stop)
+                                                                    : std::optional<LoudnessAnalyser::Result>(LoudnessAnalyser::measure(*reader, stop));
+
+                        if(shouldStop_())
+                            return {};
+
+                        if(loudness.has_value())
+                            gain *= juce::Decibels::decibelsToGain(loudness->getGainDb());
+                    }
+
+                    auto rangeStart = juce::jlimit((juce::int64) 0, reader->lengthInSamples, (juce::int64) (options_.loopSeconds.getStart() * sourceRate));
+                    auto rangeEnd = juce::jlimit(rangeStart, reader->lengthInSamples, (juce::int64) (options_.loopSeconds.getEnd() * sourceRate));
+
+                    if(options_.loopSeconds.isEmpty() || rangeEnd == rangeStart){
+                        rangeStart = 0;
+                        rangeEnd = reader->lengthInSamples;
+                    }
+
+                    auto loops = juce::jmax(1, options_.loops);
+                    auto sourceSamples = rangeEnd - rangeStart;
+
+                    /*
+                    * one pass reads the range straight through. repeats are rendered by the looper's
+                    * engine: each seam crossfades the tail into the head and the next pass carries on
+                    * after the faded-in part, so a pass after the first is one crossfade shorter. the
+                    * engine's background thread is this job's own, and in non-realtime mode render()
+                    * waits for it instead of underrunning
+                    */
+                    juce::TimeSliceThread loopThread("Batch loop");
+                    std::unique_ptr<juce::AudioSource> input;
+
+                    if(loops == 1){
+                        input = std::make_unique<juce::AudioFormatReaderSource>(new juce::AudioSubsectionReader(reader.release(), rangeStart, sourceSamples, true), true);
+                    }
+                    else{
+                        loopThread.startThread();
+
+                        auto engine = std::make_unique<StreamingLoopEngine>(reader.release(), loopThread);
+                        engine->setLoopRange(rangeStart, rangeEnd);
+                        engine->setNonRealtime(true);
+                        engine->prefill();
+
+                        auto fade = (juce::int64) engine->getCrossfadeLength();
+                        sourceSamples = loops * (sourceSamples - fade) + fade;
+                        input = std::make_unique<LoopEngineSource>(std::move(engine));
+                    }
+
+                    auto totalSamples = (juce::int64) std::llround((double) sourceSamples * outputRate / sourceRate);
+
+                    PolyphaseResamplingSource resampler(input.get(), false, numChannels, options_.quality);
+                    resampler.setResamplingRatio(sourceRate / outputRate);
+                    resampler.prepareToPlay(options_.blockSize, outputRate);
+
+                    ParametricEq equaliser;
+
+                    for(auto band = 0; band < ParametricEq::numBands; ++band)
+                        equaliser.setBandGain(band, options_.eqGainsDb[(size_t) band]);
+
+                    equaliser.prepare(outputRate, options_.blockSize, numChannels);
+
+                    auto writeError = juce::String();
+                    juce::TemporaryFile temporary(result_.output);
+                    auto writer = createWriter_(temporary.getFile(), outputRate, numChannels, writeError);
+
+                    if(writer == nullptr)
+                        return writeError;
+
+                    juce::AudioBuffer<float> buffer(numChannels, options_.blockSize);
+
+                    for(juce::int64 written = 0; written < totalSamples; written += buffer.getNumSamples()){
+                        if(shouldStop_())
+                            return {};
+
+                        auto numSamples = (int) juce::jmin((juce::int64) options_.blockSize, totalSamples - written);
+                        buffer.setSize(numChannels, numSamples, false, false, true);
+
+                        resampler.getNextAudioBlock(juce::AudioSourceChannelInfo(buffer));
+
+                        if(gain != 1.0f)
+                            buffer.applyGain(gain);
+
+                        equaliser.process(buffer, 0, numSamples);
+
+                        if(! writer->writeFromAudioSampleBuffer(buffer, 0, numSamples))
+                            return "can't write " + temporary.getFile().getFullPathName();
+                    }
+
+                    // flushes the header and the last frames before the temporary file is moved into place
+                    writer.reset();
+                    result_.audioSeconds = (double) totalSamples / outputRate;
+
+                    if(! temporary.overwriteTargetFileWithTemporary())
+                        return "can't replace " + result_.output.getFullPathName();
+
+                    return {};
+                }
+
+                std::unique_ptr<juce::AudioFormatWriter> createWriter_(const juce::File& file, double sampleRate, int numChannels, juce::String& error){
+                    std::unique_ptr<juce::AudioFormat> format;
+
+                    if(options_.format == Format::flac)
+                        format = std::make_unique<juce::FlacAudioFormat>();
+                    else
+                        format = std::make_unique<juce::WavAudioFormat>();
+
+                    if(! format->getPossibleBitDepths().contains(options_.bitsPerSample)){
+                        error = format->getFormatName() + " can't store " + juce::String(options_.bitsPerSample) + "-bit samples";
+                        return {};
+                    }
+
+                    std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+
+                    if(stream == nullptr){
+                        error = "can't create " + file.getFullPathName();
+                        return {};
+                    }
+
+                    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels,
+                                                                                            options_.bitsPerSample, {}, 0));
+
+                    if(writer == nullptr){
+                        error = format->getFormatName() + " can't write " + juce::String(numChannels) + " channels at " + juce::String(sampleRate) + " Hz";
+                        return {};
+                    }
+
+                    // the writer owns the stream from here on
+                    stream.release();
+                    return writer;
+                }
+        };
+
+        /* plays a StreamingLoopEngine as a source, for the resampler to pull from */
+        class LoopEngineSource: public juce::AudioSource
+        {
+            public:
+                explicit LoopEngineSource(std::unique_ptr<StreamingLoopEngine> engine)
+                    : engine_(std::move(engine)) {}
+
+                void prepareToPlay(int, double) override {}
+                void releaseResources() override {}
+
+                void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override{
+                    engine_->render(*info.buffer, info.startSample, info.numSamples);
+                }
+
+            private:
+                std::unique_ptr<StreamingLoopEngine> engine_;
+        };
+
+        juce::AudioFormatManager& formatManager_;
+        LoudnessAnalyser* loudness_;
+        std::atomic<bool> cancelled_ { false };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BatchRenderer)
+};
@@ -0,0 +1,203 @@
+/*
+  ==============================================================================
+
+    callbackTelemetry.h
+    Created: 17 Oct 2026 12:21:05am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <vector>
+
+/*
+* Timing of every audio callback against its deadline.
+*
+* The audio thread only takes two high resolution tick readings per callback and writes
+* one fixed-size record into a lock-free FIFO (a ScopedCallback does both). A
+* non-realtime thread, normally the message thread from a timer, calls collect() to drain
+* the FIFO into a load histogram, worst-case time, deadline-miss count and a history of
+* recent callbacks that can be written out as CSV.
+*/
+class CallbackTelemetry
+{
+    public:
+        static constexpr int numLoadBins = 11;         // 10% wide, the last one counts every callback over budget
+        static constexpr int fifoSize = 4096;          // ~45 s of 512-sample blocks at 44.1 kHz between two collect() calls
+        static constexpr int historySize = 65536;      // callbacks kept for the CSV export
+
+        struct Summary{
+            juce::int64 callbacks = 0;
+            juce::int64 deadlineMisses = 0;             // callbacks that took longer than the audio they produced
+            juce::int64 dropped = 0;                    // records lost because the FIFO was full
+            juce::int64 blockSizeChanges = 0;
+            int preparedBlockSize = 0, lastBlockSize = 0;
+            double sampleRate = 0.0;
+            double worstMs = 0.0, worstLoad = 0.0, averageLoad = 0.0;
+            double maxIntervalMs = 0.0;                 // longest gap between the starts of two callbacks
+            std::array<juce::int64, numLoadBins> loadHistogram {};
+        };
+
+        /*
+        * measures the scope it lives in; construct it first thing in getNextAudioBlock()
+        */
+        class ScopedCallback
+        {
+            public:
+                ScopedCallback(CallbackTelemetry& owner, int numSamples) noexcept
+                    : owner_(owner), numSamples_(numSamples), start_(juce::Time::getHighResolutionTicks()) {}
+
+                ~ScopedCallback() noexcept{
+                    owner_.push_({ start_, juce::Time::getHighResolutionTicks() - start_, numSamples_ });
+                }
+
+            private:
+                CallbackTelemetry& owner_;
+                int numSamples_;
+                juce::int64 start_;
+
+                JUCE_DECLARE_NON_COPYABLE(ScopedCallback)
+        };
+
+        CallbackTelemetry(){
+            history_.resize((size_t) historySize);
+        }
+
+        /* from prepareToPlay(): the block size the device announced and the rate deadlines are based on */
+        void prepare(int samplesPerBlockExpected, double sampleRate) noexcept{
+            preparedBlockSize_ = samplesPerBlockExpected;
+            sampleRate_ = sampleRate;
+        }
+
+        /*
+
+                                    NON-REALTIME THREAD
+
+        */
+
+        /* drains the FIFO into the summary and history; call it from one thread only */
+        void collect(){
+            auto sampleRate = sampleRate_.load();
+            auto ticksPerMs = (double) juce::Time::getHighResolutionTicksPerSecond() / 1000.0;
+
+            fifo_.read(fifo_.getNumReady()).forEach([&] (int index){
+                const auto& record = records_[(size_t) index];
+                auto durationMs = (double) record.durationTicks / ticksPerMs;
+                auto budgetMs = sampleRate > 0.0 ? record.numSamples * 1000.0 / sampleRate : 0.0;
+                auto load = budgetMs > 0.0 ? durationMs / budgetMs : 0.0;
+
+                if(firstStartTicks_ < 0)
+                    firstStartTicks_ = record.startTicks;
+                else
+                    summary_.maxIntervalMs = juce::jmax(summary_.maxIntervalMs, (double) (record.startTicks - lastStartTicks_) / ticksPerMs);
+
+                if(summary_.lastBlockSize != 0 && record.numSamples != summary_.lastBlockSize)
+                    ++summary_.blockSizeChanges;
+
+                lastStartTicks_ = record.startTicks;
+                summary_.lastBlockSize = record.numSamples;
+                ++summary_.callbacks;
+                loadSum_ += load;
+
+                if(load > 1.0)
+                    ++summary_.deadlineMisses;
+
+                summary_.worstMs = juce::jmax(summary_.worstMs, durationMs);
+                summary_.worstLoad = juce::jmax(summary_.worstLoad, load);
+                ++summary_.loadHistogram[(size_t) juce::jlimit(0, numLoadBins - 1, (int) (load * 10.0))];
+
+                auto& row = history_[(size_t) (historyCount_ % historySize)];
+                row.index = summary_.callbacks;
+                row.startMs = (double) (record.startTicks - firstStartTicks_) / ticksPerMs;
+                row.numSamples = record.numSamples;
+                row.durationMs = durationMs;
+                row.budgetMs = budgetMs;
+                ++historyCount_;
+            });
+
+            summary_.dropped = dropped_.load();
+            summary_.preparedBlockSize = preparedBlockSize_.load();
+            summary_.sampleRate = sampleRate;
+            summary_.averageLoad = summary_.callbacks > 0 ? loadSum_ / (double) summary_.callbacks : 0.0;
+        }
+
+        const Summary& getSummary() const noexcept{
+            return summary_;
+        }
+
+        void reset(){
+            collect();
+            summary_ = {};
+            dropped_ = 0;
+            loadSum_ = 0.0;
+            historyCount_ = 0;
+            firstStartTicks_ = -1;
+        }
+
+        /* one row per callback still in the history, oldest first */
+        bool exportCsv(const juce::File& file) const{
+            juce::FileOutputStream out(file);
+
+            if(! out.openedOk())
+                return false;
+
+            out.setPosition(0);
+            out.truncate();
+            out << "callback,start_ms,block_size,duration_ms,budget_ms,load\n";
+
+            auto numRows = juce::jmin(historyCount_, (juce::int64) historySize);
+
+            for(auto i = historyCount_ - numRows; i < historyCount_; ++i){
+                const auto& row = history_[(size_t) (i % historySize)];
+
+                out << juce::String(row.index) << ','
+                    << juce::String(row.startMs, 3) << ','
+                    << row.numSamples << ','
+                    << juce::String(row.durationMs, 4) << ','
+                    << juce::String(row.budgetMs, 4) << ','
+                    << juce::String(row.budgetMs > 0.0 ? row.durationMs / row.budgetMs : 0.0, 4) << '\n';
+            }
+
+            return out.getStatus().wasOk();
+        }
+
+    private:
+        struct Record{
+            juce::int64 startTicks = 0, durationTicks = 0;
+            int numSamples = 0;
+        };
+
+        struct Row{
+            juce::int64 index = 0;
+            double startMs = 0.0, durationMs = 0.0, budgetMs = 0.0;
+            int numSamples = 0;
+        };
+
+        // audio thread -> collect()
+        juce::AbstractFifo fifo_ { fifoSize };
+        std::array<Record, (size_t) fifoSize> records_;
+        std::atomic<juce::int64> dropped_ { 0 };
+        std::atomic<int> preparedBlockSize_ { 0 };
+        std::atomic<double> sampleRate_ { 0.0 };
+
+        // collect() only
+        Summary summary_;
+        double loadSum_ = 0.0;
+        juce::int64 firstStartTicks_ = -1, lastStartTicks_ = 0, historyCount_ = 0;
+        std::vector<Row> history_;
+
+        void push_(const Record& record) noexcept{
+            // a full FIFO only means collect() hasn't run for a while; count it and move on
+            const auto scope = fifo_.write(1);
+
+            if(scope.blockSize1 > 0)
+                records_[(size_t) scope.startIndex1] = record;
+            else
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CallbackTelemetry)
+};
@@ -0,0 +1,381 @@
+/*
+  ==============================================================================
+
+    decodedAudioCache.h
+    Created: 17 Oct 2026 12:30:53am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include "thumbnailDiskCache.h"
+
+/*
+* Decoded audio shared by every reader in the process, in chunks of chunkFrames samples
+* per file, up to a byte budget with least-recently-used eviction.
+*
+* wrap() puts a CachedAudioFormatReader in front of a reader. Reads that land on a cached
+* chunk are copied out of memory; a miss decodes the whole chunk with the wrapped reader
+* and adds it. Chunks hold the reader's raw samples (left-justified ints or float bits),
+* so AudioFormatReader::read() converts them exactly as it would have without the cache.
+*
+* Storage::packed keeps integer sources at their own bit depth (2 bytes per 16-bit sample,
+* 3 per 24-bit) and is lossless; Storage::int16 keeps every source as 16 bits, which is
+* lossy above 16 bits and for float sources; Storage::raw keeps 4 bytes per sample.
+*
+* Readers are only used on background threads, so the cache is guarded by a lock. Hold a
+* juce::SharedResourcePointer<DecodedAudioCache> to share the process-wide instance.
+*
+* Only wrap readers for playback. A whole-file scan (seek index, loudness, batch render)
+* reads every chunk once and would evict what is playing; those use plain readers.
+*/
+class DecodedAudioCache
+{
+    public:
+        static constexpr int chunkFrames = 32768;
+
+        enum class Storage{ raw, packed, int16 };
+
+        struct Stats{
+            juce::int64 hits = 0, misses = 0, evictions = 0;
+            size_t bytesUsed = 0, budgetBytes = 0;
+            int chunks = 0;
+
+            double getHitRate() const noexcept{
+                return hits + misses > 0 ? (double) hits / (double) (hits + misses) : 0.0;
+            }
+        };
+
+        DecodedAudioCache() = default;
+
+        /* 0 turns the cache off: wrap() then hands readers back untouched */
+        void setBudgetBytes(size_t budgetBytes){
+            const juce::ScopedLock sl(lock_);
+            budget_ = budgetBytes;
+            evictToBudget_();
+        }
+
+        /* applies to chunks decoded from now on */
+        void setStorage(Storage storage){
+            storage_ = storage;
+        }
+
+        Stats getStats() const{
+            const juce::ScopedLock sl(lock_);
+            auto stats = stats_;
+            stats.bytesUsed = bytesUsed_;
+            stats.budgetBytes = budget_;
+            stats.chunks = (int) entries_.size();
+            return stats;
+        }
+
+        void resetStats(){
+            const juce::ScopedLock sl(lock_);
+            stats_ = {};
+        }
+
+        void clear(){
+            const juce::ScopedLock sl(lock_);
+            entries_.clear();
+            index_.clear();
+            bytesUsed_ = 0;
+        }
+
+        /* takes ownership of `reader`, which must have been opened on `file` */
+        juce::AudioFormatReader* wrap(juce::AudioFormatReader* reader, const juce::File& file);
+
+    private:
+        friend class CachedAudioFormatReader;
+
+        struct Chunk{
+            int numChannels = 0, numFrames = 0;
+            int bytesPerSample = 4;
+            int shift = 0;                  // packed ints are the raw value >> shift
+            bool floatToInt16 = false;      // float samples stored as int16
+            juce::HeapBlock<char> data;     // channel after channel
+
+            size_t getSizeInBytes() const noexcept{
+                return (size_t) numChannels * (size_t) numFrames * (size_t) bytesPerSample + sizeof(Chunk);
+            }
+
+            void unpack(int* const* destChannels, int numDestChannels, int destOffset, int firstFrame, int numFramesToCopy) const noexcept{
+                for(auto channel = 0; channel < numDestChannels; ++channel){
+                    auto* dest = destChannels[channel];
+
+                    if(dest == nullptr)
+                        continue;
+
+                    dest += destOffset;
+
+                    if(channel >= numChannels){
+                        juce::zeromem(dest, sizeof(int) * (size_t) numFramesToCopy);
+                        continue;
+                    }
+
+                    const auto* src = reinterpret_cast<const juce::uint8*>(data.get())
+                                    + ((size_t) channel * (size_t) numFrames + (size_t) firstFrame) * (size_t) bytesPerSample;
+
+                    if(floatToInt16){
+                        const auto* samples = reinterpret_cast<const juce::int16*>(src);
+
+                        for(auto i = 0; i < numFramesToCopy; ++i){
+                            auto value = (float) samples[i] / 32767.0f;
+                            std::memcpy(dest + i, &value, sizeof(float));
+                        }
+                    }
+                    else if(bytesPerSample == 4){
+                        std::memcpy(dest, src, sizeof(int) * (size_t) numFramesToCopy);
+                    }
+                    else{
+                        for(auto i = 0; i < numFramesToCopy; ++i, src += bytesPerSample){
+                            juce::uint32 value = 0;
+
+                            for(auto byte = 0; byte < bytesPerSample; ++byte)
+                                value |= (juce::uint32) src[byte] << (8 * byte);
+
+                            dest[i] = (int) (value << shift);
+                        }
+                    }
+                }
+            }
+        };
+
+        struct Key{
+            juce::int64 file = 0, chunk = 0;
+            bool operator==(const Key& other) const noexcept{ return file == other.file && chunk == other.chunk; }
+        };
+
+        struct KeyHash{
+            size_t operator()(const Key& key) const noexcept{
+                return (size_t) ((juce::uint64) key.file ^ ((juce::uint64) key.chunk * 0x9e3779b97f4a7c15ULL));
+            }
+        };
+
+        using Entry = std::pair<Key, std::shared_ptr<const Chunk>>;
+
+        juce::CriticalSection lock_;
+        std::list<Entry> entries_;                                              // most recently used first
+        std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+        size_t budget_ = (size_t) 256 * 1024 * 1024;
+        size_t bytesUsed_ = 0;
+        std::atomic<Storage> storage_ { Storage::packed };
+        Stats stats_;
+
+        std::shared_ptr<const Chunk> find_(const Key& key){
+            const juce::ScopedLock sl(lock_);
+            auto found = index_.find(key);
+
+            if(found == index_.end()){
+                ++stats_.misses;
+                return {};
+            }
+
+            ++stats_.hits;
+            entries_.splice(entries_.begin(), entries_, found->second);
+            return found->second->second;
+        }
+
+        std::shared_ptr<const Chunk> insert_(const Key& key, std::shared_ptr<const Chunk> chunk){
+            const juce::ScopedLock sl(lock_);
+
+            // another reader of the same file may have decoded it meanwhile
+            auto found = index_.find(key);
+
+            if(found != index_.end())
+                return found->second->second;
+
+            if(budget_ == 0)
+                return chunk;
+
+            entries_.emplace_front(key, chunk);
+            index_[key] = entries_.begin();
+            bytesUsed_ += chunk->getSizeInBytes();
+            evictToBudget_();
+            return chunk;
+        }
+
+        void evictToBudget_(){
+            // readers still copying out of an evicted chunk keep it alive through their shared_ptr
+            while(bytesUsed_ > budget_ && ! entries_.empty()){
+                auto& oldest = entries_.back();
+                bytesUsed_ -= oldest.second->getSizeInBytes();
+                index_.erase(oldest.first);
+                entries_.pop_back();
+                ++stats_.evictions;
+            }
+        }
+
+        std::shared_ptr<const Chunk> pack_(const int* const* rawChannels, int numChannels, int numFrames,
+                                           int bitsPerSample, bool usesFloatingPointData) const{
+            auto chunk = std::make_shared<Chunk>();
+            auto storage = storage_.load();
+
+            chunk->numChannels = numChannels;
+            chunk->numFrames = numFrames;
+
+            if(storage == Storage::raw){
+                chunk->bytesPerSample = 4;
+            }
+            else if(usesFloatingPointData){
+                chunk->floatToInt16 = storage == Storage::int16;
+                chunk->bytesPerSample = chunk->floatToInt16 ? 2 : 4;
+            }
+            else{
+                // readers left-justify integer samples, so the low (32 - bits) bits are zero
+                auto bits = storage == Storage::int16 ? 16 : juce::jlimit(8, 32, (bitsPerSample + 7) / 8 * 8);
+                chunk->bytesPerSample = bits / 8;
+                chunk->shift = 32 - bits;
+            }
+
+            chunk->data.malloc((size_t) numChannels * (size_t) numFrames * (size_t) chunk->bytesPerSample);
+            auto* out = reinterpret_cast<juce::uint8*>(chunk->data.get());
+
+            for(auto channel = 0; channel < numChannels; ++channel){
+                const auto* src = rawChannels[channel];
+
+                if(chunk->floatToInt16){
+                    auto* samples = reinterpret_cast<juce::int16*>(out);
+
+                    for(auto i = 0; i < numFrames; ++i){
+                        float value;
+                        std::memcpy(&value, src + i, sizeof(float));
+                        samples[i] = (juce::int16) juce::roundToInt(juce::jlimit(-1.0f, 1.0f, value) * 32767.0f);
+                    }
+                }
+                else if(chunk->bytesPerSample == 4){
+                    std::memcpy(out, src, sizeof(int) * (size_t) numFrames);
+                }
+                else{
+                    for(auto i = 0; i < numFrames; ++i){
+                        auto value = (juce::uint32) (src[i] >> chunk->shift);
+
+                        for(auto byte = 0; byte < chunk->bytesPerSample; ++byte)
+                            out[(size_t) i * (size_t) chunk->bytesPerSample + (size_t) byte] = (juce::uint8) (value >> (8 * byte));
+                    }
+                }
+
+                out += (size_t) numFrames * (size_t) chunk->bytesPerSample;
+            }
+
+            return chunk;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodedAudioCache)
+};
+
+
+/*
+* AudioFormatReader that serves reads from a DecodedAudioCache and decodes missing chunks
+* with the reader it wraps. Like any reader it must only be used by one thread at a time.
+*/
+class CachedAudioFormatReader: public juce::AudioFormatReader
+{
+    public:
+        CachedAudioFormatReader(DecodedAudioCache& cache, juce::AudioFormatReader* source, juce::int64 fileKey)
+            : juce::AudioFormatReader(nullptr, source->getFormatName()),
+              cache_(cache), source_(source), fileKey_(fileKey)
+        {
+            sampleRate = source_->sampleRate;
+            bitsPerSample = source_->bitsPerSample;
+            lengthInSamples = source_->lengthInSamples;
+            numChannels = source_->numChannels;
+            usesFloatingPointData = source_->usesFloatingPointData;
+            metadataValues = source_->metadataValues;
+
+            scratch_.calloc((size_t) numChannels * (size_t) DecodedAudioCache::chunkFrames);
+
+            for(auto channel = 0; channel < (int) numChannels; ++channel)
+                scratchChannels_.add(scratch_.get() + (size_t) channel * (size_t) DecodedAudioCache::chunkFrames);
+        }
+
+        bool readSamples(int* const* destChannels, int numDestChannels, int startOffsetInDestBuffer,
+                         juce::int64 startSampleInFile, int numSamples) override{
+            while(numSamples > 0){
+                if(startSampleInFile >= lengthInSamples || startSampleInFile < 0){
+                    // outside the file: silence for this part, like the readers themselves
+                    auto samplesThisTime = startSampleInFile < 0 ? (int) juce::jmin((juce::int64) numSamples, -startSampleInFile) : numSamples;
+
+                    for(auto channel = 0; channel < numDestChannels; ++channel)
+                        if(destChannels[channel] != nullptr)
+                            juce::zeromem(destChannels[channel] + startOffsetInDestBuffer, sizeof(int) * (size_t) samplesThisTime);
+
+                    startOffsetInDestBuffer += samplesThisTime;
+                    startSampleInFile += samplesThisTime;
+                    numSamples -= samplesThisTime;
+                    continue;
+                }
+
+                auto chunkIndex = startSampleInFile / DecodedAudioCache::chunkFrames;
+                auto chunk = getChunk_(chunkIndex);
+
+                if(chunk == nullptr)
+                    return false;
+
+                auto firstFrame = (int) (startSampleInFile - chunkIndex * DecodedAudioCache::chunkFrames);
+                auto samplesThisTime = juce::jmin(numSamples, chunk->numFrames - firstFrame);
+
+                chunk->unpack(destChannels, numDestChannels, startOffsetInDestBuffer, firstFrame, samplesThisTime);
+                startOffsetInDestBuffer += samplesThisTime;
+                startSampleInFile += samplesThisTime;
+                numSamples -= samplesThisTime;
+            }
+
+            return true;
+        }
+
+    private:
+        DecodedAudioCache& cache_;
+        std::unique_ptr<juce::AudioFormatReader> source_;
+        juce::int64 fileKey_;
+        juce::HeapBlock<int> scratch_;          // one chunk of raw samples from source_
+        juce::Array<int*> scratchChannels_;
+        std::shared_ptr<const DecodedAudioCache::Chunk> lastChunk_;
+        juce::int64 lastChunkIndex_ = -1;
+
+        std::shared_ptr<const DecodedAudioCache::Chunk> getChunk_(juce::int64 chunkIndex){
+            // consecutive reads mostly stay in one chunk; only count the first of them
+            if(chunkIndex == lastChunkIndex_ && lastChunk_ != nullptr)
+                return lastChunk_;
+
+            DecodedAudioCache::Key key { fileKey_, chunkIndex };
+            auto chunk = cache_.find_(key);
+
+            if(chunk == nullptr){
+                auto start = chunkIndex * DecodedAudioCache::chunkFrames;
+                auto numFrames = (int) juce::jmin((juce::int64) DecodedAudioCache::chunkFrames, lengthInSamples - start);
+
+                if(! source_->read(scratchChannels_.getRawDataPointer(), (int) numChannels, start, numFrames, false))
+                    return {};
+
+                chunk = cache_.insert_(key, cache_.pack_(scratchChannels_.getRawDataPointer(), (int) numChannels, numFrames,
+                                                         (int) bitsPerSample, usesFloatingPointData));
+            }
+
+            lastChunk_ = chunk;
+            lastChunkIndex_ = chunkIndex;
+            return chunk;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CachedAudioFormatReader)
+};
+
+
+inline juce::AudioFormatReader* DecodedAudioCache::wrap(juce::AudioFormatReader* reader, const juce::File& file){
+    if(reader == nullptr || reader->lengthInSamples <= 0)
+        return reader;
+
+    {
+        const juce::ScopedLock sl(lock_);
+
+        if(budget_ == 0)
+            return reader;
+    }
+
+    return new CachedAudioFormatReader(*this, reader, KeyedFileInputSource::makeKey(file));
+}
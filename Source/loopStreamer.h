@@ -0,0 +1,268 @@
+/*
+  ==============================================================================
+
+    loopStreamer.h
+    Created: 17 Oct 2026 12:08:04am
+
+  ==============================================================================
+*/
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+/*
+    Streams a loop region of an audio file through two fixed-size chunks.
+
+    The background thread fills whichever chunk the audio thread is not reading, walking
+    through the file in loop order: when it reaches the loop end it blends the last
+    crossfade samples with the first ones after the loop start and carries on from there.
+    The audio thread only copies from a ready chunk, so memory use is two chunks no matter
+    how long the file is, and every position is 64-bit.
+*/
+class StreamingLoopEngine   : private juce::TimeSliceClient
+{
+public:
+    StreamingLoopEngine (juce::AudioFormatReader* sourceReader,        // takes ownership
+                         juce::TimeSliceThread& thread,
+                         int samplesPerChunk = 8192,
+                         int crossfadeSamples = 256)
+        : reader (sourceReader),
+          backgroundThread (thread),
+          chunkSize (juce::jmax (256, samplesPerChunk)),
+          crossfadeLength (juce::jmax (0, crossfadeSamples))
+    {
+        jassert (reader != nullptr);
+
+        auto numChannels = juce::jmax (1, (int) reader->numChannels);
+
+        for (auto& chunk : chunks)
+            chunk.audio.setSize (numChannels, chunkSize);
+
+        headBuffer.setSize (numChannels, chunkSize);
+
+        loopRange = { 0, reader->lengthInSamples };
+        fillPosition = 0;
+
+        backgroundThread.addTimeSliceClient (this);
+    }
+
+    ~StreamingLoopEngine() override
+    {
+        backgroundThread.removeTimeSliceClient (this);
+    }
+
+    //==============================================================================
+    juce::int64 getLengthInSamples() const noexcept  { return reader->lengthInSamples; }
+    double getSampleRate() const noexcept            { return reader->sampleRate; }
+    int getNumChannels() const noexcept              { return (int) reader->numChannels; }
+
+    /*  Sets the loop points in samples; `end` is exclusive. Called from the message thread,
+        picked up by the background thread for the next chunk it fills. Both points change
+        together, so the background thread never sees a start from one range and an end
+        from another.
+    */
+    void setLoopRange (juce::int64 start, juce::int64 end)
+    {
+        end   = juce::jlimit ((juce::int64) 1, reader->lengthInSamples, end);
+        start = juce::jlimit ((juce::int64) 0, end - 1, start);
+
+        const juce::SpinLock::ScopedLockType sl (loopRangeLock);
+        loopRange = { start, end };
+    }
+
+    juce::Range<juce::int64> getLoopRange() const
+    {
+        const juce::SpinLock::ScopedLockType sl (loopRangeLock);
+        return loopRange;
+    }
+
+    void setCrossfadeLength (int numSamples)
+    {
+        crossfadeLength = juce::jmax (0, numSamples);
+    }
+
+    /*  The seam crossfade the current loop range gets, which is at most half the range. */
+    int getCrossfadeLength() const noexcept
+    {
+        auto length = getLoopRange().getLength();
+        return length > 0 ? (int) juce::jmin ((juce::int64) crossfadeLength.load(), length / 2) : 0;
+    }
+
+    /*  Blocks until the first chunk is ready (or the timeout runs out), so playback
+        starts with audio instead of silence.
+    */
+    bool prefill (int timeoutMs = 1000)
+    {
+        return prefillChunk (chunks[0], timeoutMs);
+    }
+
+    //==============================================================================
+    /*  Audio thread: fills numSamples of dest, mapping output channels onto the file's
+        channels the same way the old whole-file buffer did. Never blocks; if the next
+        chunk is not ready the rest of the block is silent and counted as an underrun.
+    */
+    void render (juce::AudioBuffer<float>& dest, int startSample, int numSamples)
+    {
+        while (numSamples > 0)
+        {
+            auto& chunk = chunks[playIndex];
+
+            if (nonRealtime.load() && ! chunk.ready.load (std::memory_order_acquire))
+                prefillChunk (chunk, 5000);
+
+            if (! chunk.ready.load (std::memory_order_acquire))
+            {
+                dest.clear (startSample, numSamples);
+                underruns.fetch_add (1, std::memory_order_relaxed);
+                return;
+            }
+
+            auto samplesThisTime = juce::jmin (numSamples, chunk.numValid - readOffset);
+            auto numInputChannels = chunk.audio.getNumChannels();
+
+            for (auto channel = 0; channel < dest.getNumChannels(); ++channel)
+                dest.copyFrom (channel, startSample, chunk.audio, channel % numInputChannels, readOffset, samplesThisTime);
+
+            readOffset  += samplesThisTime;
+            startSample += samplesThisTime;
+            numSamples  -= samplesThisTime;
+
+            if (readOffset >= chunk.numValid)
+            {
+                chunk.ready.store (false, std::memory_order_release);   // hand it back for refilling
+                playIndex ^= 1;
+                readOffset = 0;
+            }
+        }
+    }
+
+    juce::int64 getUnderrunCount() const noexcept   { return underruns.load(); }
+
+    /*  In non-realtime mode render() waits for the background thread instead of playing
+        silence, so an offline render of the loop is complete. Not for device callbacks.
+    */
+    void setNonRealtime (bool isNonRealtime)        { nonRealtime = isNonRealtime; }
+
+private:
+    //==============================================================================
+    struct Chunk
+    {
+        juce::AudioBuffer<float> audio;
+        int numValid = 0;
+        std::atomic<bool> ready { false };
+    };
+
+    bool prefillChunk (Chunk& chunk, int timeoutMs)
+    {
+        auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32) timeoutMs;
+
+        while (! chunk.ready.load())
+        {
+            if (juce::Time::getMillisecondCounter() > deadline)
+                return false;
+
+            backgroundThread.moveToFrontOfQueue (this);
+            juce::Thread::sleep (1);
+        }
+
+        return true;
+    }
+
+    int useTimeSlice() override
+    {
+        auto& chunk = chunks[fillIndex];
+
+        if (chunk.ready.load (std::memory_order_acquire))
+            return juce::jlimit (1, 50, (int) (250.0 * chunkSize / juce::jmax (1.0, reader->sampleRate)));
+
+        fillChunk (chunk);
+        chunk.ready.store (true, std::memory_order_release);
+        fillIndex ^= 1;
+        return 1;
+    }
+
+    void fillChunk (Chunk& chunk)
+    {
+        auto range = getLoopRange();
+        auto start = range.getStart();
+        auto end   = range.getEnd();
+
+        // setLoopRange() never stores an empty range, but a bad one must not spin this thread forever
+        if (end - start <= 0)
+        {
+            chunk.audio.clear();
+            chunk.numValid = chunkSize;
+            return;
+        }
+
+        auto fade  = (juce::int64) juce::jmin ((juce::int64) crossfadeLength.load(), (end - start) / 2);
+        auto fadeStart = end - fade;
+
+        if (fillPosition < start || fillPosition >= end)
+            fillPosition = start;
+
+        auto written = 0;
+
+        while (written < chunkSize)
+        {
+            if (fillPosition >= end)
+                fillPosition = start + fade;    // the first `fade` samples were already heard in the crossfade
+
+            if (fade == 0 || fillPosition < fadeStart)
+            {
+                auto samplesThisTime = (int) juce::jmin ((juce::int64) (chunkSize - written), fadeStart - fillPosition);
+                reader->read (&chunk.audio, written, samplesThisTime, fillPosition, true, true);
+
+                fillPosition += samplesThisTime;
+                written      += samplesThisTime;
+            }
+            else
+            {
+                // seam: fade the loop tail out while the audio after the loop start fades in
+                auto samplesThisTime = (int) juce::jmin ((juce::int64) (chunkSize - written), end - fillPosition);
+                auto fadeOffset = fillPosition - fadeStart;
+                auto headPosition = start + fadeOffset;
+
+                reader->read (&chunk.audio, written, samplesThisTime, fillPosition, true, true);
+                reader->read (&headBuffer, 0, samplesThisTime, headPosition, true, true);
+
+                auto gainStart = (float) fadeOffset / (float) fade;
+                auto gainEnd   = (float) (fadeOffset + samplesThisTime) / (float) fade;
+
+                for (auto channel = 0; channel < chunk.audio.getNumChannels(); ++channel)
+                {
+                    chunk.audio.applyGainRamp (channel, written, samplesThisTime, 1.0f - gainStart, 1.0f - gainEnd);
+                    chunk.audio.addFromWithRamp (channel, written, headBuffer.getReadPointer (channel), samplesThisTime, gainStart, gainEnd);
+                }
+
+                fillPosition += samplesThisTime;
+                written      += samplesThisTime;
+            }
+        }
+
+        chunk.numValid = written;
+    }
+
+    //==============================================================================
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    juce::TimeSliceThread& backgroundThread;
+    const int chunkSize;
+
+    juce::SpinLock loopRangeLock;           // message thread writes, background thread reads; never the audio thread
+    juce::Range<juce::int64> loopRange;
+    std::atomic<int> crossfadeLength { 0 };
+
+    Chunk chunks[2];
+    juce::AudioBuffer<float> headBuffer;    // loop-start audio for the crossfade, background thread only
+
+    int fillIndex = 0;                      // background thread
+    juce::int64 fillPosition = 0;
+
+    int playIndex = 0, readOffset = 0;      // audio thread
+    std::atomic<juce::int64> underruns { 0 };
+    std::atomic<bool> nonRealtime { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamingLoopEngine)
+};
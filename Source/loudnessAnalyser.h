@@ -0,0 +1,477 @@
+/*
+  ==============================================================================
+
+    loudnessAnalyser.h
+    Created: 17 Oct 2026 12:39:07am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "thumbnailDiskCache.h"
+
+/*
+* Integrated loudness (ITU-R BS.1770 / EBU R128) and true peak of whole files, measured on
+* a ThreadPool in the background and kept per file on disk.
+*
+* Every file is decoded once by its own job: K-weighting filters, 400 ms blocks every
+* 100 ms, an absolute gate at -70 LUFS and a relative gate 10 LU below the ungated level.
+* The true peak is the largest sample of a 4x oversampled copy.
+*
+* Results are keyed like the thumbnails (path, size and modification time), so a file is
+* measured again only when it changes. getNormalisationGain() turns a result into the
+* linear gain that brings the file to targetLufs without pushing its true peak above
+* peakCeilingDb. Playback applies that gain itself; a change message is sent whenever a
+* new result is in.
+*
+* Hold a juce::SharedResourcePointer<LoudnessAnalyser> so every user in the process shares
+* one table. New results are written to disk by a thread of their own once none has come
+* in for saveDelayMs, outside the lock, merged with whatever another process saved since.
+*/
+class LoudnessAnalyser: public juce::ChangeBroadcaster, private juce::Thread
+{
+    public:
+        static constexpr float targetLufs = -18.0f;     // ReplayGain 2 reference level
+        static constexpr float peakCeilingDb = -1.0f;
+        static constexpr float maxBoostDb = 12.0f, maxCutDb = -24.0f;
+
+        struct Result{
+            float integratedLufs = -70.0f;
+            float truePeakDb = -100.0f;
+            bool hasAudio = false;                      // false when every block fell below the absolute gate
+
+            float getGainDb() const noexcept{
+                if(! hasAudio)
+                    return 0.0f;
+
+                return juce::jlimit(maxCutDb, maxBoostDb, juce::jmin(targetLufs - integratedLufs, peakCeilingDb - truePeakDb));
+            }
+        };
+
+        static constexpr int saveDelayMs = 1000;
+
+        explicit LoudnessAnalyser(const juce::File& cacheFile = getDefaultCacheFile(),
+                                  int numThreads = juce::jmax(1, juce::SystemStats::getNumCpus() / 2))
+            : juce::Thread("Loudness cache writer"), cacheFile_(cacheFile), pool_(numThreads)
+        {
+            formatManager_.registerBasicFormats();
+            loadCache_(results_);
+            startThread(juce::Thread::Priority::low);
+        }
+
+        ~LoudnessAnalyser() override{
+            pool_.removeAllJobs(true, 10000);
+            stopThread(10000);
+            saveCache_();
+        }
+
+        static juce::File getDefaultCacheFile(){
+            return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                       .getChildFile("audio_player")
+                       .getChildFile("loudness.cache");
+        }
+
+        /* queues `file` unless its result is known or it is already queued */
+        void analyse(const juce::File& file){
+            auto key = KeyedFileInputSource::makeKey(file);
+
+            {
+                const juce::ScopedLock sl(lock_);
+
+                if(results_.count(key) > 0 || ! queued_.insert(key).second)
+                    return;
+            }
+
+            pool_.addJob(new AnalysisJob(*this, file, key), true);
+        }
+
+        std::optional<Result> getResult(const juce::File& file) const{
+            auto key = KeyedFileInputSource::makeKey(file);
+            const juce::ScopedLock sl(lock_);
+            auto found = results_.find(key);
+
+            if(found == results_.end())
+                return {};
+
+            return found->second;
+        }
+
+        /* linear gain for `file`, 1 while it hasn't been measured */
+        float getNormalisationGain(const juce::File& file) const{
+            auto result = getResult(file);
+            return result.has_value() ? juce::Decibels::decibelsToGain(result->getGainDb()) : 1.0f;
+        }
+
+        /* the result for `file`, measured on the calling thread and cached unless it was known already */
+        std::optional<Result> measureNow(const juce::File& file, const std::function<bool()>& shouldExit = {}){
+            if(auto known = getResult(file))
+                return known;
+
+            std::unique_ptr<juce::AudioFormatReader> reader(formatManager_.createReaderFor(file));
+
+            if(reader == nullptr || reader->lengthInSamples <= 0)
+                return {};
+
+            auto result = measure(*reader, shouldExit);
+
+            if(shouldExit && shouldExit())
+                return {};
+
+            {
+                const juce::ScopedLock sl(lock_);
+                results_[KeyedFileInputSource::makeKey(file)] = result;
+                dirty_ = true;
+            }
+
+            notify();
+            return result;
+        }
+
+        bool isBusy() const{
+            const juce::ScopedLock sl(lock_);
+            return ! queued_.empty();
+        }
+
+        /* measures a reader on the calling thread; used by the jobs and by the bench */
+        static Result measure(juce::AudioFormatReader& reader, const std::function<bool()>& shouldExit = {}){
+            auto numChannels = juce::jmax(1, (int) reader.numChannels);
+            auto weights = getChannelWeights_(reader);
+            std::vector<KWeighting> filters((size_t) numChannels, KWeighting(reader.sampleRate));
+            std::vector<TruePeakMeter> peakMeters((size_t) numChannels);
+
+            // mean squares over 100 ms steps; a 400 ms block is four consecutive steps
+            auto stepLength = juce::jmax(1, juce::roundToInt(reader.sampleRate * 0.1));
+            std::vector<double> steps;
+            double stepSum = 0.0;
+            int stepFill = 0;
+
+            juce::AudioBuffer<float> buffer(numChannels, 65536);
+
+            for(juce::int64 position = 0; position < reader.lengthInSamples; position += buffer.getNumSamples()){
+                if(shouldExit && shouldExit())
+                    return {};
+
+                auto numSamples = (int) juce::jmin((juce::int64) buffer.getNumSamples(), reader.lengthInSamples - position);
+                reader.read(&buffer, 0, numSamples, position, true, true);
+
+                for(auto i = 0; i < numSamples;){
+                    auto samplesThisTime = juce::jmin(numSamples - i, stepLength - stepFill);
+
+                    for(auto channel = 0; channel < numChannels; ++channel){
+                        const auto* data = buffer.getReadPointer(channel, i);
+                        auto& filter = filters[(size_t) channel];
+                        auto& peak = peakMeters[(size_t) channel];
+                        double sum = 0.0;
+
+                        for(auto n = 0; n < samplesThisTime; ++n){
+                            auto weighted = filter.process(data[n]);
+                            sum += weighted * weighted;
+                            peak.process(data[n]);
+                        }
+
+                        stepSum += weights[(size_t) channel] * sum;
+                    }
+
+                    i += samplesThisTime;
+                    stepFill += samplesThisTime;
+
+                    if(stepFill == stepLength){
+                        steps.push_back(stepSum / stepLength);
+                        stepSum = 0.0;
+                        stepFill = 0;
+                    }
+                }
+            }
+
+            std::vector<double> blocks;
+
+            for(size_t i = 3; i < steps.size(); ++i)
+                blocks.push_back((steps[i - 3] + steps[i - 2] + steps[i - 1] + steps[i]) / 4.0);
+
+            // shorter than one block: the whole file is the block
+            if(blocks.empty() && stepFill + (int) steps.size() * stepLength > 0){
+                auto total = stepSum;
+
+                for(auto step : steps)
+                    total += step * stepLength;
+
+                blocks.push_back(total / (stepFill + (double) steps.size() * stepLength));
+            }
+
+            auto toLufs = [] (double meanSquare) { return -0.691 + 10.0 * std::log10(juce::jmax(1.0e-20, meanSquare)); };
+            auto gatedMean = [&blocks, &toLufs] (double thresholdLufs, bool& any){
+                double sum = 0.0;
+                int count = 0;
+
+                for(auto block : blocks){
+                    if(toLufs(block) > thresholdLufs){
+                        sum += block;
+                        ++count;
+                    }
+                }
+
+                any = count > 0;
+                return count > 0 ? sum / count : 0.0;
+            };
+
+            Result result;
+            bool any = false;
+            auto ungated = gatedMean(-70.0, any);
+
+            if(any){
+                auto gated = gatedMean(toLufs(ungated) - 10.0, any);
+                result.integratedLufs = (float) toLufs(any ? gated : ungated);
+                result.hasAudio = true;
+            }
+
+            auto truePeak = 0.0f;
+
+            for(const auto& peak : peakMeters)
+                truePeak = juce::jmax(truePeak, peak.getPeak());
+
+            result.truePeakDb = juce::Decibels::gainToDecibels(truePeak, -100.0f);
+            return result;
+        }
+
+    private:
+        static constexpr int cacheMagic = 0x5344554c;  // "LUDS"
+
+        /* BS.1770 channel weights: 1 for the front channels, 1.41 for the surrounds, 0 for the LFE */
+        static std::vector<double> getChannelWeights_(juce::AudioFormatReader& reader){
+            auto numChannels = juce::jmax(1, (int) reader.numChannels);
+            auto layout = reader.getChannelLayout();
+            std::vector<double> weights((size_t) numChannels, 1.0);
+
+            for(auto channel = 0; channel < numChannels; ++channel){
+                auto type = layout.size() == numChannels ? layout.getTypeOfChannel(channel) : juce::AudioChannelSet::unknown;
+
+                if(type == juce::AudioChannelSet::unknown || type == juce::AudioChannelSet::discreteChannel0){
+                    // no layout: the WAVE order L, R, C, LFE, Ls, Rs once there are enough channels for it
+                    if(numChannels >= 6 && channel == 3)
+                        weights[(size_t) channel] = 0.0;
+                    else if(numChannels >= 4 && channel >= (numChannels >= 6 ? 4 : 2))
+                        weights[(size_t) channel] = 1.41;
+                }
+                else if(type == juce::AudioChannelSet::LFE || type == juce::AudioChannelSet::LFE2){
+                    weights[(size_t) channel] = 0.0;
+                }
+                else if(type == juce::AudioChannelSet::leftSurround || type == juce::AudioChannelSet::rightSurround
+                        || type == juce::AudioChannelSet::leftSurroundSide || type == juce::AudioChannelSet::rightSurroundSide
+                        || type == juce::AudioChannelSet::leftSurroundRear || type == juce::AudioChannelSet::rightSurroundRear
+                        || type == juce::AudioChannelSet::centreSurround){
+                    weights[(size_t) channel] = 1.41;
+                }
+            }
+
+            return weights;
+        }
+
+        /* the two BS.1770 pre-filters (high shelf, then RLB high-pass) for any sample rate */
+        struct KWeighting{
+            explicit KWeighting(double sampleRate){
+                auto pi = juce::MathConstants<double>::pi;
+
+                auto f0 = 1681.974450955533, gain = 3.999843853973347, q = 0.7071752369554196;
+                auto k = std::tan(pi * f0 / sampleRate);
+                auto vh = std::pow(10.0, gain / 20.0), vb = std::pow(vh, 0.4996667741545416);
+                auto a0 = 1.0 + k / q + k * k;
+                shelf = { (vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                          2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+
+                f0 = 38.13547087602444; q = 0.5003270373238773;
+                k = std::tan(pi * f0 / sampleRate);
+                a0 = 1.0 + k / q + k * k;
+                highPass = { 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+            }
+
+            double process(float input) noexcept{
+                auto x = (double) input;
+                auto y = shelf[0] * x + s1;
+                s1 = shelf[1] * x - shelf[3] * y + s2;
+                s2 = shelf[2] * x - shelf[4] * y;
+
+                auto z = highPass[0] * y + t1;
+                t1 = highPass[1] * y - highPass[3] * z + t2;
+                t2 = highPass[2] * y - highPass[4] * z;
+                return z;
+            }
+
+            std::array<double, 5> shelf {}, highPass {};   // b0, b1, b2, a1, a2
+            double s1 = 0.0, s2 = 0.0, t1 = 0.0, t2 = 0.0;
+        };
+
+        /* peak of a 4x oversampled signal, interpolated with a 48-tap windowed sinc */
+        struct TruePeakMeter{
+            static constexpr int tapsPerPhase = 12;
+
+            TruePeakMeter(){
+                for(auto phase = 1; phase < 4; ++phase){
+                    for(auto tap = 0; tap < tapsPerPhase; ++tap){
+                        // distance of history sample `tap` from the interpolated point
+                        auto distance = (tapsPerPhase / 2 - 1 - tap) + phase / 4.0;
+                        auto x = juce::MathConstants<double>::pi * distance;
+                        auto window = 0.5 + 0.5 * std::cos(juce::MathConstants<double>::pi * distance / (tapsPerPhase / 2));
+                        coefficients[(size_t) phase - 1][(size_t) tap] = (float) (std::sin(x) / x * window);
+                    }
+                }
+            }
+
+            void process(float input) noexcept{
+                // history[0] is the oldest sample
+                std::memmove(history.data(), history.data() + 1, sizeof(float) * (tapsPerPhase - 1));
+                history[tapsPerPhase - 1] = input;
+                peak = juce::jmax(peak, std::abs(input));
+
+                for(const auto& phase : coefficients){
+                    auto sum = 0.0f;
+
+                    for(auto tap = 0; tap < tapsPerPhase; ++tap)
+                        sum += phase[(size_t) tap] * history[(size_t) tap];
+
+                    peak = juce::jmax(peak, std::abs(sum));
+                }
+            }
+
+            float getPeak() const noexcept{ return peak; }
+
+            std::array<std::array<float, tapsPerPhase>, 3> coefficients {};
+            std::array<float, tapsPerPhase> history {};
+            float peak = 0.0f;
+        };
+
+        class AnalysisJob: public juce::ThreadPoolJob
+        {
+            public:
+                AnalysisJob(LoudnessAnalyser& owner, const juce::File& file, juce::int64 key)
+                    : juce::ThreadPoolJob("Loudness " + file.getFileName()), owner_(owner), file_(file), key_(key) {}
+
+                JobStatus runJob() override{
+                    std::unique_ptr<juce::AudioFormatReader> reader(owner_.formatManager_.createReaderFor(file_));
+                    std::optional<Result> result;
+
+                    if(reader != nullptr && reader->lengthInSamples > 0)
+                        result = measure(*reader, [this] { return shouldExit(); });
+
+                    owner_.finished_(key_, shouldExit() ? std::optional<Result>() : result);
+                    return jobHasFinished;
+                }
+
+            private:
+                LoudnessAnalyser& owner_;
+                juce::File file_;
+                juce::int64 key_;
+        };
+
+        juce::AudioFormatManager formatManager_;
+        juce::File cacheFile_;
+        juce::ThreadPool pool_;
+        juce::InterProcessLock cacheFileLock_ { "audio_player_loudness_cache" };
+
+        juce::CriticalSection lock_;
+        std::unordered_map<juce::int64, Result> results_;
+        std::unordered_set<juce::int64> queued_;
+        bool dirty_ = false;                            // results_ holds something the file doesn't
+
+        void finished_(juce::int64 key, const std::optional<Result>& result){
+            {
+                const juce::ScopedLock sl(lock_);
+                queued_.erase(key);
+
+                if(! result.has_value())
+                    return;
+
+                results_[key] = *result;
+                dirty_ = true;
+            }
+
+            notify();
+            sendChangeMessage();
+        }
+
+        void run() override{
+            while(! threadShouldExit()){
+                wait(-1);
+
+                // a batch finishes files in quick succession: wait until they stop coming
+                while(! threadShouldExit() && wait(saveDelayMs)) {}
+
+                saveCache_();
+            }
+        }
+
+        void loadCache_(std::unordered_map<juce::int64, Result>& results) const{
+            juce::MemoryBlock data;
+
+            if(! cacheFile_.loadFileAsData(data))
+                return;
+
+            juce::MemoryInputStream in(data, false);
+
+            if(in.readInt() != cacheMagic)
+                return;
+
+            for(auto count = in.readInt(); --count >= 0 && ! in.isExhausted();){
+                auto key = in.readInt64();
+                Result result;
+                result.integratedLufs = in.readFloat();
+                result.truePeakDb = in.readFloat();
+                result.hasAudio = in.readBool();
+                results[key] = result;
+            }
+        }
+
+        void saveCache_(){
+            {
+                const juce::ScopedLock sl(lock_);
+
+                if(! dirty_)
+                    return;
+
+                dirty_ = false;
+            }
+
+            // the player, the looper and the bench can run at once: each keeps what the others saved
+            juce::InterProcessLock::ScopedLockType processLock(cacheFileLock_);
+            std::unordered_map<juce::int64, Result> results;
+            loadCache_(results);
+
+            {
+                const juce::ScopedLock sl(lock_);
+
+                for(const auto& [key, result] : results_)
+                    results[key] = result;
+
+                for(const auto& [key, result] : results)
+                    results_.emplace(key, result);
+            }
+
+            // a few bytes per file, so the whole table is simply rewritten
+            juce::MemoryOutputStream out;
+            out.writeInt(cacheMagic);
+            out.writeInt((int) results.size());
+
+            for(const auto& [key, result] : results){
+                out.writeInt64(key);
+                out.writeFloat(result.integratedLufs);
+                out.writeFloat(result.truePeakDb);
+                out.writeBool(result.hasAudio);
+            }
+
+            cacheFile_.getParentDirectory().createDirectory();
+            juce::TemporaryFile temporary(cacheFile_);
+
+            if(temporary.getFile().replaceWithData(out.getData(), out.getDataSize()))
+                temporary.overwriteTargetFileWithTemporary();
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessAnalyser)
+};
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    mappedWavReader.h
+    Created: 17 Oct 2026 12:07:00am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+/*
+* Opens an uncompressed WAV file as a MemoryMappedAudioFormatReader and maps the whole file.
+* Reading from such a reader converts samples straight out of the mapping into the
+* destination buffer, without the read() copies of the buffered stream reader.
+*
+* Returns nullptr when the file is not a WAV, uses an encoding that cannot be mapped or
+* the mapping itself fails, so the caller can fall back to AudioFormatManager::createReaderFor().
+*/
+inline std::unique_ptr<juce::MemoryMappedAudioFormatReader> createMappedWavReader(const juce::File& file){
+    if(! file.hasFileExtension("wav;wave"))
+        return {};
+
+    juce::WavAudioFormat wavFormat;
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader(wavFormat.createMemoryMappedReader(file));
+
+    if(reader == nullptr || reader->lengthInSamples <= 0)
+        return {};
+
+    if(! reader->mapEntireFile() || reader->getMappedSection().isEmpty())
+        return {};
+
+    return reader;
+}
+
+
+/*
+* Pages in the part of a mapped file that is about to be played, so page faults are taken
+* on the read-ahead thread ahead of time rather than when the samples are converted.
+*
+* It must be registered on the same TimeSliceThread as the ReadAheadAudioSource that reads
+* the mapped reader: the position is taken from `source`, which is only ever moved on that thread.
+*/
+class MappedPagePrefetcher: private juce::TimeSliceClient
+{
+    public:
+        MappedPagePrefetcher(const juce::MemoryMappedAudioFormatReader& reader,
+                             const juce::PositionableAudioSource& source,
+                             juce::TimeSliceThread& thread,
+                             int prefetchMs = 2000)
+            : reader_(reader), source_(source), thread_(thread)
+        {
+            auto bytesPerFrame = juce::jmax(1, (int) (reader_.numChannels * reader_.bitsPerSample / 8));
+            samplesPerPage_ = juce::jmax(1, 4096 / bytesPerFrame);
+            prefetchSamples_ = (juce::int64) (prefetchMs * reader_.sampleRate / 1000.0);
+            thread_.addTimeSliceClient(this);
+        }
+
+        ~MappedPagePrefetcher() override{
+            thread_.removeTimeSliceClient(this);
+        }
+
+        juce::int64 getPagesTouched() const{
+            return pagesTouched_.load();
+        }
+
+    private:
+        const juce::MemoryMappedAudioFormatReader& reader_;
+        const juce::PositionableAudioSource& source_;
+        juce::TimeSliceThread& thread_;
+        int samplesPerPage_ = 1;
+        juce::int64 prefetchSamples_ = 0;
+        juce::int64 windowStart_ = -1, touchedUpTo_ = 0;
+        std::atomic<juce::int64> pagesTouched_ { 0 };
+
+        int useTimeSlice() override{
+            auto playhead = source_.getNextReadPosition();
+            auto windowEnd = juce::jmin(reader_.lengthInSamples, playhead + prefetchSamples_);
+
+            // after a seek backwards (or past what we already touched) start again from the playhead
+            if(playhead < windowStart_ || playhead > touchedUpTo_)
+                touchedUpTo_ = playhead;
+
+            windowStart_ = playhead;
+
+            if(touchedUpTo_ >= windowEnd)
+                return 50;
+
+            // touch at most a few hundred pages per slice so the reader is never held up for long
+            auto limit = juce::jmin(windowEnd, touchedUpTo_ + (juce::int64) samplesPerPage_ * 256);
+
+            for(; touchedUpTo_ < limit; touchedUpTo_ += samplesPerPage_){
+                reader_.touchSample(touchedUpTo_);
+                pagesTouched_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            return 5;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MappedPagePrefetcher)
+};
@@ -0,0 +1,445 @@
+/*
+  ==============================================================================
+
+    mediaLibrary.h
+    Created: 17 Oct 2026 12:32:52am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/*
+* Every audio file under a set of folders, with the details a reader learns from the
+* header: format, sample rate, length, channels and bit depth.
+*
+* loadIndex() reads the whole index back from one binary file, so the library is usable
+* straight away at startup. rescan() walks the folders on a background thread. Files whose
+* size and modification time match the index are kept as they are; only new or changed
+* files are opened, by a ThreadPool, in batches. Each reader only parses the header. When
+* a scan finishes, a new snapshot is published, the index is rewritten and a change message
+* is sent.
+*
+* Snapshots are immutable and shared, so the UI can hold one while the next scan runs.
+*/
+class MediaLibrary: public juce::ChangeBroadcaster, private juce::Thread
+{
+    public:
+        struct Entry{
+            juce::String path;
+            juce::int64 size = 0, modifiedMs = 0;
+            double sampleRate = 0.0;
+            juce::int64 lengthInSamples = 0;
+            int numChannels = 0;                // 0 when no registered format could read the file
+            int bitsPerSample = 0;
+            juce::String format;
+
+            bool isReadable() const noexcept    { return numChannels > 0 && sampleRate > 0.0; }
+            double getLengthInSeconds() const   { return sampleRate > 0.0 ? (double) lengthInSamples / sampleRate : 0.0; }
+        };
+
+        using Snapshot = std::vector<Entry>;    // sorted by path
+
+        struct Stats{
+            int filesSeen = 0, headersRead = 0, unchanged = 0;
+            double scanMs = 0.0, loadMs = 0.0;
+        };
+
+        MediaLibrary(juce::AudioFormatManager& formatManager, const juce::File& indexFile = getDefaultIndexFile(),
+                     int numThreads = juce::SystemStats::getNumCpus())
+            : juce::Thread("Library scanner"),
+              formatManager_(formatManager), indexFile_(indexFile), pool_(juce::jmax(1, numThreads)),
+              snapshot_(std::make_shared<const Snapshot>())
+        {}
+
+        ~MediaLibrary() override{
+            stopThread(10000);
+            pool_.removeAllJobs(true, 10000);
+        }
+
+        static juce::File getDefaultIndexFile(){
+            return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                       .getChildFile("audio_player")
+                       .getChildFile("library.index");
+        }
+
+        /* the folders and entries saved by the last scan; false if there is no usable index */
+        bool loadIndex(){
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            juce::MemoryBlock data;
+
+            if(! indexFile_.loadFileAsData(data))
+                return false;
+
+            juce::MemoryInputStream in(data, false);
+
+            if(in.readInt() != indexMagic || in.readInt() != indexVersion)
+                return false;
+
+            juce::StringArray folders, formats;
+
+            for(auto i = in.readInt(); --i >= 0 && ! in.isExhausted();)
+                folders.add(in.readString());
+
+            for(auto i = in.readInt(); --i >= 0 && ! in.isExhausted();)
+                formats.add(in.readString());
+
+            auto snapshot = std::make_shared<Snapshot>();
+            auto numEntries = in.readInt();
+
+            if(numEntries < 0)
+                return false;
+
+            snapshot->resize((size_t) numEntries);
+
+            for(auto& entry : *snapshot){
+                if(in.isExhausted())
+                    return false;
+
+                entry.path = in.readString();
+                entry.size = in.readInt64();
+                entry.modifiedMs = in.readInt64();
+                entry.sampleRate = in.readDouble();
+                entry.lengthInSamples = in.readInt64();
+                entry.numChannels = in.readShort();
+                entry.bitsPerSample = in.readShort();
+                entry.format = formats[in.readShort()];    // shared strings, not one copy per entry
+            }
+
+            {
+                const juce::ScopedLock sl(lock_);
+                folders_ = folders;
+                snapshot_ = std::move(snapshot);
+                stats_.loadMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+            }
+
+            sendChangeMessage();
+            return true;
+        }
+
+        void addFolder(const juce::File& folder){
+            {
+                const juce::ScopedLock sl(lock_);
+                folders_.addIfNotAlreadyThere(folder.getFullPathName());
+            }
+
+            rescan();
+        }
+
+        void removeFolder(const juce::File& folder){
+            {
+                const juce::ScopedLock sl(lock_);
+                folders_.removeString(folder.getFullPathName());
+            }
+
+            rescan();
+        }
+
+        juce::StringArray getFolders() const{
+            const juce::ScopedLock sl(lock_);
+            return folders_;
+        }
+
+        /* starts a scan, or asks the running one to start over once it is done */
+        void rescan(){
+            rescanRequested_ = true;
+
+            if(! isThreadRunning())
+                startThread(juce::Thread::Priority::low);
+            else
+                notify();
+        }
+
+        bool isScanning() const noexcept{
+            return rescanRequested_.load() || scanning_.load();
+        }
+
+        std::shared_ptr<const Snapshot> getSnapshot() const{
+            const juce::ScopedLock sl(lock_);
+            return snapshot_;
+        }
+
+        Stats getStats() const{
+            const juce::ScopedLock sl(lock_);
+            return stats_;
+        }
+
+    private:
+        static constexpr int indexMagic = 0x42494c41;      // "ALIB"
+        static constexpr int indexVersion = 1;
+        static constexpr int filesPerJob = 32;
+
+        juce::AudioFormatManager& formatManager_;
+        juce::File indexFile_;
+        juce::ThreadPool pool_;
+
+        juce::CriticalSection lock_;
+        juce::StringArray folders_;
+        std::shared_ptr<const Snapshot> snapshot_;
+        Stats stats_;
+        std::atomic<bool> rescanRequested_ { false }, scanning_ { false };
+
+        void run() override{
+            while(! threadShouldExit()){
+                if(rescanRequested_.load()){
+                    // set before the request is cleared, so isScanning() never reads false in between
+                    scanning_ = true;
+                    rescanRequested_ = false;
+                    scan_();
+                    scanning_ = false;
+                    continue;
+                }
+
+                wait(-1);
+            }
+        }
+
+        void scan_(){
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            auto previous = getSnapshot();
+            auto folders = getFolders();
+            auto wildcard = formatManager_.getWildcardForAllFormats();
+
+            std::unordered_map<juce::String, const Entry*> known;
+            known.reserve(previous->size());
+
+            for(const auto& entry : *previous)
+                known.emplace(entry.path, &entry);
+
+            // the directory walk gives size and modification time without opening anything
+            auto entries = std::make_shared<Snapshot>();
+            std::vector<size_t> toRead;
+            Stats stats;
+
+            for(const auto& folder : folders){
+                for(const auto& item : juce::RangedDirectoryIterator(juce::File(folder), true, wildcard, juce::File::findFiles)){
+                    if(threadShouldExit())
+                        return;
+
+                    Entry entry;
+                    entry.path = item.getFile().getFullPathName();
+                    entry.size = item.getFileSize();
+                    entry.modifiedMs = item.getModificationTime().toMilliseconds();
+
+                    auto found = known.find(entry.path);
+
+                    if(found != known.end() && found->second->size == entry.size && found->second->modifiedMs == entry.modifiedMs)
+                        entries->push_back(*found->second);
+                    else
+                        entries->push_back(std::move(entry));
+                }
+            }
+
+            // nested folders can list a file twice; keep the first
+            std::sort(entries->begin(), entries->end(), [] (const Entry& a, const Entry& b) { return a.path < b.path; });
+            entries->erase(std::unique(entries->begin(), entries->end(), [] (const Entry& a, const Entry& b) { return a.path == b.path; }),
+                           entries->end());
+
+            // entries without a format have never been opened (or changed since)
+            for(size_t i = 0; i < entries->size(); ++i){
+                if((*entries)[i].format.isEmpty())
+                    toRead.push_back(i);
+                else
+                    ++stats.unchanged;
+            }
+
+            // each job opens a batch of headers into its own slots of `entries`
+            for(size_t first = 0; first < toRead.size(); first += filesPerJob){
+                auto last = juce::jmin(toRead.size(), first + (size_t) filesPerJob);
+
+                pool_.addJob([this, entries, &toRead, first, last]{
+                    for(auto i = first; i < last; ++i)
+                        readHeader_((*entries)[toRead[i]]);
+                });
+            }
+
+            while(pool_.getNumJobs() > 0){
+                if(threadShouldExit()){
+                    pool_.removeAllJobs(true, 10000);
+                    return;
+                }
+
+                wait(5);
+            }
+
+            stats.filesSeen = (int) entries->size();
+            stats.headersRead = (int) toRead.size();
+            stats.scanMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+
+            {
+                const juce::ScopedLock sl(lock_);
+                stats.loadMs = stats_.loadMs;
+                stats_ = stats;
+                snapshot_ = entries;
+            }
+
+            saveIndex_(*entries, folders);
+            sendChangeMessage();
+        }
+
+        void readHeader_(Entry& entry) const{
+            std::unique_ptr<juce::AudioFormatReader> reader(formatManager_.createReaderFor(juce::File(entry.path)));
+
+            // unreadable files stay in the index too, so they aren't tried again until they change
+            entry.format = reader != nullptr ? reader->getFormatName() : juce::String("?");
+
+            if(reader == nullptr)
+                return;
+
+            entry.sampleRate = reader->sampleRate;
+            entry.lengthInSamples = reader->lengthInSamples;
+            entry.numChannels = (int) reader->numChannels;
+            entry.bitsPerSample = (int) reader->bitsPerSample;
+        }
+
+        void saveIndex_(const Snapshot& entries, const juce::StringArray& folders) const{
+            juce::MemoryOutputStream out;
+            juce::StringArray formats;
+
+            for(const auto& entry : entries)
+                formats.addIfNotAlreadyThere(entry.format);
+
+            out.writeInt(indexMagic);
+            out.writeInt(indexVersion);
+            out.writeInt(folders.size());
+
+            for(const auto& folder : folders)
+                out.writeString(folder);
+
+            out.writeInt(formats.size());
+
+            for(const auto& format : formats)
+                out.writeString(format);
+
+            out.writeInt((int) entries.size());
+
+            for(const auto& entry : entries){
+                out.writeString(entry.path);
+                out.writeInt64(entry.size);
+                out.writeInt64(entry.modifiedMs);
+                out.writeDouble(entry.sampleRate);
+                out.writeInt64(entry.lengthInSamples);
+                out.writeShort((short) entry.numChannels);
+                out.writeShort((short) entry.bitsPerSample);
+                out.writeShort((short) formats.indexOf(entry.format));
+            }
+
+            // written next to the old index and swapped in, so a crash never leaves half a file
+            indexFile_.getParentDirectory().createDirectory();
+            juce::TemporaryFile temporary(indexFile_);
+
+            if(temporary.getFile().replaceWithData(out.getData(), out.getDataSize()))
+                temporary.overwriteTargetFileWithTemporary();
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MediaLibrary)
+};
+
+
+/*
+* Table of a MediaLibrary snapshot: name, length, rate, channels and format. Double-click
+* or return plays the selected rows through onFilesChosen.
+*/
+class MediaLibraryList: public juce::Component, private juce::TableListBoxModel, private juce::ChangeListener
+{
+    public:
+        std::function<void(const juce::Array<juce::File>&)> onFilesChosen;
+
+        explicit MediaLibraryList(MediaLibrary& library): library_(library){
+            addAndMakeVisible(table_);
+            table_.setModel(this);
+            table_.setMultipleSelectionEnabled(true);
+
+            auto& header = table_.getHeader();
+            header.addColumn("Name", nameColumn, 320);
+            header.addColumn("Length", lengthColumn, 70);
+            header.addColumn("Rate", rateColumn, 70);
+            header.addColumn("Ch", channelsColumn, 40);
+            header.addColumn("Format", formatColumn, 120);
+
+            library_.addChangeListener(this);
+            changeListenerCallback(&library_);
+        }
+
+        ~MediaLibraryList() override{
+            library_.removeChangeListener(this);
+        }
+
+        void resized() override{
+            table_.setBounds(getLocalBounds());
+        }
+
+    private:
+        enum Columns{ nameColumn = 1, lengthColumn, rateColumn, channelsColumn, formatColumn };
+
+        MediaLibrary& library_;
+        juce::TableListBox table_;
+        std::shared_ptr<const MediaLibrary::Snapshot> snapshot_;
+
+        void changeListenerCallback(juce::ChangeBroadcaster*) override{
+            snapshot_ = library_.getSnapshot();
+            table_.updateContent();
+            table_.repaint();
+        }
+
+        int getNumRows() override{
+            return snapshot_ != nullptr ? (int) snapshot_->size() : 0;
+        }
+
+        void paintRowBackground(juce::Graphics& g, int, int, int, bool rowIsSelected) override{
+            if(rowIsSelected)
+                g.fillAll(juce::Colours::lightblue.withAlpha(0.4f));
+        }
+
+        void paintCell(juce::Graphics& g, int row, int columnId, int width, int height, bool) override{
+            if(snapshot_ == nullptr || row >= (int) snapshot_->size())
+                return;
+
+            const auto& entry = (*snapshot_)[(size_t) row];
+            juce::String text;
+
+            switch(columnId){
+                case nameColumn:        text = entry.path.fromLastOccurrenceOf(juce::File::getSeparatorString(), false, false); break;
+                case lengthColumn:      text = entry.isReadable() ? juce::String(entry.getLengthInSeconds(), 1) + " s" : "-"; break;
+                case rateColumn:        text = entry.isReadable() ? juce::String(entry.sampleRate, 0) : "-"; break;
+                case channelsColumn:    text = entry.isReadable() ? juce::String(entry.numChannels) : "-"; break;
+                case formatColumn:      text = entry.format; break;
+                default:                break;
+            }
+
+            g.setColour(entry.isReadable() ? juce::Colours::white : juce::Colours::grey);
+            g.drawText(text, 4, 0, width - 6, height, juce::Justification::centredLeft, true);
+        }
+
+        void cellDoubleClicked(int, int, const juce::MouseEvent&) override{
+            chooseSelectedRows_();
+        }
+
+        void returnKeyPressed(int) override{
+            chooseSelectedRows_();
+        }
+
+        void chooseSelectedRows_(){
+            if(snapshot_ == nullptr || onFilesChosen == nullptr)
+                return;
+
+            juce::Array<juce::File> files;
+            auto selected = table_.getSelectedRows();
+
+            for(auto i = 0; i < selected.size(); ++i)
+                if(auto row = selected[i]; row < (int) snapshot_->size() && (*snapshot_)[(size_t) row].isReadable())
+                    files.add(juce::File((*snapshot_)[(size_t) row].path));
+
+            if(! files.isEmpty())
+                onFilesChosen(files);
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MediaLibraryList)
+};
@@ -0,0 +1,1502 @@
+/*
+  ==============================================================================
+
+    offlineRender.cpp
+    Created: 17 Oct 2026 12:20:07am
+
+  ==============================================================================
+*/
+
+/*
+* Headless host for the audio path of both apps (Bench/audio_player_bench.jucer).
+*
+* The components are built without opening an audio device and their prepareToPlay() /
+* getNextAudioBlock() are called in a loop as fast as possible. For every run it prints
+* per-block time percentiles, the realtime multiple, operator new calls made inside the
+* callback and page faults, and it can write the output to a float WAV or compare it with
+* an earlier one sample by sample.
+*
+*   audio_player_bench [--app player|looper] file.wav [more.wav ...]
+*                      [--block 512] [--rate 44100] [--seconds N] [--output out.wav]
+*                      [--compare reference.wav] [--reader mapped|stream] [--eq dB]
+*                      [--read-ahead-ms N] [--crossfade-ms N] [--level 0..1]
+*                      [--resampling draft|standard|mastering] [--realtime-reads] [--no-alloc]
+*                      [--cache-mb N] [--cache-storage raw|packed|int16] [--passes N] [--no-analyser]
+*                      [--normalise] [--stems]
+*   audio_player_bench --bench-eq [--channels N] [--blocks 20000] [--block 512]
+*   audio_player_bench --bench-pyramid file.wav
+*   audio_player_bench --bench-seek 40 file.flac [file.ogg ...]
+*   audio_player_bench --bench-resampler [--block 512]
+*   audio_player_bench --bench-library [folder ...] [--synthetic 100000]
+*   audio_player_bench --bench-loudness file.flac [more ...]
+*   audio_player_bench --bench-transport [--block 512]
+*   audio_player_bench --bench-mixer [--block 512] [--blocks 2000]
+*   audio_player_bench --bench-startup [--passes 10] [--device] [--budget-ms N]
+*   audio_player_bench --bench-device file.wav [--app player|looper] [--clock realtime|manual]
+*                      [--speed 1] [--block-sizes 64,512,...] [--jitter-ms N] [--late-every N]
+*                      [--late-ms N] [--seconds 5] [--output out.wav] [--fail-on-glitch]
+*   audio_player_bench --batch out-folder file.flac [more ...] [--format wav|flac] [--bits 24]
+*                      [--rate Hz] [--threads N] [--normalise] [--level 0..1] [--eq dB]
+*                      [--resampling draft|standard|mastering] [--loop start:end] [--loops N]
+*
+* Exit code is 1 when --compare finds a difference or --bench-startup is over its budget,
+* 2 when --no-alloc is given and the callback allocated, 3 when a --batch file failed or
+* the batch was cancelled, and 4 when --fail-on-glitch is given and a callback on the
+* virtual device took longer than its block.
+*/
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <memory>
+#include <new>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+ #include <sys/resource.h>
+#endif
+
+#include "audioPlayer.h"
+#include "audioLooping.h"
+#include "batchRenderer.h"
+#include "virtualAudioDevice.h"
+
+
+/*
+
+                            COUNTING ALLOCATIONS
+
+*/
+
+namespace allocations
+{
+    static std::atomic<juce::int64> count { 0 }, bytes { 0 };
+    static thread_local bool counting = false; // only set on the render thread, around the callback
+
+    static void record(std::size_t size){
+        if(counting){
+            count.fetch_add(1, std::memory_order_relaxed);
+            bytes.fetch_add((juce::int64) size, std::memory_order_relaxed);
+        }
+    }
+
+    static void* allocate(std::size_t size){
+        record(size);
+        return std::malloc(size > 0 ? size : 1);
+    }
+
+    static void* allocateAligned(std::size_t size, std::align_val_t alignment){
+        record(size);
+       #if JUCE_WINDOWS
+        return _aligned_malloc(size > 0 ? size : 1, (std::size_t) alignment);
+       #else
+        void* p = nullptr;
+        return posix_memalign(&p, juce::jmax(sizeof(void*), (std::size_t) alignment), size > 0 ? size : 1) == 0 ? p : nullptr;
+       #endif
+    }
+
+    static void freeAligned(void* p) noexcept{
+       #if JUCE_WINDOWS
+        _aligned_free(p);
+       #else
+        std::free(p);
+       #endif
+    }
+}
+
+void* operator new(std::size_t size){
+    if(auto* p = allocations::allocate(size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size){
+    if(auto* p = allocations::allocate(size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept     { return allocations::allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept   { return allocations::allocate(size); }
+void operator delete(void* p) noexcept                                   { std::free(p); }
+void operator delete[](void* p) noexcept                                 { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept                      { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept                    { std::free(p); }
+
+void* operator new(std::size_t size, std::align_val_t alignment){
+    if(auto* p = allocations::allocateAligned(size, alignment))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment){
+    if(auto* p = allocations::allocateAligned(size, alignment))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p, std::align_val_t) noexcept                 { allocations::freeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept               { allocations::freeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept    { allocations::freeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept  { allocations::freeAligned(p); }
+
+
+/*
+
+                            MEASURING
+
+*/
+
+struct PageFaults{
+    juce::int64 minor = 0, major = 0;
+};
+
+static PageFaults getPageFaults(bool currentThreadOnly){
+    PageFaults faults;
+
+   #if JUCE_LINUX || JUCE_MAC || JUCE_BSD
+    struct rusage usage {};
+
+    #if JUCE_LINUX
+    auto who = currentThreadOnly ? RUSAGE_THREAD : RUSAGE_SELF;
+    #else
+    auto who = RUSAGE_SELF;
+    juce::ignoreUnused(currentThreadOnly);
+    #endif
+
+    if(getrusage(who, &usage) == 0){
+        faults.minor = (juce::int64) usage.ru_minflt;
+        faults.major = (juce::int64) usage.ru_majflt;
+    }
+   #else
+    juce::ignoreUnused(currentThreadOnly);
+   #endif
+
+    return faults;
+}
+
+static double ticksToMs(juce::int64 ticks){
+    return juce::Time::highResolutionTicksToSeconds(ticks) * 1000.0;
+}
+
+static void printPercentiles(const char* name, std::vector<double> values){
+    if(values.empty())
+        return;
+
+    std::sort(values.begin(), values.end());
+
+    auto percentile = [&values] (double p){
+        return values[(size_t) juce::jlimit(0, (int) values.size() - 1, (int) std::ceil(p / 100.0 * (double) values.size()) - 1)];
+    };
+
+    std::cout << name << " ms  p50 " << percentile(50.0)
+              << "  p90 " << percentile(90.0)
+              << "  p99 " << percentile(99.0)
+              << "  p99.9 " << percentile(99.9)
+              << "  max " << values.back() << std::endl;
+}
+
+template <typename CacheStats>
+static void printCacheStats(const CacheStats& stats){
+    std::cout << "decoded cache: " << stats.hits << " hits, " << stats.misses << " misses ("
+              << stats.getHitRate() * 100.0 << "%), " << stats.evictions << " evictions, "
+              << stats.chunks << " chunks, " << (double) stats.bytesUsed / (1024.0 * 1024.0) << " of "
+              << (double) stats.budgetBytes / (1024.0 * 1024.0) << " MB" << std::endl;
+}
+
+template <typename Cache>
+static void configureCache(Cache& cache, const juce::ArgumentList& args){
+    if(args.containsOption("--cache-mb"))
+        cache.setBudgetBytes((size_t) juce::jmax(0, args.getValueForOption("--cache-mb").getIntValue()) * 1024 * 1024);
+
+    auto storage = args.getValueForOption("--cache-storage");
+    cache.setStorage(storage == "raw" ? Cache::Storage::raw : storage == "int16" ? Cache::Storage::int16 : Cache::Storage::packed);
+}
+
+
+/*
+
+                            RENDERING
+
+*/
+
+struct RenderOptions{
+    double sampleRate = 44100.0;
+    int blockSize = 512;
+    int numChannels = 2;
+    double maxSeconds = 3600.0;
+    juce::File output, reference;
+    bool failOnAllocation = false;
+};
+
+static int render(juce::AudioSource& source, const RenderOptions& options, const std::function<bool()>& hasFinished){
+    /*
+    * the source has been prepared and started by the caller. blocks are rendered back to
+    * back; writing and comparing the output happens outside the timed part.
+    */
+    auto maxBlocks = (juce::int64) std::ceil(options.maxSeconds * options.sampleRate / options.blockSize);
+    juce::AudioBuffer<float> buffer(options.numChannels, options.blockSize);
+    std::vector<double> blockMs;
+    blockMs.reserve((size_t) juce::jmin(maxBlocks, (juce::int64) 10000000));
+
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+
+    if(options.output != juce::File{}){
+        options.output.deleteFile();
+
+        if(auto stream = options.output.createOutputStream()){
+            // 32-bit WAV is written as float, so the file holds exactly what the callback produced
+            writer.reset(juce::WavAudioFormat().createWriterFor(stream.get(), options.sampleRate, (unsigned int) options.numChannels, 32, {}, 0));
+
+            if(writer != nullptr)
+                stream.release();
+        }
+
+        if(writer == nullptr)
+            std::cout << "can't write " << options.output.getFullPathName() << std::endl;
+    }
+
+    juce::AudioFormatManager referenceFormats;
+    referenceFormats.registerBasicFormats();
+    std::unique_ptr<juce::AudioFormatReader> reference;
+    juce::AudioBuffer<float> referenceBuffer(options.numChannels, options.blockSize);
+    juce::int64 differingSamples = 0;
+    float maxDifference = 0.0f;
+
+    if(options.reference != juce::File{}){
+        reference.reset(referenceFormats.createReaderFor(options.reference));
+
+        if(reference == nullptr){
+            std::cout << "can't read " << options.reference.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    juce::uint64 hash = 14695981039346656037ULL; // FNV-1a over the raw float bytes
+    juce::int64 renderTicks = 0, numBlocks = 0;
+
+    allocations::count = 0;
+    allocations::bytes = 0;
+    auto threadFaultsBefore = getPageFaults(true);
+    auto processFaultsBefore = getPageFaults(false);
+    auto wallStart = juce::Time::getHighResolutionTicks();
+
+    for(; numBlocks < maxBlocks && ! hasFinished(); ++numBlocks){
+        juce::AudioSourceChannelInfo info(&buffer, 0, options.blockSize);
+
+        auto start = juce::Time::getHighResolutionTicks();
+        allocations::counting = true;
+        source.getNextAudioBlock(info);
+        allocations::counting = false;
+        auto elapsed = juce::Time::getHighResolutionTicks() - start;
+
+        renderTicks += elapsed;
+        blockMs.push_back(ticksToMs(elapsed));
+
+        for(auto channel = 0; channel < options.numChannels; ++channel){
+            auto* bytes = reinterpret_cast<const juce::uint8*>(buffer.getReadPointer(channel));
+
+            for(size_t i = 0; i < (size_t) options.blockSize * sizeof(float); ++i)
+                hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+
+        if(writer != nullptr)
+            writer->writeFromAudioSampleBuffer(buffer, 0, options.blockSize);
+
+        if(reference != nullptr){
+            reference->read(&referenceBuffer, 0, options.blockSize, numBlocks * options.blockSize, true, true);
+
+            for(auto channel = 0; channel < options.numChannels; ++channel){
+                auto* rendered = buffer.getReadPointer(channel);
+                auto* expected = referenceBuffer.getReadPointer(channel);
+
+                for(auto i = 0; i < options.blockSize; ++i){
+                    if(rendered[i] != expected[i]){
+                        ++differingSamples;
+                        maxDifference = juce::jmax(maxDifference, std::abs(rendered[i] - expected[i]));
+                    }
+                }
+            }
+        }
+    }
+
+    auto wallSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - wallStart);
+    auto threadFaults = getPageFaults(true);
+    auto processFaults = getPageFaults(false);
+    auto audioSeconds = (double) (numBlocks * options.blockSize) / options.sampleRate;
+    auto callbackSeconds = juce::Time::highResolutionTicksToSeconds(renderTicks);
+
+    writer.reset();
+
+    std::cout << "blocks: " << numBlocks << " of " << options.blockSize << " samples at " << options.sampleRate << " Hz" << std::endl;
+    std::cout << "audio: " << audioSeconds << " s  wall: " << wallSeconds << " s  in callback: " << callbackSeconds << " s" << std::endl;
+    std::cout << "realtime multiple: " << (callbackSeconds > 0.0 ? audioSeconds / callbackSeconds : 0.0)
+              << " (callback only), " << (wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0) << " (wall)" << std::endl;
+    printPercentiles("block", std::move(blockMs));
+    std::cout << "allocations in callback: " << allocations::count.load() << " (" << allocations::bytes.load() << " bytes)" << std::endl;
+    std::cout << "page faults: render thread " << threadFaults.minor - threadFaultsBefore.minor << " minor / "
+              << threadFaults.major - threadFaultsBefore.major << " major, process "
+              << processFaults.minor - processFaultsBefore.minor << " minor / "
+              << processFaults.major - processFaultsBefore.major << " major" << std::endl;
+    std::cout << "output hash: " << juce::String::toHexString((juce::int64) hash) << std::endl;
+
+    if(reference != nullptr){
+        auto lengthMatches = reference->lengthInSamples == numBlocks * options.blockSize;
+
+        std::cout << "compare: " << differingSamples << " differing samples, max difference " << maxDifference
+                  << (lengthMatches ? "" : ", length differs") << std::endl;
+
+        if(differingSamples > 0 || ! lengthMatches)
+            return 1;
+    }
+
+    if(options.failOnAllocation && allocations::count.load() > 0)
+        return 2;
+
+    return 0;
+}
+
+static bool waitFor(const std::function<bool()>& condition, int timeoutMs){
+    auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32) timeoutMs;
+
+    while(! condition()){
+        if(juce::Time::getMillisecondCounter() > deadline)
+            return false;
+
+        juce::Thread::sleep(5);
+    }
+
+    return true;
+}
+
+static int renderPlayer(const juce::ArgumentList& args, const juce::Array<juce::File>& files, RenderOptions options){
+    MainContentComponent component(false);
+
+    component.setUseMemoryMapping(args.getValueForOption("--reader") != "stream");
+    component.setNonRealtime(! args.containsOption("--realtime-reads"));
+    component.setAnalyserEnabled(! args.containsOption("--no-analyser"));
+
+    // off by default so a measurement finishing mid-render can't change the output
+    auto normalise = args.containsOption("--normalise");
+    component.setLoudnessNormalisation(normalise);
+
+    if(args.containsOption("--read-ahead-ms"))
+        component.setReadAheadMs(args.getValueForOption("--read-ahead-ms").getIntValue());
+
+    if(args.containsOption("--crossfade-ms"))
+        component.setCrossfadeMs(args.getValueForOption("--crossfade-ms").getIntValue());
+
+    if(args.containsOption("--resampling")){
+        auto name = args.getValueForOption("--resampling");
+        component.setResamplingQuality(name == "draft" ? PolyphaseResamplingSource::Quality::draft
+                                       : name == "mastering" ? PolyphaseResamplingSource::Quality::mastering
+                                                             : PolyphaseResamplingSource::Quality::standard);
+    }
+
+    if(args.containsOption("--eq"))
+        for(auto band = 0; band < ParametricEq::numBands; ++band)
+            component.setEqBandGain(band, (band % 2 == 0 ? 1.0f : -1.0f) * args.getValueForOption("--eq").getFloatValue());
+
+    component.prepareToPlay(options.blockSize, options.sampleRate);
+    // --stems plays every file at once through the mixer instead of one after another
+    if(args.containsOption("--stems")){
+        component.loadStems(files);
+        waitFor([&component] { return ! component.isStemLoading(); }, 60000);
+    }
+    else
+        component.loadFiles(files);
+
+    // the waveform is built on every core; let it finish so it doesn't skew the timings
+    waitFor([&component] { return component.isWaveformComplete(); }, 60000);
+
+    // waitFor doesn't deliver change messages, so the new gains are pushed to the playlist here.
+    // no track has started yet, so each one plays at its gain from the first sample
+    if(normalise){
+        waitFor([&component] { return component.isLoudnessAnalysisComplete(); }, 600000);
+        component.setLoudnessNormalisation(true);
+    }
+
+    component.startPlayback();
+
+    auto result = render(component, options, [&component] { return ! component.isPlaying(); });
+    auto stats = component.getReadAheadStats();
+
+    std::cout << "read-ahead (last track): " << stats.underruns << " underruns, " << stats.refills << " refills, max refill "
+              << stats.maxRefillMs << " ms" << std::endl;
+    printCacheStats(component.getDecodedCache().getStats());
+
+    auto analyser = component.getAnalyserCost();
+    std::cout << "analyser push: " << analyser.averageUs << " us average, " << analyser.maxUs << " us max over "
+              << analyser.pushes << " callbacks, " << analyser.droppedSamples << " samples dropped" << std::endl;
+
+    component.releaseResources();
+    return result;
+}
+
+static int renderLooper(const juce::ArgumentList& args, const juce::File& file, RenderOptions options){
+    AudioLoopingComponent component(false);
+
+    component.setNonRealtime(! args.containsOption("--realtime-reads"));
+    component.setLevel(args.containsOption("--level") ? args.getValueForOption("--level").getFloatValue() : 1.0f);
+    component.setLoudnessNormalisation(args.containsOption("--normalise"));
+    component.prepareToPlay(options.blockSize, options.sampleRate);
+    component.openFile(file);
+
+    if(! waitFor([&component] { return component.isFileLoaded(); }, 10000)){
+        std::cout << "can't open " << file.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    waitFor([&component] { return ! component.isLoudnessPending(); }, 600000);
+
+    auto result = render(component, options, [] { return false; });
+    printCacheStats(component.getDecodedCache().getStats());
+    component.releaseResources();
+    return result;
+}
+
+
+/*
+
+                            BENCHMARKS
+
+*/
+
+static void benchmarkEqChannels(int numChannels, int numBlocks, const RenderOptions& options){
+    ParametricEq vectorEq, scalarEq;
+
+    for(auto band = 0; band < ParametricEq::numBands; ++band){
+        vectorEq.setBandGain(band, band % 2 == 0 ? 6.0f : -6.0f);
+        scalarEq.setBandGain(band, band % 2 == 0 ? 6.0f : -6.0f);
+    }
+
+    vectorEq.prepare(options.sampleRate, options.blockSize, numChannels);
+    scalarEq.prepare(options.sampleRate, options.blockSize, numChannels);
+
+    juce::AudioBuffer<float> noise(numChannels, options.blockSize), vectorOut(numChannels, options.blockSize), scalarOut(numChannels, options.blockSize);
+    juce::Random random(1234);
+    std::vector<double> vectorMs, scalarMs;
+    vectorMs.reserve((size_t) numBlocks);
+    scalarMs.reserve((size_t) numBlocks);
+    float maxDifference = 0.0f;
+
+    for(auto block = 0; block < numBlocks; ++block){
+        for(auto channel = 0; channel < numChannels; ++channel)
+            for(auto i = 0; i < options.blockSize; ++i)
+                noise.setSample(channel, i, random.nextFloat() * 2.0f - 1.0f);
+
+        vectorOut.makeCopyOf(noise, true);
+        scalarOut.makeCopyOf(noise, true);
+
+        auto start = juce::Time::getHighResolutionTicks();
+        vectorEq.process(vectorOut, 0, options.blockSize);
+        auto middle = juce::Time::getHighResolutionTicks();
+        scalarEq.processScalar(scalarOut, 0, options.blockSize);
+        auto end = juce::Time::getHighResolutionTicks();
+
+        vectorMs.push_back(ticksToMs(middle - start));
+        scalarMs.push_back(ticksToMs(end - middle));
+
+        for(auto channel = 0; channel < numChannels; ++channel)
+            for(auto i = 0; i < options.blockSize; ++i)
+                maxDifference = juce::jmax(maxDifference, std::abs(vectorOut.getSample(channel, i) - scalarOut.getSample(channel, i)));
+    }
+
+    auto median = [] (std::vector<double> values){
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    };
+
+    std::cout << numBlocks << " blocks of " << options.blockSize << " samples, " << numChannels << " channels, "
+              << ParametricEq::numBands << " bands" << std::endl;
+    printPercentiles("simd  ", vectorMs);
+    printPercentiles("scalar", scalarMs);
+    std::cout << "speed-up (median): " << median(scalarMs) / juce::jmax(1.0e-9, median(vectorMs))
+              << "  max difference: " << maxDifference << std::endl;
+}
+
+static int benchmarkEq(const juce::ArgumentList& args, const RenderOptions& options){
+    /*
+    * the SIMD path against the scalar reference on the same noise, with every band boosted
+    * or cut so neither takes the flat bypass. mono and stereo unless --channels picks one
+    */
+    auto numBlocks = args.containsOption("--blocks") ? juce::jmax(1, args.getValueForOption("--blocks").getIntValue()) : 20000;
+    std::vector<int> channelCounts { 1, 2 };
+
+    if(args.containsOption("--channels"))
+        channelCounts = { juce::jmax(1, args.getValueForOption("--channels").getIntValue()) };
+
+   #if JUCE_USE_SIMD
+    std::cout << "SIMD lanes: " << juce::dsp::SIMDRegister<float>::size() << std::endl;
+   #else
+    std::cout << "SIMD lanes: none, both paths are scalar" << std::endl;
+   #endif
+
+    for(auto numChannels : channelCounts)
+        benchmarkEqChannels(numChannels, numBlocks, options);
+
+    return 0;
+}
+
+static int benchmarkSeeks(const juce::ArgumentList& args, const juce::Array<juce::File>& files, const RenderOptions& options){
+    /*
+    * plays each file at device pace with realtime reads and seeks to random positions, then
+    * prints the seek-to-audio latency the playlist measured per format, from the call to
+    * seekTo(). every other seek snaps to the nearest seek point, the others are exact like a click.
+    */
+    auto numSeeks = juce::jmax(1, args.getValueForOption("--bench-seek").getIntValue());
+    auto blockMs = options.blockSize * 1000.0 / options.sampleRate;
+
+    MainContentComponent component(false);
+    component.prepareToPlay(options.blockSize, options.sampleRate);
+
+    juce::AudioBuffer<float> buffer(options.numChannels, options.blockSize);
+    juce::Random random(42);
+
+    for(auto& file : files){
+        component.loadFiles(juce::Array<juce::File> { file });
+        component.startPlayback();
+
+        auto startMs = juce::Time::getMillisecondCounterHiRes();
+        juce::int64 block = 0;
+
+        auto renderFor = [&] (double ms){
+            // paced like a device, so the read-ahead thread gets a realistic amount of time
+            for(auto end = block + (juce::int64) (ms / blockMs); block < end; ++block){
+                juce::AudioSourceChannelInfo info(&buffer, 0, options.blockSize);
+                component.getNextAudioBlock(info);
+
+                auto due = startMs + (double) (block + 1) * blockMs;
+                auto now = juce::Time::getMillisecondCounterHiRes();
+
+                if(due > now)
+                    juce::Thread::sleep((int) (due - now));
+            }
+        };
+
+        renderFor(200.0);
+
+        for(auto waited = 0; ! component.isSeekIndexComplete() && waited < 300; ++waited)
+            renderFor(100.0);
+
+        for(auto i = 0; i < numSeeks; ++i){
+            auto length = component.getLengthInSeconds();
+            component.seekTo(random.nextDouble() * juce::jmax(0.0, length - 1.0), i % 2 == 0 ? component.getSeekPointSpacing() * 0.5 : 0.0);
+            renderFor(300.0);
+        }
+    }
+
+    for(auto& stats : component.getSeekLatencyStats())
+        std::cout << stats.format << ": " << stats.seeks << " seeks (" << stats.anchoredSeeks << " on seek points), average "
+                  << stats.averageMs << " ms, max " << stats.maxMs << " ms, " << stats.withinOneBlock
+                  << " restarted within one block" << std::endl;
+
+    component.releaseResources();
+    return 0;
+}
+
+static int benchmarkPyramid(const juce::File& file){
+    /*
+    * build time of the waveform pyramid for 1, 2, 4, ... threads up to the core count,
+    * best of three runs each
+    */
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    juce::Array<int> threadCounts;
+
+    for(auto n = 1; n < juce::SystemStats::getNumCpus(); n *= 2)
+        threadCounts.add(n);
+
+    threadCounts.add(juce::SystemStats::getNumCpus());
+
+    for(auto numThreads : threadCounts){
+        auto best = std::numeric_limits<double>::max();
+
+        for(auto run = 0; run < 3; ++run){
+            WaveformPyramid pyramid(formatManager, numThreads);
+
+            if(! pyramid.build(file)){
+                std::cout << "can't read " << file.getFullPathName() << std::endl;
+                return 1;
+            }
+
+            waitFor([&pyramid] { return pyramid.isComplete() || pyramid.hasFailed(); }, 600000);
+
+            if(! pyramid.isComplete()){
+                std::cout << "can't decode " << file.getFullPathName() << std::endl;
+                return 1;
+            }
+
+            best = juce::jmin(best, pyramid.getBuildTimeMs());
+        }
+
+        std::cout << "threads " << numThreads << ": " << best << " ms" << std::endl;
+    }
+
+    return 0;
+}
+
+
+/*
+* resamples `input` from inRate to outRate, `numOutput` samples in blocks of `blockSize`.
+* `elapsedMs` gets the time spent in getNextAudioBlock()
+*/
+template <typename Resampler>
+static juce::AudioBuffer<float> resampleBuffer(Resampler& resampler, juce::AudioBuffer<float>& input, juce::MemoryAudioSource& source,
+                                               double inRate, double outRate, int numOutput, int blockSize, double& elapsedMs){
+    juce::AudioBuffer<float> output(input.getNumChannels(), numOutput);
+
+    source.setNextReadPosition(0);
+    resampler.setResamplingRatio(inRate / outRate);
+    resampler.prepareToPlay(blockSize, outRate);
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for(auto done = 0; done < numOutput; done += blockSize)
+        resampler.getNextAudioBlock(juce::AudioSourceChannelInfo(&output, done, juce::jmin(blockSize, numOutput - done)));
+
+    elapsedMs = ticksToMs(juce::Time::getHighResolutionTicks() - start);
+    resampler.releaseResources();
+    return output;
+}
+
+struct ToneResult{
+    double gainDb = 0.0;        // level of the tone in the output against the input
+    double residualDb = 0.0;    // everything else (aliases, images, noise) against the input tone
+};
+
+static ToneResult measureTone(PolyphaseResamplingSource::Quality quality, double inRate, double outRate, double frequency){
+    /*
+    * a 0.5 amplitude sine through the resampler; the output is least-squares fitted with a
+    * sine and cosine at the same frequency, skipping the filter's start-up
+    */
+    constexpr double amplitude = 0.5;
+    juce::AudioBuffer<float> input(1, (int) (inRate * 1.5));
+
+    for(auto i = 0; i < input.getNumSamples(); ++i)
+        input.setSample(0, i, (float) (amplitude * std::sin(juce::MathConstants<double>::twoPi * frequency * i / inRate)));
+
+    juce::MemoryAudioSource source(input, false);
+    PolyphaseResamplingSource resampler(&source, false, 1, quality);
+    double elapsedMs = 0.0;
+    auto output = resampleBuffer(resampler, input, source, inRate, outRate, (int) (outRate * 1.25), 512, elapsedMs);
+
+    auto first = (int) (outRate * 0.25), count = (int) outRate;
+    auto omega = juce::MathConstants<double>::twoPi * (frequency < outRate * 0.5 ? frequency : 0.0) / outRate;
+    double ss = 0.0, cc = 0.0, sc = 0.0, ys = 0.0, yc = 0.0, yy = 0.0;
+
+    for(auto i = first; i < first + count; ++i){
+        auto s = std::sin(omega * i), c = std::cos(omega * i), y = (double) output.getSample(0, i);
+        ss += s * s; cc += c * c; sc += s * c; ys += y * s; yc += y * c; yy += y * y;
+    }
+
+    // above the output Nyquist frequency nothing should come through, so all of it is residual
+    auto determinant = ss * cc - sc * sc;
+    auto a = determinant > 1.0e-9 ? (ys * cc - yc * sc) / determinant : 0.0;
+    auto b = determinant > 1.0e-9 ? (yc * ss - ys * sc) / determinant : 0.0;
+    auto toneEnergy = a * ys + b * yc;
+    auto residualRms = std::sqrt(juce::jmax(0.0, yy - toneEnergy) / count);
+    auto toDb = [] (double ratio) { return 20.0 * std::log10(juce::jmax(1.0e-12, ratio)); };
+
+    return { toDb(std::sqrt(a * a + b * b) / amplitude), toDb(residualRms / (amplitude / std::sqrt(2.0))) };
+}
+
+static int benchmarkLibrary(const juce::ArgumentList& args, const juce::Array<juce::File>& folders){
+    /*
+    * a cold scan, an incremental rescan with nothing changed and a fresh load of the index,
+    * against a temporary index file. --synthetic N first writes N short WAV files, 500 per
+    * folder, into a temporary tree that is deleted afterwards
+    */
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    auto indexFile = juce::File::createTempFile("library.index");
+    auto roots = folders;
+    juce::File syntheticRoot;
+
+    if(args.containsOption("--synthetic")){
+        auto numFiles = juce::jmax(1, args.getValueForOption("--synthetic").getIntValue());
+        syntheticRoot = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("library_bench", {});
+        juce::AudioBuffer<float> silence(2, 1024);
+        silence.clear();
+        juce::WavAudioFormat wavFormat;
+
+        for(auto i = 0; i < numFiles; ++i){
+            auto folder = syntheticRoot.getChildFile(juce::String(i / 500));
+            folder.createDirectory();
+
+            if(auto stream = folder.getChildFile(juce::String(i) + ".wav").createOutputStream()){
+                std::unique_ptr<juce::AudioFormatWriter> writer(wavFormat.createWriterFor(stream.get(), 44100.0, 2, 16, {}, 0));
+
+                if(writer != nullptr){
+                    stream.release();
+                    writer->writeFromAudioSampleBuffer(silence, 0, silence.getNumSamples());
+                }
+            }
+        }
+
+        roots.add(syntheticRoot);
+    }
+
+    if(roots.isEmpty()){
+        std::cout << "give a folder to scan or --synthetic N" << std::endl;
+        return 1;
+    }
+
+    auto report = [] (const char* name, const MediaLibrary& library){
+        auto stats = library.getStats();
+        std::cout << name << ": " << library.getSnapshot()->size() << " entries, " << stats.headersRead << " headers read, "
+                  << stats.unchanged << " unchanged, scan " << stats.scanMs << " ms, index load " << stats.loadMs << " ms" << std::endl;
+    };
+
+    {
+        MediaLibrary library(formatManager, indexFile);
+
+        for(const auto& folder : roots)
+            library.addFolder(folder);
+
+        waitFor([&library] { return ! library.isScanning(); }, 3600000);
+        report("cold scan", library);
+
+        library.rescan();
+        waitFor([&library] { return ! library.isScanning(); }, 3600000);
+        report("rescan   ", library);
+    }
+
+    MediaLibrary reloaded(formatManager, indexFile);
+
+    if(! reloaded.loadIndex()){
+        std::cout << "can't read the index back" << std::endl;
+        return 1;
+    }
+
+    report("startup  ", reloaded);
+    std::cout << "index " << indexFile.getSize() / 1024 << " KB" << std::endl;
+
+    indexFile.deleteFile();
+
+    if(syntheticRoot != juce::File{})
+        syntheticRoot.deleteRecursively();
+
+    return 0;
+}
+
+static int benchmarkLoudness(const juce::Array<juce::File>& files){
+    /*
+    * measures every file on this thread and prints its loudness, true peak and the gain the
+    * player would apply, then measures them all again through the analyser's thread pool
+    * against a temporary cache to show what the workers gain
+    */
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    double serialMs = 0.0, audioSeconds = 0.0;
+
+    for(const auto& file : files){
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+
+        if(reader == nullptr){
+            std::cout << "can't open " << file.getFullPathName() << std::endl;
+            continue;
+        }
+
+        auto startMs = juce::Time::getMillisecondCounterHiRes();
+        auto result = LoudnessAnalyser::measure(*reader);
+        auto elapsedMs = juce::Time::getMillisecondCounterHiRes() - startMs;
+
+        serialMs += elapsedMs;
+        audioSeconds += (double) reader->lengthInSamples / reader->sampleRate;
+
+        std::cout << file.getFileName() << ": " << result.integratedLufs << " LUFS, true peak " << result.truePeakDb
+                  << " dBTP, gain " << result.getGainDb() << " dB (" << elapsedMs << " ms)" << std::endl;
+    }
+
+    auto cacheFile = juce::File::createTempFile("loudness.cache");
+    auto startMs = juce::Time::getMillisecondCounterHiRes();
+
+    {
+        LoudnessAnalyser analyser(cacheFile);
+
+        for(const auto& file : files)
+            analyser.analyse(file);
+
+        waitFor([&analyser] { return ! analyser.isBusy(); }, 3600000);
+    }
+
+    auto parallelMs = juce::Time::getMillisecondCounterHiRes() - startMs;
+
+    std::cout << "serial " << serialMs << " ms, " << juce::jmax(1, juce::SystemStats::getNumCpus() / 2) << " workers "
+              << parallelMs << " ms for " << audioSeconds << " s of audio" << std::endl;
+
+    cacheFile.deleteFile();
+    return 0;
+}
+
+static int benchmarkTransport(const RenderOptions& options){
+    /*
+    * schedules play, pause, seek and stop at sample times that fall inside blocks, plays a
+    * constant signal through the transport and checks where each one landed and that no
+    * step between two output samples is larger than a fade would make it
+    */
+    const auto level = 0.5f;
+    juce::AudioBuffer<float> constant(2, (int) options.sampleRate * 10);
+
+    for(auto channel = 0; channel < 2; ++channel)
+        juce::FloatVectorOperations::fill(constant.getWritePointer(channel), level, constant.getNumSamples());
+
+    juce::MemoryAudioSource source(constant, false);
+    QueuedTransportSource transport(source);
+    transport.prepareToPlay(options.blockSize, options.sampleRate);
+
+    const juce::int64 playAt = 1001, pauseAt = 20123, resumeAt = 40007, seekAt = 60311, stopAt = 90077;
+    transport.play(playAt);
+    transport.pause(pauseAt);
+    transport.play(resumeAt);
+    transport.seek(0, seekAt);
+    transport.stop(stopAt);
+
+    auto numSamples = (int) stopAt + options.blockSize * 4;
+    juce::AudioBuffer<float> output(2, numSamples), block(2, options.blockSize);
+
+    for(auto start = 0; start < numSamples; start += options.blockSize){
+        auto samplesThisTime = juce::jmin(options.blockSize, numSamples - start);
+        transport.getNextAudioBlock(juce::AudioSourceChannelInfo(&block, 0, samplesThisTime));
+        output.copyFrom(0, start, block, 0, 0, samplesThisTime);
+
+        transport.collectEvents([] (const QueuedTransportSource::Event& event){
+            static const char* names[] = { "started", "paused", "stopped", "reached end", "seeked", "looping changed" };
+            std::cout << "  " << names[event.type] << " at sample " << event.sampleTime << ", source at " << event.position << std::endl;
+        });
+    }
+
+    const auto* samples = output.getReadPointer(0);
+    auto firstAudible = -1;
+    auto largestStep = 0.0f;
+
+    for(auto i = 0; i < numSamples; ++i){
+        if(firstAudible < 0 && samples[i] != 0.0f)
+            firstAudible = i;
+
+        if(i > 0)
+            largestStep = juce::jmax(largestStep, std::abs(samples[i] - samples[i - 1]));
+    }
+
+    auto fadeLength = juce::roundToInt(5.0 * options.sampleRate / 1000.0);
+    auto silentAfterPause = std::all_of(samples + pauseAt + fadeLength, samples + resumeAt + 1, [] (float sample) { return sample == 0.0f; });
+    auto silentAfterStop = std::all_of(samples + stopAt + fadeLength, samples + numSamples, [] (float sample) { return sample == 0.0f; });
+
+    std::cout << "play at " << playAt << ": first audible sample " << firstAudible << std::endl
+              << "silent from pause + fade to resume: " << (silentAfterPause ? "yes" : "no") << std::endl
+              << "silent from stop + fade: " << (silentAfterStop ? "yes" : "no") << std::endl
+              << "largest step between samples " << largestStep << " (a fade of " << fadeLength << " samples allows "
+              << level / (float) fadeLength << ", a hard cut would be " << level << ")" << std::endl;
+
+    transport.releaseResources();
+
+    auto passed = firstAudible == playAt + 1 && silentAfterPause && silentAfterStop && largestStep <= level / (float) fadeLength * 1.001f;
+    return passed ? 0 : 1;
+}
+
+static int benchmarkMixer(const juce::ArgumentList& args, const RenderOptions& options){
+    /*
+    * time per block of the stem mixer from 1 to 64 stereo tracks of noise held in memory,
+    * each panned and at its own gain, with the vector kernel and the scalar reference, and
+    * the largest difference between their outputs
+    */
+    auto numBlocks = args.containsOption("--blocks") ? juce::jmax(1, args.getValueForOption("--blocks").getIntValue()) : 2000;
+    juce::TimeSliceThread readAheadThread("Mixer bench");  // only needed by file tracks, so never started
+    juce::Random random(7);
+    juce::OwnedArray<juce::AudioBuffer<float>> noise;
+
+    for(auto track = 0; track < StemMixerSource::maxTracks; ++track){
+        auto* buffer = noise.add(new juce::AudioBuffer<float>(2, (int) options.sampleRate));
+
+        for(auto channel = 0; channel < 2; ++channel)
+            for(auto i = 0; i < buffer->getNumSamples(); ++i)
+                buffer->setSample(channel, i, random.nextFloat() * 2.0f - 1.0f);
+    }
+
+    std::cout << "block " << options.blockSize << ", " << numBlocks << " blocks" << std::endl;
+
+    for(auto numTracks : { 1, 2, 4, 8, 16, 32, 64 }){
+        double usPerBlock[2] = {};
+        juce::AudioBuffer<float> vectorBlock(2, options.blockSize), scalarBlock(2, options.blockSize);
+        juce::AudioBuffer<float>* lastBlock[2] = { &vectorBlock, &scalarBlock };
+
+        for(auto kernel = 0; kernel < 2; ++kernel){
+            StemMixerSource mixer(readAheadThread);
+            std::vector<std::unique_ptr<juce::PositionableAudioSource>> sources;
+
+            for(auto track = 0; track < numTracks; ++track)
+                sources.push_back(std::make_unique<juce::MemoryAudioSource>(*noise[track], false, true));
+
+            mixer.setSources(std::move(sources), 2);
+
+            for(auto track = 0; track < numTracks; ++track){
+                mixer.setTrackGain(track, 1.0f / (float) numTracks);
+                mixer.setTrackPan(track, numTracks > 1 ? -1.0f + 2.0f * (float) track / (float) (numTracks - 1) : 0.0f);
+            }
+
+            mixer.setUseVectorKernel(kernel == 0);
+            mixer.prepareToPlay(options.blockSize, options.sampleRate);
+
+            auto& buffer = *lastBlock[kernel];
+            juce::AudioSourceChannelInfo info(&buffer, 0, options.blockSize);
+            mixer.getNextAudioBlock(info);  // picks up the tracks
+
+            auto start = juce::Time::getHighResolutionTicks();
+
+            for(auto block = 0; block < numBlocks; ++block)
+                mixer.getNextAudioBlock(info);
+
+            usPerBlock[kernel] = ticksToMs(juce::Time::getHighResolutionTicks() - start) * 1000.0 / numBlocks;
+            mixer.releaseResources();
+        }
+
+        auto maxDifference = 0.0f;
+
+        for(auto channel = 0; channel < 2; ++channel)
+            for(auto i = 0; i < options.blockSize; ++i)
+                maxDifference = juce::jmax(maxDifference, std::abs(vectorBlock.getSample(channel, i) - scalarBlock.getSample(channel, i)));
+
+        std::cout << numTracks << " tracks: simd " << usPerBlock[0] << " us/block (" << usPerBlock[0] / numTracks << " us/track), scalar "
+                  << usPerBlock[1] << " us/block, " << usPerBlock[0] / (options.blockSize * 1.0e6 / options.sampleRate) * 100.0
+                  << "% of the block's time, max difference " << maxDifference << std::endl;
+    }
+
+    return 0;
+}
+
+static int benchmarkStartup(const juce::ArgumentList& args, const RenderOptions& options){
+    /*
+    * builds the player the way the app does, first with everything in the constructor, then
+    * with --fast-startup's deferred setup, and times the first painted frame (a snapshot of
+    * the component) and the first audio callback. without --device the bench plays the
+    * device and calls the first block itself. --budget-ms fails the run when the deferred
+    * first frame is slower, to catch regressions
+    */
+    auto numPasses = args.containsOption("--passes") ? juce::jmax(1, args.getValueForOption("--passes").getIntValue()) : 10;
+    auto openDevice = args.containsOption("--device");
+    auto budgetMs = args.containsOption("--budget-ms") ? args.getValueForOption("--budget-ms").getDoubleValue() : 0.0;
+    juce::SharedResourcePointer<StartupProfiler> profiler;
+    auto result = 0;
+
+    for(auto deferred : { false, true }){
+        std::vector<double> firstFrameMs, firstAudioMs;
+        std::vector<StartupProfiler::Phase> lastPhases;
+
+        for(auto pass = 0; pass < numPasses; ++pass){
+            profiler->reset();
+
+            {
+                MainContentComponent component(openDevice, deferred);
+                component.setSize(1200, 900);
+                component.createComponentSnapshot(component.getLocalBounds());
+
+                // what the message loop would do after that frame
+                component.completeStartup();
+
+                if(openDevice){
+                    waitFor([&profiler] { return profiler->getFirstAudioMs() >= 0.0; }, 10000);
+                }
+                else{
+                    juce::AudioBuffer<float> buffer(2, options.blockSize);
+                    component.prepareToPlay(options.blockSize, options.sampleRate);
+                    component.getNextAudioBlock(juce::AudioSourceChannelInfo(buffer));
+                    component.releaseResources();
+                }
+            }
+
+            firstFrameMs.push_back(profiler->getFirstFrameMs());
+            firstAudioMs.push_back(profiler->getFirstAudioMs());
+            lastPhases = profiler->getPhases();
+        }
+
+        std::cout << (deferred ? "deferred" : "immediate") << " startup, " << numPasses << " passes" << (openDevice ? "" : ", no device") << std::endl;
+        printPercentiles("  first frame", firstFrameMs);
+        printPercentiles("  first audio", firstAudioMs);
+
+        for(const auto& phase : lastPhases)
+            std::cout << "    " << phase.name << ": " << phase.ms << " ms" << std::endl;
+
+        std::sort(firstFrameMs.begin(), firstFrameMs.end());
+
+        if(deferred && budgetMs > 0.0 && firstFrameMs[firstFrameMs.size() / 2] > budgetMs){
+            std::cout << "first frame over the budget of " << budgetMs << " ms" << std::endl;
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+static int benchmarkDevice(const juce::ArgumentList& args, const juce::Array<juce::File>& files, const RenderOptions& options){
+    /*
+    * runs the player (or the looper with --app looper) on the virtual device through its own
+    * setAudioChannels(), presses play (the looper opens the file instead) and reports how
+    * long the first audible sample took to leave the device, then the glitches over
+    * --seconds. --clock manual renders the blocks on this thread and is deterministic; the
+    * realtime clock (the default) runs on the device thread, sped up by --speed
+    */
+    VirtualAudioDevice::Settings settings;
+    settings.clock = args.getValueForOption("--clock") == "manual" ? VirtualAudioDevice::Clock::manual : VirtualAudioDevice::Clock::realtime;
+    settings.sampleRate = options.sampleRate;
+    settings.bufferSize = options.blockSize;
+
+    if(args.containsOption("--speed"))
+        settings.speed = juce::jmax(0.0, args.getValueForOption("--speed").getDoubleValue());
+
+    if(args.containsOption("--block-sizes")){
+        // the largest one is the device's buffer size
+        for(const auto& size : juce::StringArray::fromTokens(args.getValueForOption("--block-sizes"), ",", {}))
+            settings.blockSizes.push_back(juce::jmax(1, size.getIntValue()));
+
+        settings.bufferSize = *std::max_element(settings.blockSizes.begin(), settings.blockSizes.end());
+    }
+
+    if(args.containsOption("--jitter-ms"))
+        settings.jitterMs = args.getValueForOption("--jitter-ms").getDoubleValue();
+
+    if(args.containsOption("--late-every"))
+        settings.lateEvery = args.getValueForOption("--late-every").getIntValue();
+
+    if(args.containsOption("--late-ms"))
+        settings.lateMs = args.getValueForOption("--late-ms").getDoubleValue();
+
+    auto isManual = settings.clock == VirtualAudioDevice::Clock::manual;
+    auto seconds = args.containsOption("--seconds") ? juce::jmax(0.1, args.getValueForOption("--seconds").getDoubleValue()) : 5.0;
+    auto leadInSeconds = 0.25;
+    settings.recordSeconds = leadInSeconds + seconds + 1.0;
+
+    std::cout << "virtual device: " << (isManual ? juce::String("manual") : "realtime x" + juce::String(settings.speed)) << " clock, "
+              << settings.sampleRate << " Hz, buffer " << settings.bufferSize << ", blocks "
+              << (settings.blockSizes.empty() ? juce::String(settings.bufferSize) : args.getValueForOption("--block-sizes"))
+              << ", jitter " << settings.jitterMs << " ms, " << settings.lateMs << " ms late every " << settings.lateEvery << " callbacks" << std::endl;
+
+    auto advance = [&] (VirtualAudioDevice& device, double secondsToRun){
+        if(! isManual){
+            juce::Thread::sleep(juce::roundToInt(secondsToRun * 1000.0 / (settings.speed > 0.0 ? settings.speed : 1.0)));
+            return;
+        }
+
+        auto end = device.getClockPosition() + (juce::int64) (secondsToRun * settings.sampleRate);
+
+        while(device.getClockPosition() < end && device.isPlaying())
+            device.process(1);
+    };
+
+    // installs the device, presses, plays, and keeps what the device saw before the component closes it
+    VirtualAudioDevice::Stats stats;
+    double latencyMs = -1.0;
+    juce::AudioBuffer<float> recording;
+
+    auto run = [&] (juce::AudioAppComponent& component, const std::function<void()>& press, const std::function<bool()>& hasStarted){
+        component.deviceManager.addAudioDeviceType(std::make_unique<VirtualAudioDeviceType>(settings));
+        component.deviceManager.setCurrentAudioDeviceType(VirtualAudioDeviceType::typeName, true);
+        component.setAudioChannels(0, 2);
+
+        auto* device = dynamic_cast<VirtualAudioDevice*>(component.deviceManager.getCurrentAudioDevice());
+
+        if(device == nullptr)
+            return false;
+
+        // some silence first, so the press lands on a running device
+        advance(*device, leadInSeconds);
+
+        auto pressPosition = device->getClockPosition();
+        press();
+
+        // the manual clock stands still while the looper loads, so only the audio path is timed
+        if(isManual)
+            waitFor(hasStarted, 10000);
+
+        advance(*device, seconds);
+
+        stats = device->getStats();
+        latencyMs = device->getLatencyMs(pressPosition);
+        recording.makeCopyOf(device->getRecording());
+        recording.setSize(recording.getNumChannels(), (int) device->getNumRecordedSamples(), true);
+
+        component.shutdownAudio();
+        return true;
+    };
+
+    auto opened = false;
+
+    if(args.getValueForOption("--app") == "looper"){
+        AudioLoopingComponent component(false);
+        component.setNonRealtime(isManual);
+        opened = run(component, [&] { component.openFile(files.getFirst()); }, [&] { return component.isFileLoaded(); });
+    }
+    else{
+        MainContentComponent component(false);
+        component.setNonRealtime(isManual);
+        component.loadFiles(files);
+        waitFor([&component] { return component.isWaveformComplete(); }, 60000);
+        opened = run(component, [&] { component.startPlayback(); }, [&] { return component.isPlaying(); });
+    }
+
+    if(! opened){
+        std::cout << "can't open the virtual device" << std::endl;
+        return 1;
+    }
+
+    if(latencyMs >= 0.0)
+        std::cout << "press to first audible output: " << latencyMs << " ms (includes " << settings.bufferSize * 1000.0 / settings.sampleRate
+                  << " ms of output latency)" << std::endl;
+    else
+        std::cout << "nothing audible after the press" << std::endl;
+
+    std::cout << stats.callbacks << " callbacks, " << stats.glitches << " glitches (" << stats.ownGlitches << " from the callback itself, "
+              << stats.forcedLate << " callbacks forced late), max callback " << stats.maxCallbackMs << " ms, max lateness "
+              << stats.maxLatenessMs << " ms" << std::endl;
+
+    if(options.output != juce::File{}){
+        options.output.deleteFile();
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+
+        if(auto stream = options.output.createOutputStream()){
+            writer.reset(juce::WavAudioFormat().createWriterFor(stream.get(), settings.sampleRate, (unsigned int) recording.getNumChannels(), 32, {}, 0));
+
+            if(writer != nullptr)
+                stream.release();
+        }
+
+        if(writer == nullptr || ! writer->writeFromAudioSampleBuffer(recording, 0, recording.getNumSamples()))
+            std::cout << "can't write " << options.output.getFullPathName() << std::endl;
+    }
+
+    return args.containsOption("--fail-on-glitch") && stats.ownGlitches > 0 ? 4 : 0;
+}
+
+static int benchmarkResampler(const RenderOptions& options){
+    /*
+    * per quality tier and rate pair: CPU time per second of stereo output (SIMD kernel,
+    * scalar kernel and juce::ResamplingAudioSource for reference), the passband deviation
+    * and worst residual over a set of tones, and for downsampling the rejection of tones
+    * that would alias
+    */
+    using Quality = PolyphaseResamplingSource::Quality;
+    const std::vector<std::pair<double, double>> ratePairs { { 44100.0, 48000.0 }, { 48000.0, 44100.0 }, { 96000.0, 48000.0 }, { 44100.0, 96000.0 } };
+    constexpr double seconds = 10.0;
+
+    for(const auto& [inRate, outRate] : ratePairs){
+        juce::AudioBuffer<float> noise(2, (int) (inRate * (seconds + 1.0)));
+        juce::Random random(99);
+
+        for(auto channel = 0; channel < 2; ++channel)
+            for(auto i = 0; i < noise.getNumSamples(); ++i)
+                noise.setSample(channel, i, random.nextFloat() * 2.0f - 1.0f);
+
+        juce::MemoryAudioSource source(noise, false);
+        auto numOutput = (int) (outRate * seconds);
+        double elapsedMs = 0.0;
+
+        {
+            juce::ResamplingAudioSource reference(&source, false, 2);
+            resampleBuffer(reference, noise, source, inRate, outRate, numOutput, options.blockSize, elapsedMs);
+        }
+
+        std::cout << inRate << " Hz -> " << outRate << " Hz  (juce::ResamplingAudioSource " << elapsedMs / seconds << " ms per second)" << std::endl;
+
+        for(auto quality : { Quality::draft, Quality::standard, Quality::mastering }){
+            auto spec = PolyphaseResamplingSource::getSpec(quality);
+            PolyphaseResamplingSource resampler(&source, false, 2, quality);
+            double vectorMs = 0.0, scalarMs = 0.0;
+
+            auto vectorOut = resampleBuffer(resampler, noise, source, inRate, outRate, numOutput, options.blockSize, vectorMs);
+            resampler.setUseVectorKernel(false);
+            auto scalarOut = resampleBuffer(resampler, noise, source, inRate, outRate, numOutput, options.blockSize, scalarMs);
+
+            float maxDifference = 0.0f;
+
+            for(auto channel = 0; channel < 2; ++channel)
+                for(auto i = 0; i < numOutput; ++i)
+                    maxDifference = juce::jmax(maxDifference, std::abs(vectorOut.getSample(channel, i) - scalarOut.getSample(channel, i)));
+
+            // passband: up to 95% of the filter's cutoff or 20 kHz
+            auto passbandEdge = juce::jmin(20000.0, 0.95 * PolyphaseResamplingSource::getCutoff(spec) * juce::jmin(inRate, outRate) * 0.5);
+            double minGain = 0.0, maxGain = -1000.0, worstResidual = -1000.0;
+
+            for(auto frequency : { 20.0, 100.0, 1000.0, 5000.0, 10000.0, 15000.0, passbandEdge }){
+                if(frequency > passbandEdge)
+                    continue;
+
+                auto tone = measureTone(quality, inRate, outRate, frequency);
+                minGain = juce::jmin(minGain, tone.gainDb);
+                maxGain = juce::jmax(maxGain, tone.gainDb);
+                worstResidual = juce::jmax(worstResidual, tone.residualDb);
+            }
+
+            std::cout << "  " << PolyphaseResamplingSource::getQualityName(quality)
+                      << " (" << spec.taps << " taps, " << spec.phases << " phases): simd " << vectorMs / seconds
+                      << " ms/s, scalar " << scalarMs / seconds << " ms/s, max difference " << maxDifference << std::endl
+                      << "    passband to " << juce::roundToInt(passbandEdge) << " Hz: " << minGain << " .. " << maxGain
+                      << " dB, worst residual " << worstResidual << " dB" << std::endl;
+
+            if(outRate < inRate){
+                // tones between the new and the old Nyquist frequency must not fold back
+                auto worstAlias = -1000.0;
+
+                for(auto fraction : { 0.55, 0.65, 0.8, 0.95 }){
+                    auto frequency = outRate * 0.5 + fraction * (inRate - outRate) * 0.5;
+                    worstAlias = juce::jmax(worstAlias, measureTone(quality, inRate, outRate, frequency).residualDb);
+                }
+
+                std::cout << "    worst alias above " << juce::roundToInt(outRate * 0.5) << " Hz: " << worstAlias << " dB" << std::endl;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*
+
+                            BATCH RENDER
+
+*/
+
+static std::atomic<BatchRenderer*> batchToCancel { nullptr };
+
+static void cancelBatch(int){
+    // only touches an atomic, which is all a signal handler may do
+    if(auto* renderer = batchToCancel.load())
+        renderer->cancel();
+}
+
+static int renderBatch(const juce::ArgumentList& args, const juce::Array<juce::File>& files, const RenderOptions& renderOptions){
+    /*
+    * renders every file through the player's chain into the --batch folder, a file per
+    * worker, and prints each file's speed as it finishes and the totals at the end.
+    * Ctrl-C cancels: files in progress stop at their next block and are not written.
+    */
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    BatchRenderer::Options options;
+    options.outputFolder = args.getFileForOption("--batch");
+    options.format = args.getValueForOption("--format") == "flac" ? BatchRenderer::Format::flac : BatchRenderer::Format::wav;
+    options.normalise = args.containsOption("--normalise");
+    options.blockSize = juce::jmax(256, renderOptions.blockSize);
+
+    if(args.containsOption("--bits"))
+        options.bitsPerSample = args.getValueForOption("--bits").getIntValue();
+
+    if(args.containsOption("--rate"))
+        options.sampleRate = renderOptions.sampleRate;
+
+    if(args.containsOption("--threads"))
+        options.numThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+
+    if(args.containsOption("--level"))
+        options.level = args.getValueForOption("--level").getFloatValue();
+
+    if(args.containsOption("--resampling")){
+        auto name = args.getValueForOption("--resampling");
+        options.quality = name == "draft" ? PolyphaseResamplingSource::Quality::draft
+                        : name == "mastering" ? PolyphaseResamplingSource::Quality::mastering
+                                              : PolyphaseResamplingSource::Quality::standard;
+    }
+
+    if(args.containsOption("--eq"))
+        for(auto band = 0; band < ParametricEq::numBands; ++band)
+            options.eqGainsDb[(size_t) band] = (band % 2 == 0 ? 1.0f : -1.0f) * args.getValueForOption("--eq").getFloatValue();
+
+    if(args.containsOption("--loop")){
+        // start:end in seconds
+        auto range = args.getValueForOption("--loop");
+        options.loopSeconds = { range.upToFirstOccurrenceOf(":", false, false).getDoubleValue(),
+                                range.fromFirstOccurrenceOf(":", false, false).getDoubleValue() };
+    }
+
+    if(args.containsOption("--loops"))
+        options.loops = juce::jmax(1, args.getValueForOption("--loops").getIntValue());
+
+    // the same cache as the player, so files it has measured are not measured again
+    juce::SharedResourcePointer<LoudnessAnalyser> loudness;
+    BatchRenderer renderer(formatManager, &loudness.getObject());
+    juce::CriticalSection printLock;
+
+    std::cout << files.size() << " files to " << options.outputFolder.getFullPathName() << " with " << options.numThreads << " threads" << std::endl;
+
+    batchToCancel = &renderer;
+    auto previousHandler = std::signal(SIGINT, cancelBatch);
+    auto startMs = juce::Time::getMillisecondCounterHiRes();
+
+    auto results = renderer.run(files, options, [&printLock] (const BatchRenderer::FileResult& result){
+        const juce::ScopedLock sl(printLock);
+        std::cout << result.input.getFileName() << ": ";
+
+        if(result.status == BatchRenderer::FileResult::Status::written)
+            std::cout << result.audioSeconds << " s in " << result.renderMs << " ms ("
+                      << result.audioSeconds * 1000.0 / juce::jmax(0.001, result.renderMs) << "x realtime) -> " << result.output.getFileName() << std::endl;
+        else if(result.status == BatchRenderer::FileResult::Status::failed)
+            std::cout << result.error << std::endl;
+        else
+            std::cout << "cancelled" << std::endl;
+    });
+
+    auto elapsedMs = juce::Time::getMillisecondCounterHiRes() - startMs;
+    std::signal(SIGINT, previousHandler);
+    batchToCancel = nullptr;
+
+    auto numWritten = 0, numFailed = 0, numCancelled = 0;
+    double audioSeconds = 0.0;
+    juce::int64 bytesWritten = 0;
+
+    for(const auto& result : results){
+        numWritten += result.status == BatchRenderer::FileResult::Status::written ? 1 : 0;
+        numFailed += result.status == BatchRenderer::FileResult::Status::failed ? 1 : 0;
+        numCancelled += result.status == BatchRenderer::FileResult::Status::cancelled ? 1 : 0;
+        audioSeconds += result.audioSeconds;
+        bytesWritten += result.bytesWritten;
+    }
+
+    std::cout << numWritten << " written, " << numFailed << " failed, " << numCancelled << " cancelled: "
+              << audioSeconds << " s of audio in " << elapsedMs << " ms, " << audioSeconds * 1000.0 / juce::jmax(0.001, elapsedMs)
+              << "x realtime, " << (double) bytesWritten / (1024.0 * 1024.0) / juce::jmax(0.001, elapsedMs / 1000.0) << " MB/s written" << std::endl;
+
+    return numFailed > 0 || numCancelled > 0 ? 3 : 0;
+}
+
+/*
+
+                            MAIN
+
+*/
+
+int main(int argc, char* argv[]){
+    // the components are never put on screen, but they still need the message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    static const juce::StringArray optionsWithValue { "--app", "--block", "--rate", "--seconds", "--output", "--compare",
+                                                      "--reader", "--eq", "--read-ahead-ms", "--crossfade-ms", "--level",
+                                                      "--channels", "--blocks", "--bench-pyramid", "--bench-seek", "--resampling",
+                                                      "--cache-mb", "--cache-storage", "--passes", "--synthetic", "--batch", "--format",
+                                                      "--bits", "--threads", "--loop", "--loops", "--budget-ms", "--clock",
+                                                      "--speed", "--block-sizes", "--jitter-ms", "--late-every", "--late-ms" };
+    juce::Array<juce::File> files;
+
+    for(auto i = 0; i < args.size(); ++i){
+        auto& argument = args[i];
+
+        if(! argument.isOption() && (i == 0 || ! optionsWithValue.contains(args[i - 1].text)))
+            files.add(argument.resolveAsFile());
+    }
+
+    RenderOptions options;
+
+    if(args.containsOption("--block"))
+        options.blockSize = juce::jmax(16, args.getValueForOption("--block").getIntValue());
+
+    if(args.containsOption("--rate"))
+        options.sampleRate = juce::jmax(8000.0, args.getValueForOption("--rate").getDoubleValue());
+
+    if(args.containsOption("--output"))
+        options.output = args.getFileForOption("--output");
+
+    if(args.containsOption("--compare"))
+        options.reference = args.getFileForOption("--compare");
+
+    options.failOnAllocation = args.containsOption("--no-alloc");
+
+    if(args.containsOption("--bench-eq"))
+        return benchmarkEq(args, options);
+
+    if(args.containsOption("--bench-pyramid"))
+        return benchmarkPyramid(args.getFileForOption("--bench-pyramid"));
+
+    if(args.containsOption("--bench-resampler"))
+        return benchmarkResampler(options);
+
+    if(args.containsOption("--bench-transport"))
+        return benchmarkTransport(options);
+
+    if(args.containsOption("--bench-mixer"))
+        return benchmarkMixer(args, options);
+
+    if(args.containsOption("--bench-startup"))
+        return benchmarkStartup(args, options);
+
+    if(args.containsOption("--bench-library"))
+        return benchmarkLibrary(args, files);
+
+    if(args.containsOption("--bench-loudness") && ! files.isEmpty())
+        return benchmarkLoudness(files);
+
+    if(args.containsOption("--bench-device") && ! files.isEmpty())
+        return benchmarkDevice(args, files, options);
+
+    if(args.containsOption("--batch") && ! files.isEmpty())
+        return renderBatch(args, files, options);
+
+    if(args.containsOption("--bench-seek") && ! files.isEmpty())
+        return benchmarkSeeks(args, files, options);
+
+    if(files.isEmpty() || args.containsOption("--help|-h")){
+        std::cout << "usage: " << args.executableName << " [--app player|looper] file.wav [more.wav ...] [--block N] [--rate Hz]" << std::endl
+                  << "       [--seconds N] [--output out.wav] [--compare reference.wav] [--reader mapped|stream] [--eq dB]" << std::endl
+                  << "       [--read-ahead-ms N] [--crossfade-ms N] [--level 0..1] [--resampling draft|standard|mastering]" << std::endl
+                  << "       [--realtime-reads] [--no-alloc] [--cache-mb N] [--cache-storage raw|packed|int16] [--passes N]" << std::endl
+                  << "       [--no-analyser] [--normalise] [--stems]" << std::endl
+                  << "   or: " << args.executableName << " --bench-eq [--channels N] [--blocks N] [--block N]" << std::endl
+                  << "   or: " << args.executableName << " --bench-pyramid file.wav" << std::endl
+                  << "   or: " << args.executableName << " --bench-seek N file.flac [file.ogg ...]" << std::endl
+                  << "   or: " << args.executableName << " --bench-resampler [--block N]" << std::endl
+                  << "   or: " << args.executableName << " --bench-library [folder ...] [--synthetic N]" << std::endl
+                  << "   or: " << args.executableName << " --bench-loudness file.flac [more ...]" << std::endl
+                  << "   or: " << args.executableName << " --bench-transport [--block N]" << std::endl
+                  << "   or: " << args.executableName << " --bench-mixer [--block N] [--blocks N]" << std::endl
+                  << "   or: " << args.executableName << " --bench-startup [--passes N] [--device] [--budget-ms N]" << std::endl
+                  << "   or: " << args.executableName << " --bench-device file.wav [--app player|looper] [--clock realtime|manual] [--speed N]" << std::endl
+                  << "       [--rate Hz] [--block N] [--block-sizes 64,512,...] [--jitter-ms N] [--late-every N] [--late-ms N]" << std::endl
+                  << "       [--seconds N] [--output out.wav] [--fail-on-glitch]" << std::endl
+                  << "   or: " << args.executableName << " --batch out-folder file.flac [more ...] [--format wav|flac] [--bits N] [--rate Hz]" << std::endl
+                  << "       [--threads N] [--normalise] [--level 0..1] [--eq dB] [--resampling draft|standard|mastering]" << std::endl
+                  << "       [--loop start:end] [--loops N] [--block N]" << std::endl;
+        return files.isEmpty() ? 1 : 0;
+    }
+
+    // the decoded audio cache outlives the components, so later passes reopen the same files from memory
+    juce::SharedResourcePointer<DecodedAudioCache> cache;
+    configureCache(*cache, args);
+
+    auto isLooper = args.getValueForOption("--app") == "looper";
+    auto numPasses = args.containsOption("--passes") ? juce::jmax(1, args.getValueForOption("--passes").getIntValue()) : 1;
+
+    if(args.containsOption("--seconds") || isLooper)
+        options.maxSeconds = args.containsOption("--seconds") ? args.getValueForOption("--seconds").getDoubleValue() : 30.0;
+
+    for(auto pass = 0; pass < numPasses; ++pass){
+        if(numPasses > 1)
+            std::cout << "pass " << pass + 1 << " of " << numPasses << std::endl;
+
+        auto result = isLooper ? renderLooper(args, files.getFirst(), options) : renderPlayer(args, files, options);
+
+        if(result != 0)
+            return result;
+    }
+
+    return 0;
+}
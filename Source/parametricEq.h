@@ -0,0 +1,414 @@
+/*
+  ==============================================================================
+
+    parametricEq.h
+    Created: 17 Oct 2026 12:16:00am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <vector>
+
+/*
+* Eight-band parametric EQ (low shelf, six peaks, high shelf) made of cascaded biquads.
+*
+* The message thread only writes band parameters into atomics. The audio thread smooths
+* them and recomputes the coefficients every subBlockSize samples while they move, so
+* changes are click-free and no lock is ever shared with the UI.
+*
+* process() vectorises each biquad across time rather than across channels, so mono and
+* stereo fill every lane. It works straight on the channel pointers, one register's worth
+* of samples at a time. The block's outputs come from the filter state and its inputs
+* through the filter's first impulse-response taps, and the state jumps a whole block
+* ahead. Those matrices are rebuilt whenever a band's coefficients change.
+* processScalar() is the plain per-sample reference used to check and benchmark it. Both
+* paths keep the same transposed direct form II state. Builds without JUCE_USE_SIMD
+* always take the scalar path.
+*/
+class ParametricEq
+{
+    public:
+        static constexpr int numBands = 8;
+        static constexpr int subBlockSize = 32;
+
+        enum class BandType{ lowShelf, peak, highShelf };
+
+        ParametricEq(){
+            static constexpr float defaultFrequencies[numBands] = { 60.0f, 150.0f, 400.0f, 1000.0f, 2500.0f, 5000.0f, 8000.0f, 12000.0f };
+
+            for(auto band = 0; band < numBands; ++band){
+                bands_[(size_t) band].type = band == 0 ? BandType::lowShelf
+                                           : band == numBands - 1 ? BandType::highShelf
+                                           : BandType::peak;
+                bands_[(size_t) band].frequency = defaultFrequencies[band];
+            }
+        }
+
+        static juce::String getBandName(int band){
+            static const char* names[numBands] = { "60", "150", "400", "1k", "2.5k", "5k", "8k", "12k" };
+            return names[juce::jlimit(0, numBands - 1, band)];
+        }
+
+        /*
+
+                                    MESSAGE THREAD
+
+        */
+
+        void setBand(int band, float frequency, float gainDb, float q){
+            auto& b = bands_[(size_t) juce::jlimit(0, numBands - 1, band)];
+            b.frequency = juce::jlimit(20.0f, 20000.0f, frequency);
+            b.gainDb = juce::jlimit(-24.0f, 24.0f, gainDb);
+            b.q = juce::jlimit(0.1f, 18.0f, q);
+        }
+
+        void setBandGain(int band, float gainDb){
+            bands_[(size_t) juce::jlimit(0, numBands - 1, band)].gainDb = juce::jlimit(-24.0f, 24.0f, gainDb);
+        }
+
+        /*
+
+                                    AUDIO THREAD
+
+        */
+
+        void prepare(double sampleRate, int maximumBlockSize, int numChannels){
+            sampleRate_ = sampleRate;
+            numChannels_ = juce::jmax(1, numChannels);
+
+            juce::ignoreUnused(maximumBlockSize); // the cascade works in sub-blocks, so the scratch never depends on it
+            scalarState_.assign((size_t) (numChannels_ * numBands), ScalarState());
+
+            for(auto& b : bands_){
+                b.smoothedFrequency.reset(sampleRate, 0.05);
+                b.smoothedGain.reset(sampleRate, 0.05);
+                b.smoothedQ.reset(sampleRate, 0.05);
+                b.smoothedFrequency.setCurrentAndTargetValue(b.frequency.load());
+                b.smoothedGain.setCurrentAndTargetValue(b.gainDb.load());
+                b.smoothedQ.setCurrentAndTargetValue(b.q.load());
+                setCoefficients_(b, makeCoefficients_(b.type, b.frequency.load(), b.gainDb.load(), b.q.load()));
+            }
+        }
+
+        void reset(){
+            std::fill(scalarState_.begin(), scalarState_.end(), ScalarState());
+        }
+
+        /* vectorised path: a register's worth of samples per step */
+        void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples){
+           #if JUCE_USE_SIMD
+            processSubBlocks_(buffer, startSample, numSamples, true);
+           #else
+            processSubBlocks_(buffer, startSample, numSamples, false);
+           #endif
+        }
+
+        /* scalar reference with identical coefficients and smoothing */
+        void processScalar(juce::AudioBuffer<float>& buffer, int startSample, int numSamples){
+            processSubBlocks_(buffer, startSample, numSamples, false);
+        }
+
+    private:
+       #if JUCE_USE_SIMD
+        using Vec = juce::dsp::SIMDRegister<float>;
+        static constexpr int lanes = (int) Vec::size();
+
+        /*
+        * one biquad over `lanes` samples at once. with state s = (z1, z2) and inputs x[j]:
+        *   y[k]   = p1[k] z1 + p2[k] z2 + sum over j <= k of h[k - j] x[j]
+        *   s_next = e s + sum over j of f[j] x[j]
+        * outputs[j] holds h[k - j] in lane k, 0 where k < j
+        */
+        struct BlockCoefficients{
+            Vec p1 = Vec::expand(0.0f), p2 = Vec::expand(0.0f);
+            std::array<Vec, (size_t) lanes> outputs;
+            float e11 = 1.0f, e12 = 0.0f, e21 = 0.0f, e22 = 1.0f;
+            std::array<float, (size_t) lanes> f1 {}, f2 {};
+        };
+       #endif
+
+        struct Coefficients{
+            float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+        };
+
+        struct Band{
+            BandType type = BandType::peak;
+            std::atomic<float> frequency { 1000.0f }, gainDb { 0.0f }, q { 0.707f };
+
+            juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> smoothedFrequency { 1000.0f };
+            juce::SmoothedValue<float> smoothedGain { 0.0f };
+            juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> smoothedQ { 0.707f };
+            Coefficients coefficients;
+           #if JUCE_USE_SIMD
+            BlockCoefficients block;
+           #endif
+        };
+
+        struct ScalarState{ float z1 = 0.0f, z2 = 0.0f; };
+
+        std::array<Band, numBands> bands_;
+        double sampleRate_ = 44100.0;
+        int numChannels_ = 2;
+        bool wasFlat_ = true;
+        std::vector<ScalarState> scalarState_;     // shared by both paths, one per channel and band
+
+        void processSubBlocks_(juce::AudioBuffer<float>& buffer, int startSample, int numSamples, bool vectorised){
+            auto numChannels = juce::jmin(numChannels_, buffer.getNumChannels());
+            juce::ignoreUnused(vectorised);
+
+            if(scalarState_.empty() || numChannels == 0)
+                return;
+
+            while(numSamples > 0){
+                auto samplesThisTime = juce::jmin(numSamples, subBlockSize);
+                auto changed = updateCoefficients_(samplesThisTime);
+                auto flat = ! changed && isFlat_();
+
+                // a flat EQ is bypassed; its filters restart from silence when a band moves again
+                if(wasFlat_ && ! flat)
+                    reset();
+
+                wasFlat_ = flat;
+
+                if(! flat){
+                   #if JUCE_USE_SIMD
+                    if(vectorised)
+                        processVectorised_(buffer, numChannels, startSample, samplesThisTime);
+                    else
+                   #endif
+                        processScalar_(buffer, numChannels, startSample, samplesThisTime);
+                }
+
+                startSample += samplesThisTime;
+                numSamples -= samplesThisTime;
+            }
+        }
+
+        bool updateCoefficients_(int numSamples){
+            /*
+            * pick up new targets from the UI and advance the smoothers; coefficients are only
+            * recomputed for bands that are still moving. returns true if any band changed.
+            */
+            auto anyChanged = false;
+
+            for(auto& b : bands_){
+                b.smoothedFrequency.setTargetValue(b.frequency.load(std::memory_order_relaxed));
+                b.smoothedGain.setTargetValue(b.gainDb.load(std::memory_order_relaxed));
+                b.smoothedQ.setTargetValue(b.q.load(std::memory_order_relaxed));
+
+                if(b.smoothedFrequency.isSmoothing() || b.smoothedGain.isSmoothing() || b.smoothedQ.isSmoothing()){
+                    setCoefficients_(b, makeCoefficients_(b.type,
+                                                          b.smoothedFrequency.skip(numSamples),
+                                                          b.smoothedGain.skip(numSamples),
+                                                          b.smoothedQ.skip(numSamples)));
+                    anyChanged = true;
+                }
+            }
+
+            return anyChanged;
+        }
+
+        bool isFlat_() const{
+            for(auto& b : bands_)
+                if(std::abs(b.smoothedGain.getCurrentValue()) > 1.0e-3f)
+                    return false;
+
+            return true;
+        }
+
+        Coefficients makeCoefficients_(BandType type, float frequency, float gainDb, float q) const{
+            // RBJ audio EQ cookbook, normalised so a0 == 1
+            auto A = std::pow(10.0, gainDb / 40.0);
+            auto w0 = juce::MathConstants<double>::twoPi * juce::jmin((double) frequency, sampleRate_ * 0.49) / sampleRate_;
+            auto cosW0 = std::cos(w0);
+            auto alpha = std::sin(w0) / (2.0 * q);
+            double b0, b1, b2, a0, a1, a2;
+
+            switch(type){
+                case BandType::lowShelf:{
+                    auto sqrtA = 2.0 * std::sqrt(A) * alpha;
+                    b0 = A * ((A + 1.0) - (A - 1.0) * cosW0 + sqrtA);
+                    b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosW0);
+                    b2 = A * ((A + 1.0) - (A - 1.0) * cosW0 - sqrtA);
+                    a0 = (A + 1.0) + (A - 1.0) * cosW0 + sqrtA;
+                    a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosW0);
+                    a2 = (A + 1.0) + (A - 1.0) * cosW0 - sqrtA;
+                    break;
+                }
+                case BandType::highShelf:{
+                    auto sqrtA = 2.0 * std::sqrt(A) * alpha;
+                    b0 = A * ((A + 1.0) + (A - 1.0) * cosW0 + sqrtA);
+                    b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosW0);
+                    b2 = A * ((A + 1.0) + (A - 1.0) * cosW0 - sqrtA);
+                    a0 = (A + 1.0) - (A - 1.0) * cosW0 + sqrtA;
+                    a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosW0);
+                    a2 = (A + 1.0) - (A - 1.0) * cosW0 - sqrtA;
+                    break;
+                }
+                case BandType::peak:
+                default:{
+                    b0 = 1.0 + alpha * A;
+                    b1 = -2.0 * cosW0;
+                    b2 = 1.0 - alpha * A;
+                    a0 = 1.0 + alpha / A;
+                    a1 = -2.0 * cosW0;
+                    a2 = 1.0 - alpha / A;
+                    break;
+                }
+            }
+
+            return { (float) (b0 / a0), (float) (b1 / a0), (float) (b2 / a0), (float) (a1 / a0), (float) (a2 / a0) };
+        }
+
+        void setCoefficients_(Band& b, const Coefficients& k){
+            b.coefficients = k;
+           #if JUCE_USE_SIMD
+            b.block = makeBlockCoefficients_(k);
+           #endif
+        }
+
+       #if JUCE_USE_SIMD
+        static BlockCoefficients makeBlockCoefficients_(const Coefficients& k){
+            /*
+            * the biquad as a state-space system: s' = A s + B x, y = C s + D x, with
+            * A = [-a1 1; -a2 0], B = (b1 - a1 b0, b2 - a2 b0), C = (1 0) and D = b0.
+            * worked out in double, the block is only as exact as the per-sample path
+            */
+            const double a1 = k.a1, a2 = k.a2, b0 = k.b0;
+            const double B1 = k.b1 - a1 * b0, B2 = k.b2 - a2 * b0;
+
+            alignas(Vec) float p1[lanes], p2[lanes];
+            double impulse[lanes];
+            double row1 = 1.0, row2 = 0.0;          // C A^n
+            double column1 = B1, column2 = B2;      // A^n B
+            std::array<double, (size_t) lanes> columns1 {}, columns2 {};
+            impulse[0] = b0;
+
+            for(auto n = 0; n < lanes; ++n){
+                p1[n] = (float) row1;
+                p2[n] = (float) row2;
+
+                if(n + 1 < lanes)
+                    impulse[n + 1] = row1 * B1 + row2 * B2;
+
+                columns1[(size_t) n] = column1;
+                columns2[(size_t) n] = column2;
+
+                auto nextRow1 = -a1 * row1 - a2 * row2;
+                row2 = row1;
+                row1 = nextRow1;
+
+                auto nextColumn1 = -a1 * column1 + column2;
+                column2 = -a2 * column1;
+                column1 = nextColumn1;
+            }
+
+            BlockCoefficients block;
+            block.p1 = Vec::fromRawArray(p1);
+            block.p2 = Vec::fromRawArray(p2);
+
+            for(auto j = 0; j < lanes; ++j){
+                alignas(Vec) float taps[lanes];
+
+                for(auto n = 0; n < lanes; ++n)
+                    taps[n] = n >= j ? (float) impulse[n - j] : 0.0f;
+
+                block.outputs[(size_t) j] = Vec::fromRawArray(taps);
+
+                // input j reaches the end of the block through lanes - 1 - j more steps
+                block.f1[(size_t) j] = (float) columns1[(size_t) (lanes - 1 - j)];
+                block.f2[(size_t) j] = (float) columns2[(size_t) (lanes - 1 - j)];
+            }
+
+            // A^lanes, by squaring up from A; lanes is a power of two
+            double e11 = -a1, e12 = 1.0, e21 = -a2, e22 = 0.0;
+
+            for(auto power = 1; power < lanes; power *= 2){
+                auto m11 = e11 * e11 + e12 * e21, m12 = e11 * e12 + e12 * e22;
+                auto m21 = e21 * e11 + e22 * e21, m22 = e21 * e12 + e22 * e22;
+                e11 = m11; e12 = m12; e21 = m21; e22 = m22;
+            }
+
+            block.e11 = (float) e11;
+            block.e12 = (float) e12;
+            block.e21 = (float) e21;
+            block.e22 = (float) e22;
+            return block;
+        }
+
+        void processVectorised_(juce::AudioBuffer<float>& buffer, int numChannels, int startSample, int numSamples){
+            alignas(Vec) float y[lanes];
+
+            for(auto channel = 0; channel < numChannels; ++channel){
+                auto* samples = buffer.getWritePointer(channel, startSample);
+
+                for(auto band = 0; band < numBands; ++band){
+                    const auto& k = bands_[(size_t) band].coefficients;
+                    const auto& block = bands_[(size_t) band].block;
+                    auto& state = scalarState_[(size_t) (channel * numBands + band)];
+                    auto z1 = state.z1, z2 = state.z2;
+                    auto i = 0;
+
+                    for(; i + lanes <= numSamples; i += lanes){
+                        auto out = Vec::expand(z1) * block.p1 + Vec::expand(z2) * block.p2;
+                        auto nextZ1 = block.e11 * z1 + block.e12 * z2;
+                        auto nextZ2 = block.e21 * z1 + block.e22 * z2;
+
+                        for(auto j = 0; j < lanes; ++j){
+                            auto x = samples[i + j];
+                            out += Vec::expand(x) * block.outputs[(size_t) j];
+                            nextZ1 += block.f1[(size_t) j] * x;
+                            nextZ2 += block.f2[(size_t) j] * x;
+                        }
+
+                        out.copyToRawArray(y);
+                        std::copy(y, y + lanes, samples + i);
+                        z1 = nextZ1;
+                        z2 = nextZ2;
+                    }
+
+                    // a sub-block that isn't a whole number of registers finishes one sample at a time
+                    for(; i < numSamples; ++i){
+                        auto x = samples[i];
+                        auto out = k.b0 * x + z1;
+                        z1 = k.b1 * x - k.a1 * out + z2;
+                        z2 = k.b2 * x - k.a2 * out;
+                        samples[i] = out;
+                    }
+
+                    state.z1 = z1;
+                    state.z2 = z2;
+                }
+            }
+        }
+       #endif
+
+        void processScalar_(juce::AudioBuffer<float>& buffer, int numChannels, int startSample, int numSamples){
+            for(auto channel = 0; channel < numChannels; ++channel){
+                auto* samples = buffer.getWritePointer(channel, startSample);
+
+                for(auto band = 0; band < numBands; ++band){
+                    const auto& k = bands_[(size_t) band].coefficients;
+                    auto& state = scalarState_[(size_t) (channel * numBands + band)];
+                    auto z1 = state.z1, z2 = state.z2;
+
+                    for(auto i = 0; i < numSamples; ++i){
+                        auto x = samples[i];
+                        auto y = k.b0 * x + z1;
+                        z1 = k.b1 * x - k.a1 * y + z2;
+                        z2 = k.b2 * x - k.a2 * y;
+                        samples[i] = y;
+                    }
+
+                    state.z1 = z1;
+                    state.z2 = z2;
+                }
+            }
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParametricEq)
+};
@@ -0,0 +1,758 @@
+/*
+  ==============================================================================
+
+    playlistSource.h
+    Created: 17 Oct 2026 12:13:40am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include "readAheadSource.h"
+#include "mappedWavReader.h"
+#include "seekIndex.h"
+#include "polyphaseResampler.h"
+#include "preparedHandoff.h"
+
+/*
+* Plays a queue of files back to back without a gap.
+*
+* A loader thread opens each upcoming file, wraps it in a read-ahead buffer and a
+* polyphase resampler to the device rate, prefills it and hands it to the audio thread through an
+* atomic pointer. The audio thread switches to it at the exact sample where the current
+* track ends (optionally crossfading over the last few milliseconds) and hands finished
+* tracks back through a lock-free FIFO, so no file is opened or freed on the audio thread.
+*
+* Positions and lengths reported to the transport are in device-rate samples of the
+* track that is currently playing. With looping on, the current track repeats instead of
+* moving on: its read-ahead buffer loops, so the start of the track is already buffered
+* when the end plays, and the joint is crossfaded over loopCrossfadeMs.
+*
+* In non-realtime mode the audio thread waits for the loader and the read-ahead buffers
+* instead of playing silence, so an offline render is complete and repeatable.
+*
+* Tracks in formats that are slow to seek get a SeekIndex. A seek that lands on one of its
+* anchors plays the anchor's decoded audio straight away, and the time from the message
+* thread asking for a seek (noteSeekRequested()) to the first complete block of audio is
+* recorded per format. The index reads all over the file, so its reader comes from the
+* scan factory, which shouldn't go through the decoded audio cache: the index's reads
+* would push the playing track's chunks out of it.
+*
+* Each track can carry a playback gain (e.g. loudness normalisation) from a GainProvider.
+* It costs one multiply per sample, and a gain that changes mid-track ramps over one block.
+*/
+class GaplessPlaylistSource: public juce::PositionableAudioSource, private juce::Thread
+{
+    public:
+        static constexpr int loopCrossfadeMs = 10;     // at the joint when the current track repeats
+
+        using ReaderFactory = std::function<juce::AudioFormatReader* (const juce::File&)>;
+        using GainProvider = std::function<float (const juce::File&)>;
+
+        struct SeekLatency{
+            juce::String format;
+            int seeks = 0, anchoredSeeks = 0;
+            int withinOneBlock = 0;             // seeks heard again no more than one block's time after being asked for
+            double averageMs = 0.0, maxMs = 0.0;
+        };
+
+        /* `scanReaderFactory` opens readers for whole-file scans; without one they come from `readerFactory` */
+        GaplessPlaylistSource(ReaderFactory readerFactory, juce::TimeSliceThread& readAheadThread, ReaderFactory scanReaderFactory = {})
+            : juce::Thread("Playlist loader"),
+              readerFactory_(std::move(readerFactory)),
+              scanReaderFactory_(scanReaderFactory != nullptr ? std::move(scanReaderFactory) : readerFactory_),
+              readAheadThread_(readAheadThread)
+        {
+            startThread();
+        }
+
+        ~GaplessPlaylistSource() override{
+            stopThread(4000);
+
+            deleteTrack_(current_);
+            deleteTrack_(next_);
+            deleteTrack_(pendingTrack_.withdraw());
+            freeRetiredTracks_();
+        }
+
+        /*
+
+                                    MESSAGE THREAD
+
+        */
+
+        /* replaces the queue; playback continues from the first file once it is loaded */
+        void setPlaylist(const juce::Array<juce::File>& files){
+            {
+                const juce::ScopedLock sl(queueLock_);
+                queue_ = files;
+                loaderIdle_ = false;
+                ++generation_;
+            }
+
+            finished_ = false;
+            currentTrackIndex_ = -1;
+            notify();
+        }
+
+        void appendFile(const juce::File& file){
+            {
+                const juce::ScopedLock sl(queueLock_);
+                queue_.add(file);
+                loaderIdle_ = false;
+            }
+
+            notify();
+        }
+
+        juce::File getFile(int index) const{
+            const juce::ScopedLock sl(queueLock_);
+            return queue_[index];
+        }
+
+        int getNumFiles() const{
+            const juce::ScopedLock sl(queueLock_);
+            return queue_.size();
+        }
+
+        /* index in the queue of the track being heard, -1 before the first one has started */
+        int getCurrentTrackIndex() const{
+            return currentTrackIndex_.load();
+        }
+
+        void setCrossfadeMs(int milliseconds){
+            crossfadeMs_ = juce::jmax(0, milliseconds);
+        }
+
+        void setReadAheadMs(int milliseconds){
+            readAheadMs_ = juce::jmax(50, milliseconds);
+        }
+
+        /* see the class comment; also applied to the read-ahead buffers of loaded tracks */
+        void setNonRealtime(bool isNonRealtime){
+            nonRealtime_ = isNonRealtime;
+
+            const juce::ScopedLock sl(liveTracksLock_);
+
+            for(auto* track : liveTracks_)
+                track->readAhead->setNonRealtime(isNonRealtime);
+        }
+
+        /* used by tracks opened from now on; loaded tracks pick it up when the device is next prepared */
+        void setResamplingQuality(PolyphaseResamplingSource::Quality quality){
+            resamplingQuality_ = quality;
+
+            const juce::ScopedLock sl(liveTracksLock_);
+
+            for(auto* track : liveTracks_)
+                track->resampler->setQuality(quality);
+        }
+
+        PolyphaseResamplingSource::Quality getResamplingQuality() const noexcept{
+            return resamplingQuality_.load();
+        }
+
+        /*
+        * asked for a track's playback gain when it is opened and on every refreshGains();
+        * called on the loader and message threads, never the audio thread
+        */
+        void setGainProvider(GainProvider provider){
+            {
+                const juce::ScopedLock sl(gainLock_);
+                gainProvider_ = std::move(provider);
+            }
+
+            refreshGains();
+        }
+
+        /* asks the provider again for every loaded track; a track already playing ramps to its new gain over one block */
+        void refreshGains(){
+            const juce::ScopedLock sl(liveTracksLock_);
+
+            for(auto* track : liveTracks_)
+                track->targetGain = getGainFor_(track->file);
+        }
+
+        /*
+        * the closest seek point of the track being heard, if there is one no more than
+        * `toleranceSeconds` away from `seconds`; otherwise `seconds` itself
+        */
+        double snapToSeekPoint(double seconds, double toleranceSeconds) const{
+            const juce::ScopedLock sl(liveTracksLock_);
+
+            if(auto* track = findCurrentLiveTrack_())
+                if(track->seekIndex != nullptr)
+                    if(auto* anchor = track->seekIndex->findNearest((juce::int64) (seconds * track->sourceSampleRate),
+                                                                    (juce::int64) (toleranceSeconds * track->sourceSampleRate)))
+                        return (double) anchor->position / track->sourceSampleRate;
+
+            return seconds;
+        }
+
+        /* distance between the seek points of the track being heard in seconds, 0 if it has none */
+        double getSeekPointSpacing() const{
+            const juce::ScopedLock sl(liveTracksLock_);
+            auto* track = findCurrentLiveTrack_();
+
+            return track != nullptr && track->seekIndex != nullptr ? (double) track->seekIndex->getSpacing() / track->sourceSampleRate : 0.0;
+        }
+
+        /*
+        * message thread, just before a seek is handed to the transport: the seek's latency is
+        * measured from here, so the command queue and the transport's fade-out count too
+        */
+        void noteSeekRequested() noexcept{
+            seekRequestTicks_ = juce::Time::getHighResolutionTicks();
+        }
+
+        /* false while the track being heard is still decoding its seek points */
+        bool isSeekIndexComplete() const{
+            const juce::ScopedLock sl(liveTracksLock_);
+            auto* track = findCurrentLiveTrack_();
+
+            return track != nullptr && (track->seekIndex == nullptr || track->seekIndex->isComplete());
+        }
+
+        /* seek-to-audio latency per format since the last call to resetSeekLatencyStats() */
+        juce::Array<SeekLatency> getSeekLatencyStats(){
+            collectSeekLatency_();
+            return seekLatency_;
+        }
+
+        void resetSeekLatencyStats(){
+            collectSeekLatency_();
+            seekLatency_.clear();
+        }
+
+        /* read-ahead statistics of the track being heard */
+        ReadAheadAudioSource::Stats getReadAheadStats() const{
+            const juce::ScopedLock sl(liveTracksLock_);
+
+            if(auto* track = findCurrentLiveTrack_())
+                return track->readAhead->getStats();
+
+            return {};
+        }
+
+        /*
+
+                                    AudioSource
+
+        */
+
+        void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override{
+            const juce::ScopedLock sl(pendingTrack_.getPrepareLock());
+
+            blockSize_ = samplesPerBlockExpected;
+            sampleRate_ = sampleRate;
+            scratch_.setSize(2, samplesPerBlockExpected * 2);
+
+            // the device is stopped while this is called, so the audio-thread tracks can be touched
+            for(auto* track : { current_, next_, pendingTrack_.getWaiting() })
+                if(track != nullptr)
+                    prepareTrack_(*track);
+        }
+
+        void releaseResources() override{}
+
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override{
+            if(nonRealtime_.load())
+                waitForLoader_();
+
+            auto gen = generation_.load();
+
+            // drop tracks that belong to a replaced queue, then pick up a freshly loaded one
+            if(current_ != nullptr && current_->generation != gen)
+                retireTrack_(current_);
+
+            if(next_ != nullptr && next_->generation != gen)
+                retireTrack_(next_);
+
+            if(current_ == nullptr && next_ != nullptr)
+                std::swap(current_, next_);
+
+            if(current_ == nullptr || next_ == nullptr){
+                if(auto* track = pendingTrack_.take()){
+                    if(track->generation != gen)
+                        retireTrack_(track);
+                    else if(current_ == nullptr)
+                        startTrack_(track);
+                    else
+                        next_ = track;
+                }
+            }
+
+            auto seek = pendingSeek_.exchange(-1);
+
+            if(seek >= 0 && current_ != nullptr)
+                seekTrack_(*current_, seek);
+
+            // only the track being heard loops
+            if(current_ != nullptr && current_->loopApplied != looping_.load()){
+                current_->loopApplied = looping_.load();
+                current_->readAhead->setLooping(current_->loopApplied);
+            }
+
+            auto start = info.startSample;
+            auto numSamples = info.numSamples;
+
+            if(scratch_.getNumSamples() < numSamples){
+                // a bigger block than announced in prepareToPlay; better silent than allocating here
+                info.clearActiveBufferRegion();
+                return;
+            }
+
+            while(numSamples > 0){
+                if(current_ == nullptr){
+                    info.buffer->clear(start, numSamples);
+
+                    // only run past the end once the queue has played out, so AudioTransportSource
+                    // stops then, but not while the first track is still being loaded
+                    if(finished_.load())
+                        reportedPosition_ += numSamples;
+
+                    break;
+                }
+
+                auto remaining = current_->length - current_->position;
+                auto fade = next_ != nullptr && ! looping_.load() ? juce::jmin((juce::int64) (crossfadeMs_.load() * sampleRate_ / 1000.0), current_->length)
+                                             : (juce::int64) 0;
+
+                if(remaining > fade){
+                    // plain playback up to the crossfade (or the end of the track)
+                    auto samplesThisTime = (int) juce::jmin((juce::int64) numSamples, remaining - fade);
+                    renderTrack_(*current_, *info.buffer, start, samplesThisTime);
+
+                    start += samplesThisTime;
+                    numSamples -= samplesThisTime;
+                }
+                else if(remaining > 0){
+                    // crossfade: the current track fades out while the next one fades in
+                    auto samplesThisTime = (int) juce::jmin((juce::int64) numSamples, remaining);
+                    auto gainStart = (float) remaining / (float) fade;
+                    auto gainEnd = (float) (remaining - samplesThisTime) / (float) fade;
+
+                    renderTrack_(*current_, *info.buffer, start, samplesThisTime);
+                    renderTrack_(*next_, scratch_, 0, samplesThisTime);
+
+                    for(auto channel = 0; channel < info.buffer->getNumChannels(); ++channel){
+                        info.buffer->applyGainRamp(channel, start, samplesThisTime, gainStart, gainEnd);
+                        info.buffer->addFromWithRamp(channel, start, scratch_.getReadPointer(channel % scratch_.getNumChannels()),
+                                                     samplesThisTime, 1.0f - gainStart, 1.0f - gainEnd);
+                    }
+
+                    start += samplesThisTime;
+                    numSamples -= samplesThisTime;
+                }
+
+                if(current_->position >= current_->length && current_->loopApplied){
+                    // the read-ahead buffer has already carried on past the crossfade into the start of the track
+                    current_->position = current_->loopCrossfade + current_->position - current_->length;
+                }
+                else if(current_->position >= current_->length){
+                    // switch at the exact sample the track ended on
+                    retireTrack_(current_);
+
+                    if(next_ != nullptr){
+                        startTrack_(next_);
+                        next_ = nullptr;
+                    }
+                    else{
+                        finished_ = true;
+                    }
+                }
+            }
+
+            if(current_ != nullptr)
+                reportedPosition_ = current_->position;
+        }
+
+        /*
+
+                                    PositionableAudioSource
+
+        */
+
+        void setNextReadPosition(juce::int64 newPosition) override{
+            // a rewind after the whole queue has played starts it again from the first file. the
+            // transport calls this on the audio thread, so the loader starts the new generation
+            if(finished_.exchange(false) && newPosition == 0){
+                currentTrackIndex_ = -1;
+                loaderIdle_ = false;
+                rewindRequested_ = true;
+            }
+
+            pendingSeek_ = newPosition;
+            reportedPosition_ = newPosition;
+        }
+
+        juce::int64 getNextReadPosition() const override{
+            return reportedPosition_.load();
+        }
+
+        juce::int64 getTotalLength() const override{
+            return reportedLength_.load();
+        }
+
+        bool isLooping() const override{
+            return looping_.load();
+        }
+
+        /* repeats the current track instead of moving on; safe to call from the audio thread */
+        void setLooping(bool shouldLoop) override{
+            looping_ = shouldLoop;
+        }
+
+    private:
+        struct Track{
+            juce::File file;
+            int index = 0, generation = 0;
+            double sourceSampleRate = 0.0;
+            juce::int64 sourceLength = 0;
+
+            std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
+            std::unique_ptr<ReadAheadAudioSource> readAhead;
+            std::unique_ptr<SeekPrerollSource> preroll;
+            std::unique_ptr<PolyphaseResamplingSource> resampler;
+            std::unique_ptr<MappedPagePrefetcher> prefetcher;
+            std::unique_ptr<SeekIndex> seekIndex;
+            char formatName[16] = {};   // copied once on the loader thread, read by the audio thread
+
+            std::atomic<float> targetGain { 1.0f };
+            float currentGain = 1.0f;   // audio thread only
+
+            juce::int64 length = 0;     // in device-rate samples
+            juce::int64 position = 0;   // audio thread only
+            juce::int64 loopCrossfade = 0;  // in device-rate samples, each pass after the first is this much shorter
+            bool loopApplied = false;   // audio thread only
+
+            // the seek being timed, audio thread only
+            bool awaitingAudio = false, seekAnchored = false;
+            juce::int64 seekStartTicks = 0;
+        };
+
+        struct SeekRecord{
+            char formatName[16];
+            float ms;
+            bool withinOneBlock;
+            bool anchored;
+        };
+
+        ReaderFactory readerFactory_, scanReaderFactory_;
+        juce::CriticalSection gainLock_;
+        GainProvider gainProvider_;
+        juce::TimeSliceThread& readAheadThread_;
+        std::atomic<int> readAheadMs_ { 500 }, crossfadeMs_ { 0 };
+        std::atomic<bool> nonRealtime_ { false };
+        std::atomic<PolyphaseResamplingSource::Quality> resamplingQuality_ { PolyphaseResamplingSource::Quality::standard };
+
+        juce::CriticalSection queueLock_;
+        juce::Array<juce::File> queue_;
+        std::atomic<int> generation_ { 0 };
+        int loaderGeneration_ = -1, nextIndexToLoad_ = 0;
+        std::atomic<bool> loaderIdle_ { false };   // every file of the current queue has been loaded
+
+        int blockSize_ = 512;                       // with sampleRate_, under the pending track's prepare lock
+        double sampleRate_ = 44100.0;
+
+        // tracks in flight: loader -> pendingTrack_ -> audio thread -> retired FIFO -> loader
+        PreparedHandoff<Track> pendingTrack_;
+        Track* current_ = nullptr;
+        Track* next_ = nullptr;
+        juce::AbstractFifo retiredFifo_ { 64 };
+        Track* retired_[64] = {};
+
+        juce::CriticalSection liveTracksLock_;
+        juce::Array<Track*> liveTracks_;
+
+        // seek timings: audio thread -> FIFO -> getSeekLatencyStats()
+        juce::AbstractFifo seekFifo_ { 64 };
+        std::atomic<juce::int64> seekRequestTicks_ { 0 };  // 0 when no seek is waiting to be applied
+        SeekRecord seekRecords_[64] = {};
+        juce::Array<SeekLatency> seekLatency_;
+
+        juce::AudioBuffer<float> scratch_;
+        std::atomic<juce::int64> pendingSeek_ { -1 }, reportedPosition_ { 0 }, reportedLength_ { 0 };
+        std::atomic<int> currentTrackIndex_ { -1 };
+        std::atomic<bool> finished_ { false }, looping_ { false }, rewindRequested_ { false };
+
+        /*
+
+                                    LOADER THREAD
+
+        */
+
+        void run() override{
+            while(! threadShouldExit()){
+                freeRetiredTracks_();
+
+                if(rewindRequested_.exchange(false)){
+                    const juce::ScopedLock sl(queueLock_);
+                    loaderIdle_ = false;
+                    ++generation_;
+                }
+
+                auto gen = generation_.load();
+
+                if(gen != loaderGeneration_){
+                    loaderGeneration_ = gen;
+                    nextIndexToLoad_ = 0;
+
+                    deleteTrack_(pendingTrack_.withdraw());
+                }
+
+                if(pendingTrack_.getWaiting() == nullptr){
+                    juce::File file;
+
+                    {
+                        // checked under the queue lock, so a queue change always clears it again
+                        const juce::ScopedLock sl(queueLock_);
+                        file = queue_[nextIndexToLoad_];
+                        loaderIdle_ = file == juce::File{} && gen == generation_.load();
+                    }
+
+                    if(file != juce::File{}){
+                        openTrack_(file, nextIndexToLoad_++, gen);
+                        continue;
+                    }
+                }
+
+                wait(10);
+            }
+        }
+
+        /* opens `file`, prepares it and makes it the pending track; files that can't be read are skipped */
+        void openTrack_(const juce::File& file, int index, int gen){
+            auto* reader = readerFactory_(file);
+
+            if(reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0){
+                delete reader;
+                return;
+            }
+
+            auto track = std::make_unique<Track>();
+            track->file = file;
+            track->index = index;
+            track->generation = gen;
+            track->sourceSampleRate = reader->sampleRate;
+            track->sourceLength = reader->lengthInSamples;
+
+            auto numChannels = juce::jmax(2, (int) reader->numChannels);
+            auto* mappedReader = dynamic_cast<juce::MemoryMappedAudioFormatReader*> (reader);
+
+            track->readerSource = std::make_unique<juce::AudioFormatReaderSource>(reader, true);
+            track->readAhead = std::make_unique<ReadAheadAudioSource>(track->readerSource.get(), readAheadThread_, false,
+                                                                      (int) (readAheadMs_.load() * reader->sampleRate / 1000.0),
+                                                                      numChannels);
+            track->readAhead->setNonRealtime(nonRealtime_.load());
+            track->readAhead->setLoopCrossfade((int) (loopCrossfadeMs * reader->sampleRate / 1000.0));
+            track->preroll = std::make_unique<SeekPrerollSource>(*track->readAhead);
+            track->resampler = std::make_unique<PolyphaseResamplingSource>(track->preroll.get(), false, 2, resamplingQuality_.load());
+            reader->getFormatName().copyToUTF8(track->formatName, sizeof(track->formatName));
+
+            if(mappedReader != nullptr)
+                track->prefetcher = std::make_unique<MappedPagePrefetcher>(*mappedReader, *track->readerSource, readAheadThread_);
+
+            // the index decodes the file with a reader of its own, so it never touches the playing one
+            if(SeekIndex::isWorthBuilding(*reader))
+                if(auto* indexReader = scanReaderFactory_(file))
+                    track->seekIndex = std::make_unique<SeekIndex>(indexReader);
+
+            // the loader only loads while nothing is waiting, so there is no track to replace
+            auto* replaced = pendingTrack_.offer(track.get(), [this, &file] (Track& t){
+                prepareTrack_(t);
+
+                // asked under the lock, so a refreshGains() can't slip in between and be missed
+                const juce::ScopedLock sl(liveTracksLock_);
+                liveTracks_.add(&t);
+                t.targetGain = getGainFor_(file);
+            });
+
+            track.release();
+            jassert(replaced == nullptr);
+            deleteTrack_(replaced);
+        }
+
+        void prepareTrack_(Track& track){
+            track.resampler->setResamplingRatio(track.sourceSampleRate / sampleRate_);
+            track.resampler->prepareToPlay(blockSize_, sampleRate_);
+            track.length = (juce::int64) ((double) track.sourceLength * sampleRate_ / track.sourceSampleRate);
+            track.loopCrossfade = (juce::int64) ((double) track.readAhead->getLoopCrossfade() * sampleRate_ / track.sourceSampleRate);
+        }
+
+        Track* findCurrentLiveTrack_() const{
+            // callers hold liveTracksLock_
+            for(auto* track : liveTracks_)
+                if(track->index == currentTrackIndex_.load() && track->generation == generation_.load())
+                    return track;
+
+            return nullptr;
+        }
+
+        void collectSeekLatency_(){
+            // message thread only
+            seekFifo_.read(seekFifo_.getNumReady()).forEach([this] (int index){
+                const auto& record = seekRecords_[index];
+                auto format = juce::String::fromUTF8(record.formatName);
+                SeekLatency* stats = nullptr;
+
+                for(auto& s : seekLatency_)
+                    if(s.format == format)
+                        stats = &s;
+
+                if(stats == nullptr){
+                    seekLatency_.add({});
+                    stats = &seekLatency_.getReference(seekLatency_.size() - 1);
+                    stats->format = format;
+                }
+
+                stats->averageMs = (stats->averageMs * stats->seeks + record.ms) / (stats->seeks + 1);
+                stats->maxMs = juce::jmax(stats->maxMs, (double) record.ms);
+                stats->anchoredSeeks += record.anchored ? 1 : 0;
+                stats->withinOneBlock += record.withinOneBlock ? 1 : 0;
+                ++stats->seeks;
+            });
+        }
+
+        void freeRetiredTracks_(){
+            Track* toFree[64];
+            auto numFree = 0;
+
+            retiredFifo_.read(retiredFifo_.getNumReady()).forEach([&] (int index){
+                toFree[numFree++] = retired_[index];
+            });
+
+            for(auto i = 0; i < numFree; ++i)
+                deleteTrack_(toFree[i]);
+        }
+
+        void deleteTrack_(Track* track){
+            if(track == nullptr)
+                return;
+
+            {
+                const juce::ScopedLock sl(liveTracksLock_);
+                liveTracks_.removeFirstMatchingValue(track);
+            }
+
+            // prefetcher and resampler go before the sources they read from, the index after
+            // the preroll source that may point into it
+            track->prefetcher.reset();
+            track->resampler.reset();
+            track->preroll.reset();
+            track->readAhead.reset();
+            track->readerSource.reset();
+            track->seekIndex.reset();
+            delete track;
+        }
+
+        /*
+
+                                    AUDIO THREAD
+
+        */
+
+        void waitForLoader_(){
+            /*
+            * non-realtime only: hold the block until the loader has handed over the track this
+            * block may need, or has run out of files to load
+            */
+            auto deadline = juce::Time::getMillisecondCounter() + 10000;
+
+            while((current_ == nullptr || next_ == nullptr) && pendingTrack_.getWaiting() == nullptr
+                  && ! loaderIdle_.load() && juce::Time::getMillisecondCounter() < deadline){
+                notify();
+                juce::Thread::sleep(1);
+            }
+        }
+
+        void startTrack_(Track* track){
+            current_ = track;
+            currentTrackIndex_ = track->index;
+            reportedLength_ = track->length;
+            reportedPosition_ = track->position;
+        }
+
+        void seekTrack_(Track& track, juce::int64 position){
+            track.position = juce::jlimit((juce::int64) 0, track.length, position);
+
+            auto sourcePosition = (juce::int64) std::llround((double) track.position * track.sourceSampleRate / sampleRate_);
+            auto tolerance = (juce::int64) std::ceil(track.sourceSampleRate / sampleRate_) + 1; // rounding between the two rates
+            auto* anchor = track.seekIndex != nullptr ? track.seekIndex->findNearest(sourcePosition, tolerance) : nullptr;
+
+            if(anchor != nullptr)
+                track.preroll->startPreroll(*anchor);
+            else
+                track.preroll->setNextReadPosition(sourcePosition);
+
+            track.resampler->flushBuffers();
+
+            // seeks nobody asked for (a rewind, a loop) are timed from here
+            auto requestTicks = seekRequestTicks_.exchange(0);
+
+            track.awaitingAudio = true;
+            track.seekAnchored = anchor != nullptr;
+            track.seekStartTicks = requestTicks != 0 ? requestTicks : juce::Time::getHighResolutionTicks();
+        }
+
+        void renderTrack_(Track& track, juce::AudioBuffer<float>& buffer, int start, int numSamples){
+            auto underrunsBefore = track.readAhead->getUnderrunCount();
+
+            track.resampler->getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, start, numSamples));
+
+            // nothing of the track has been heard yet, so a new gain needs no ramp
+            auto targetGain = track.targetGain.load(std::memory_order_relaxed);
+
+            if(track.position == 0)
+                track.currentGain = targetGain;
+
+            if(targetGain != track.currentGain){
+                for(auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+                    buffer.applyGainRamp(channel, start, numSamples, track.currentGain, targetGain);
+
+                track.currentGain = targetGain;
+            }
+            else if(track.currentGain != 1.0f){
+                buffer.applyGain(start, numSamples, track.currentGain);
+            }
+
+            track.position += numSamples;
+
+            if(track.awaitingAudio){
+                // the first block after a seek that the read-ahead buffer (or the preroll) filled completely
+                if(track.readAhead->getUnderrunCount() == underrunsBefore){
+                    track.awaitingAudio = false;
+
+                    auto ms = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - track.seekStartTicks) * 1000.0;
+
+                    seekFifo_.write(1).forEach([&] (int index){
+                        auto& record = seekRecords_[index];
+                        std::memcpy(record.formatName, track.formatName, sizeof(record.formatName));
+                        record.ms = (float) ms;
+                        record.withinOneBlock = ms <= blockSize_ * 1000.0 / sampleRate_;
+                        record.anchored = track.seekAnchored;
+                    });
+                }
+            }
+        }
+
+        float getGainFor_(const juce::File& file){
+            const juce::ScopedLock sl(gainLock_);
+            return gainProvider_ != nullptr ? gainProvider_(file) : 1.0f;
+        }
+
+        void retireTrack_(Track*& track){
+            // the loader deletes it; if the FIFO is ever full the track is leaked rather than freed here
+            retiredFifo_.write(1).forEach([&] (int index){
+                retired_[index] = track;
+            });
+
+            track = nullptr;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GaplessPlaylistSource)
+};
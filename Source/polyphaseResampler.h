@@ -0,0 +1,329 @@
+/*
+  ==============================================================================
+
+    polyphaseResampler.h
+    Created: 17 Oct 2026 12:28:09am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/* zeroed floats starting on a 64-byte boundary, so any SIMDRegister can load from them */
+struct AlignedFloats{
+    std::vector<float> storage;
+    float* data = nullptr;
+
+    void allocate(size_t numFloats){
+        constexpr size_t alignment = 64;
+        storage.assign(numFloats + alignment / sizeof(float), 0.0f);
+        auto address = reinterpret_cast<std::uintptr_t>(storage.data());
+        data = reinterpret_cast<float*>((address + alignment - 1) & ~(std::uintptr_t) (alignment - 1));
+    }
+
+    float* get() const noexcept{ return data; }
+};
+
+/*
+* Windowed-sinc polyphase resampler with the same interface as juce::ResamplingAudioSource.
+*
+* Each quality tier precomputes a Kaiser-windowed sinc table (one row per phase, rows
+* normalised to unity gain) when the source is prepared; an output sample is the dot
+* product of the input window with the two rows around its fractional phase, blended
+* linearly. The cutoff follows the ratio, so downsampling is band limited to the new
+* Nyquist frequency.
+*
+* The dot products run on juce::dsp::SIMDRegister<float>. The input history is kept in
+* SIMDRegister<float>::size() copies, each shifted by one sample, so every window can be
+* loaded from an aligned address whatever its start. A ratio of exactly 1 passes the
+* input through untouched.
+*/
+class PolyphaseResamplingSource: public juce::AudioSource
+{
+    public:
+        enum class Quality{ draft, standard, mastering };
+
+        struct QualitySpec{
+            int taps;           // filter length, a multiple of the SIMD width
+            int phases;         // table rows between two input samples
+            double beta;        // Kaiser window shape
+            double rolloff;     // highest cutoff as a fraction of the lower Nyquist frequency
+        };
+
+        static QualitySpec getSpec(Quality quality){
+            switch(quality){
+                case Quality::draft:        return { 16, 64, 6.0, 0.85 };
+                case Quality::mastering:    return { 128, 512, 12.0, 0.95 };
+                case Quality::standard:
+                default:                    return { 64, 256, 8.5, 0.91 };
+            }
+        }
+
+        /*
+        * the cutoff the table is built with, as a fraction of the lower Nyquist frequency:
+        * the rolloff, pulled in where needed so the stopband starts at or below Nyquist.
+        * The transition width is Kaiser's estimate for the tier's taps and beta.
+        */
+        static double getCutoff(const QualitySpec& spec){
+            auto attenuationDb = spec.beta / 0.1102 + 8.7;
+            auto transition = 2.0 * (attenuationDb - 7.95) / (14.36 * (spec.taps - 1));
+            return juce::jmin(spec.rolloff, 1.0 - transition * 0.5);
+        }
+
+        static const char* getQualityName(Quality quality){
+            switch(quality){
+                case Quality::draft:        return "draft";
+                case Quality::mastering:    return "mastering";
+                case Quality::standard:
+                default:                    return "standard";
+            }
+        }
+
+        PolyphaseResamplingSource(juce::AudioSource* inputSource, bool deleteInputWhenDeleted,
+                                  int numChannels = 2, Quality quality = Quality::standard)
+            : input_(inputSource, deleteInputWhenDeleted), numChannels_(juce::jmax(1, numChannels)), quality_(quality)
+        {
+            jassert(inputSource != nullptr);
+        }
+
+        /* input samples per output sample, i.e. source rate / device rate */
+        void setResamplingRatio(double samplesInPerOutputSample){
+            jassert(samplesInPerOutputSample > 0.0);
+            ratio_ = juce::jmax(0.0, samplesInPerOutputSample);
+        }
+
+        double getResamplingRatio() const noexcept{
+            return ratio_.load();
+        }
+
+        /* takes effect at the next prepareToPlay(), where the table is built */
+        void setQuality(Quality quality){
+            quality_ = quality;
+        }
+
+        /* the scalar kernel is kept as a reference for tests and benchmarks */
+        void setUseVectorKernel(bool shouldUseVectorKernel){
+            useVectorKernel_ = shouldUseVectorKernel;
+        }
+
+        /*
+
+                                    AudioSource
+
+        */
+
+        void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override{
+            auto ratio = ratio_.load();
+            auto spec = getSpec(quality_.load());
+
+            preparedRatio_ = ratio;
+            taps_ = (spec.taps + lanes - 1) / lanes * lanes;
+            phases_ = spec.phases;
+            buildTable_(spec, ratio);
+
+            // enough history for one block's worth of input plus the filter span
+            maxInputPerPull_ = juce::jmax(64, (int) std::ceil(samplesPerBlockExpected * ratio) + 4);
+            historyCapacity_ = (taps_ + maxInputPerPull_) * 2 + lanes;
+            inputBuffer_.setSize(numChannels_, maxInputPerPull_);
+
+            history_.assign((size_t) numChannels_, {});
+
+            for(auto& copies : history_){
+                copies.resize((size_t) lanes);
+
+                for(auto& copy : copies)
+                    copy.allocate((size_t) historyCapacity_);
+            }
+
+            flushBuffers();
+            input_->prepareToPlay(juce::roundToInt(samplesPerBlockExpected * ratio), sampleRate * ratio);
+        }
+
+        void releaseResources() override{
+            input_->releaseResources();
+        }
+
+        /* forgets the input history, e.g. after a seek. Audio thread safe. */
+        void flushBuffers(){
+            // (taps / 2 - 1) zeros ahead of the first input sample keep the output aligned with the input
+            writePosition_ = taps_ / 2 - 1;
+            readPosition_ = (double) writePosition_;
+
+            for(auto& copies : history_)
+                for(auto& copy : copies)
+                    juce::FloatVectorOperations::clear(copy.get(), historyCapacity_);
+        }
+
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override{
+            if(std::abs(preparedRatio_ - 1.0) < 1.0e-12 || history_.empty()){
+                input_->getNextAudioBlock(info);
+                return;
+            }
+
+            auto numOutputChannels = info.buffer->getNumChannels();
+            auto done = 0;
+
+            while(done < info.numSamples){
+                // the window of the next output sample must be fully in the history
+                if((int) readPosition_ + taps_ / 2 + 1 > writePosition_){
+                    pullInput_(info.numSamples - done);
+                    continue;
+                }
+
+                auto firstTap = (int) readPosition_ - taps_ / 2 + 1;
+                auto phase = (readPosition_ - std::floor(readPosition_)) * phases_;
+                auto row = juce::jmin(phases_ - 1, (int) phase);
+                auto fraction = (float) (phase - row);
+                const auto* row0 = table_.get() + (size_t) row * (size_t) taps_;
+                const auto* row1 = row0 + taps_;
+
+                for(auto channel = 0; channel < numOutputChannels; ++channel){
+                    auto& copies = history_[(size_t) (channel % numChannels_)];
+
+                    info.buffer->setSample(channel, info.startSample + done,
+                                           useVectorKernel_ ? convolveVector_(copies, firstTap, row0, row1, fraction)
+                                                            : convolveScalar_(copies[0].get() + firstTap, row0, row1, fraction));
+                }
+
+                readPosition_ += preparedRatio_;
+                ++done;
+            }
+        }
+
+    private:
+       #if JUCE_USE_SIMD
+        using Vec = juce::dsp::SIMDRegister<float>;
+        static constexpr int lanes = (int) Vec::SIMDNumElements;
+       #else
+        static constexpr int lanes = 1;
+       #endif
+
+        juce::OptionalScopedPointer<juce::AudioSource> input_;
+        int numChannels_;
+        std::atomic<Quality> quality_;
+        std::atomic<double> ratio_ { 1.0 };
+        bool useVectorKernel_ = true;
+
+        double preparedRatio_ = 1.0;
+        int taps_ = 32, phases_ = 256;
+        AlignedFloats table_;                               // (phases_ + 1) rows of taps_ coefficients
+
+        juce::AudioBuffer<float> inputBuffer_;
+        int maxInputPerPull_ = 0, historyCapacity_ = 0;
+        std::vector<std::vector<AlignedFloats>> history_;   // [channel][shift]: copy s holds x[j + s] at j
+        int writePosition_ = 0;                             // samples in the history
+        double readPosition_ = 0.0;                         // time of the next output sample, in history samples
+
+        void buildTable_(const QualitySpec& spec, double ratio){
+            /*
+            * row r is the filter for an output time r / phases_ past an input sample; tap k
+            * sits at distance (r / phases_ + taps_ / 2 - 1 - k) from it
+            */
+            auto cutoff = juce::jmin(1.0, 1.0 / ratio) * getCutoff(spec);
+            auto half = taps_ / 2;
+            auto besselI0 = [] (double x){
+                auto sum = 1.0, term = 1.0;
+
+                for(auto k = 1; k < 50 && term > 1.0e-12 * sum; ++k){
+                    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                    sum += term;
+                }
+
+                return sum;
+            };
+
+            auto windowNorm = besselI0(spec.beta);
+            table_.allocate((size_t) ((phases_ + 1) * taps_));
+
+            for(auto r = 0; r <= phases_; ++r){
+                auto* row = table_.get() + (size_t) r * (size_t) taps_;
+                auto sum = 0.0;
+
+                for(auto k = 0; k < taps_; ++k){
+                    auto distance = (double) r / phases_ + half - 1 - k;
+                    auto x = distance / half;
+                    auto window = std::abs(x) < 1.0 ? besselI0(spec.beta * std::sqrt(1.0 - x * x)) / windowNorm : 0.0;
+                    auto arg = juce::MathConstants<double>::pi * cutoff * distance;
+                    auto sinc = std::abs(arg) < 1.0e-9 ? 1.0 : std::sin(arg) / arg;
+
+                    row[k] = (float) (cutoff * sinc * window);
+                    sum += row[k];
+                }
+
+                // unity gain at DC for every phase
+                for(auto k = 0; k < taps_; ++k)
+                    row[k] = (float) (row[k] / sum);
+            }
+        }
+
+        void pullInput_(int outputSamplesWanted){
+            // make room: drop what no future window can reach, in every shifted copy alike
+            auto firstNeeded = juce::jmax(0, (int) readPosition_ - taps_ / 2 + 1);
+            auto numToRead = juce::jlimit(1, maxInputPerPull_, (int) std::ceil(outputSamplesWanted * preparedRatio_) + 1);
+
+            if(writePosition_ + numToRead + lanes > historyCapacity_ && firstNeeded > 0){
+                for(auto& copies : history_)
+                    for(auto& copy : copies)
+                        std::memmove(copy.get(), copy.get() + firstNeeded, sizeof(float) * (size_t) (historyCapacity_ - firstNeeded));
+
+                writePosition_ -= firstNeeded;
+                readPosition_ -= firstNeeded;
+            }
+
+            numToRead = juce::jmin(numToRead, historyCapacity_ - lanes - writePosition_);
+            input_->getNextAudioBlock(juce::AudioSourceChannelInfo(&inputBuffer_, 0, numToRead));
+
+            for(auto channel = 0; channel < numChannels_; ++channel){
+                const auto* in = inputBuffer_.getReadPointer(juce::jmin(channel, inputBuffer_.getNumChannels() - 1));
+                auto& copies = history_[(size_t) channel];
+
+                for(auto shift = 0; shift < lanes; ++shift){
+                    // copy `shift` holds x[j + shift] at index j
+                    auto skip = juce::jmax(0, shift - writePosition_);
+
+                    if(numToRead > skip)
+                        juce::FloatVectorOperations::copy(copies[(size_t) shift].get() + writePosition_ - shift + skip, in + skip, numToRead - skip);
+                }
+            }
+
+            writePosition_ += numToRead;
+        }
+
+        float convolveScalar_(const float* window, const float* row0, const float* row1, float fraction) const noexcept{
+            float a0 = 0.0f, a1 = 0.0f;
+
+            for(auto k = 0; k < taps_; ++k){
+                a0 += window[k] * row0[k];
+                a1 += window[k] * row1[k];
+            }
+
+            return a0 + (a1 - a0) * fraction;
+        }
+
+        float convolveVector_(const std::vector<AlignedFloats>& copies, int firstTap, const float* row0, const float* row1, float fraction) const noexcept{
+           #if JUCE_USE_SIMD
+            // pick the copy in which this window starts on an aligned index
+            auto shift = firstTap % lanes;
+            const auto* window = copies[(size_t) shift].get() + (firstTap - shift);
+            auto a0 = Vec::expand(0.0f), a1 = Vec::expand(0.0f);
+
+            for(auto k = 0; k < taps_; k += lanes){
+                auto x = Vec::fromRawArray(window + k);
+                a0 += x * Vec::fromRawArray(row0 + k);
+                a1 += x * Vec::fromRawArray(row1 + k);
+            }
+
+            auto y0 = a0.sum(), y1 = a1.sum();
+            return y0 + (y1 - y0) * fraction;
+           #else
+            return convolveScalar_(copies[0].get() + firstTap, row0, row1, fraction);
+           #endif
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PolyphaseResamplingSource)
+};
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    preparedHandoff.h
+    Created: 17 Oct 2026 1:28:55am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+/*
+* Hands something a loader thread built to the audio thread, prepared for the current
+* device settings.
+*
+* offer() prepares the item and makes it the waiting one under the prepare lock.
+* prepareToPlay() takes the same lock through getPrepareLock() while it changes the settings
+* and prepares the waiting item, so an item is never prepared for settings that have just
+* been replaced. The audio thread take()s the waiting item with one atomic exchange.
+* withdraw() is how the loader takes it back; it also holds the lock, so prepareToPlay()
+* is never looking at an item that is about to be freed.
+*
+* The owner frees items: nothing here deletes one, and the owner's destructor withdraw()s
+* whatever is still waiting.
+*/
+template <typename Item>
+class PreparedHandoff
+{
+    public:
+        PreparedHandoff() = default;
+
+        ~PreparedHandoff(){
+            jassert(waiting_.load() == nullptr);
+        }
+
+        /*
+        * loader thread: calls prepare(item) under the lock and makes the item the waiting
+        * one. returns the item it replaced, which the audio thread never saw
+        */
+        template <typename PrepareFunction>
+        Item* offer(Item* item, PrepareFunction&& prepare){
+            const juce::ScopedLock sl(prepareLock_);
+            prepare(*item);
+            return waiting_.exchange(item);
+        }
+
+        /* loader thread: takes the waiting item back so it can be freed */
+        Item* withdraw(){
+            const juce::ScopedLock sl(prepareLock_);
+            return waiting_.exchange(nullptr);
+        }
+
+        /* audio thread */
+        Item* take() noexcept{
+            return waiting_.exchange(nullptr);
+        }
+
+        /* any thread; only prepareToPlay(), under the lock, may touch the item itself */
+        Item* getWaiting() const noexcept{
+            return waiting_.load();
+        }
+
+        /* held by prepareToPlay() while it changes what offer() prepares for */
+        const juce::CriticalSection& getPrepareLock() const noexcept{
+            return prepareLock_;
+        }
+
+    private:
+        juce::CriticalSection prepareLock_;
+        std::atomic<Item*> waiting_ { nullptr };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PreparedHandoff)
+};
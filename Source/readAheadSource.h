@@ -0,0 +1,501 @@
+/*
+  ==============================================================================
+
+    readAheadSource.h
+    Created: 17 Oct 2026 12:06:20am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+/*
+* A PositionableAudioSource that reads its input source ahead of the playhead on a
+* TimeSliceThread, so getNextAudioBlock() only copies from a circular buffer and never
+* touches the disk.
+*
+* The layout follows juce::BufferingAudioSource, but the audio thread never blocks on the
+* background reader (it only try-locks) and the source counts underruns and refill latency
+* so the buffer depth can be sized from measured numbers.
+*
+* In non-realtime mode (offline rendering) getNextAudioBlock() instead waits for the
+* background thread, so a render that runs faster than realtime is still complete.
+*
+* Looping is done here rather than by the source: positions keep counting past the end
+* and the background thread fills the buffer with the start of the source again, so the
+* joint is buffered like any other audio. With a loop crossfade, the last samples before
+* the end fade out while the first ones fade in, and later passes carry on after the
+* faded-in part, each pass that many samples shorter than the first.
+*/
+class ReadAheadAudioSource: public juce::PositionableAudioSource, private juce::TimeSliceClient
+{
+    public:
+        struct Stats{
+            juce::int64 underruns = 0;      // audio blocks that could not be fully served from the buffer
+            juce::int64 refills = 0;        // chunks read by the background thread
+            double lastRefillMs = 0.0;      // time spent reading the most recent chunk
+            double maxRefillMs = 0.0;       // worst chunk read time seen so far
+            double averageRefillMs = 0.0;
+        };
+
+        ReadAheadAudioSource(juce::PositionableAudioSource* source,
+                             juce::TimeSliceThread& backgroundThread,
+                             bool deleteSourceWhenDeleted,
+                             int numberOfSamplesToBuffer,
+                             int numberOfChannels = 2)
+            : source_(source, deleteSourceWhenDeleted),
+              backgroundThread_(backgroundThread),
+              numberOfSamplesToBuffer_(juce::jmax(1024, numberOfSamplesToBuffer)),
+              numberOfChannels_(numberOfChannels)
+        {
+            jassert(source != nullptr);
+        }
+
+        ~ReadAheadAudioSource() override{
+            releaseResources();
+        }
+
+        /*
+
+                                    AudioSource
+
+        */
+
+        void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override{
+            auto bufferSizeNeeded = juce::jmax(samplesPerBlockExpected * 2, numberOfSamplesToBuffer_);
+
+            if(bufferSizeNeeded != buffer_.getNumSamples() || sampleRate != sampleRate_ || ! isPrepared_){
+                backgroundThread_.removeTimeSliceClient(this);
+
+                isPrepared_ = true;
+                sampleRate_ = sampleRate;
+                source_->prepareToPlay(samplesPerBlockExpected, sampleRate);
+                buffer_.setSize(numberOfChannels_, bufferSizeNeeded);
+                buffer_.clear();
+                loopHead_.setSize(numberOfChannels_, maxChunkSize);
+
+                // never sleep longer than a quarter of the buffer, otherwise a short buffer
+                // drains before the background thread wakes up again
+                idleWaitMs_ = juce::jlimit(1, 100, (int) (250.0 * bufferSizeNeeded / juce::jmax(1.0, sampleRate)));
+
+                bufferValidStart_ = 0;
+                bufferValidEnd_ = 0;
+
+                backgroundThread_.addTimeSliceClient(this);
+
+                // prefill up to a quarter of a second so the first blocks do not underrun
+                auto prefillTarget = juce::jmin((juce::int64) sampleRate / 4, (juce::int64) bufferSizeNeeded / 2);
+                auto deadline = juce::Time::getMillisecondCounter() + 500;
+
+                while(bufferValidEnd_.load() - bufferValidStart_.load() < prefillTarget
+                      && juce::Time::getMillisecondCounter() < deadline){
+                    backgroundThread_.moveToFrontOfQueue(this);
+                    juce::Thread::sleep(2);
+                }
+            }
+        }
+
+        void releaseResources() override{
+            isPrepared_ = false;
+            backgroundThread_.removeTimeSliceClient(this);
+
+            buffer_.setSize(numberOfChannels_, 0);
+            loopHead_.setSize(numberOfChannels_, 0);
+            source_->releaseResources();
+        }
+
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override{
+            /*
+            * called on the audio thread: copy whatever part of the request is already
+            * buffered, clear the rest and count the block as an underrun if data was missing.
+            * the lock is only contended while the background thread publishes a new range,
+            * so a failed try-lock is treated like a missing buffer instead of waiting.
+            */
+            if(nonRealtime_.load())
+                waitForBufferedRange_(info.numSamples);
+
+            const juce::SpinLock::ScopedTryLockType sl(bufferRangeLock_);
+
+            auto pos = nextPlayPos_.load();
+
+            if(! sl.isLocked()){
+                info.clearActiveBufferRegion();
+                underruns_.fetch_add(1);
+                nextPlayPos_ = pos + info.numSamples;
+                return;
+            }
+
+            auto start = bufferValidStart_.load();
+            auto end = bufferValidEnd_.load();
+
+            auto validStart = (int) (juce::jlimit(start, end, pos) - pos);
+            auto validEnd = (int) (juce::jlimit(start, end, pos + info.numSamples) - pos);
+
+            auto samplesExpected = info.numSamples;
+            if(! looping_.load())
+                samplesExpected = (int) juce::jlimit((juce::int64) 0, (juce::int64) info.numSamples, source_->getTotalLength() - pos);
+
+            if(validEnd - validStart < samplesExpected)
+                underruns_.fetch_add(1);
+
+            if(validStart == validEnd){
+                info.clearActiveBufferRegion();
+            }
+            else{
+                if(validStart > 0)
+                    info.buffer->clear(info.startSample, validStart);
+
+                if(validEnd < info.numSamples)
+                    info.buffer->clear(info.startSample + validEnd, info.numSamples - validEnd);
+
+                if(validStart < validEnd){
+                    auto bufferSize = buffer_.getNumSamples();
+
+                    for(auto channel = juce::jmin(numberOfChannels_, info.buffer->getNumChannels()); --channel >= 0;){
+                        jassert(buffer_.getNumSamples() > 0);
+                        auto startBufferIndex = (int) ((validStart + pos) % bufferSize);
+                        auto endBufferIndex = (int) ((validEnd + pos) % bufferSize);
+
+                        if(startBufferIndex < endBufferIndex){
+                            info.buffer->copyFrom(channel, info.startSample + validStart,
+                                                  buffer_, channel, startBufferIndex,
+                                                  validEnd - validStart);
+                        }
+                        else{
+                            auto initialSize = bufferSize - startBufferIndex;
+
+                            info.buffer->copyFrom(channel, info.startSample + validStart,
+                                                  buffer_, channel, startBufferIndex,
+                                                  initialSize);
+
+                            info.buffer->copyFrom(channel, info.startSample + validStart + initialSize,
+                                                  buffer_, channel, 0,
+                                                  (validEnd - validStart) - initialSize);
+                        }
+                    }
+                }
+            }
+
+            nextPlayPos_ = pos + info.numSamples;
+        }
+
+        /*
+
+                                    PositionableAudioSource
+
+        */
+
+        void setNextReadPosition(juce::int64 newPosition) override{
+            nextPlayPos_ = newPosition;
+            backgroundThread_.moveToFrontOfQueue(this);
+        }
+
+        juce::int64 getNextReadPosition() const override{
+            jassert(source_->getTotalLength() > 0);
+            return toSourcePosition_(nextPlayPos_.load());
+        }
+
+        juce::int64 getTotalLength() const override{
+            return source_->getTotalLength();
+        }
+
+        bool isLooping() const override{
+            return looping_.load();
+        }
+
+        /*
+        * safe on the audio thread; turning looping off carries on from the same place in the
+        * source. what is buffered before the joint reads the same either way and is kept, so
+        * a toggle away from the end of the source doesn't drop any audio
+        */
+        void setLooping(bool shouldLoop) override{
+            if(shouldLoop == looping_.load())
+                return;
+
+            const juce::SpinLock::ScopedLockType sl(bufferRangeLock_);
+
+            if(! shouldLoop)
+                nextPlayPos_ = toSourcePosition_(nextPlayPos_.load());
+
+            looping_ = shouldLoop;
+            loopChanges_.fetch_add(1);
+            keepBufferBeforeJoint_();
+        }
+
+        /* samples crossfaded at the joint while looping, at most half the source */
+        void setLoopCrossfade(int numSamples){
+            loopCrossfade_ = juce::jmax(0, numSamples);
+        }
+
+        /* the crossfade the source gets, which is shorter than asked for on a very short source */
+        juce::int64 getLoopCrossfade() const noexcept{
+            return juce::jmin((juce::int64) loopCrossfade_.load(), getLoopLength_() / 2);
+        }
+
+        /*
+        * where the loop wraps; 0, the default, is the end of the source. A longer loop plays
+        * silence after the source, so sources of different lengths can loop together
+        */
+        void setLoopLength(juce::int64 numSamples){
+            loopLength_ = juce::jmax((juce::int64) 0, numSamples);
+        }
+
+        /*
+        * when set, getNextAudioBlock() blocks until the requested samples are buffered
+        * instead of playing silence. only for hosts that are not driven by a device.
+        */
+        void setNonRealtime(bool isNonRealtime){
+            nonRealtime_ = isNonRealtime;
+        }
+
+        /*
+
+                                    STATISTICS
+
+        */
+
+        Stats getStats() const{
+            Stats stats;
+            stats.underruns = underruns_.load();
+            stats.refills = refills_.load();
+            stats.lastRefillMs = lastRefillMs_.load();
+            stats.maxRefillMs = maxRefillMs_.load();
+            stats.averageRefillMs = stats.refills > 0 ? totalRefillMs_.load() / (double) stats.refills : 0.0;
+            return stats;
+        }
+
+        /* cheap enough for the audio thread, unlike getStats() */
+        juce::int64 getUnderrunCount() const noexcept{
+            return underruns_.load();
+        }
+
+        void resetStats(){
+            underruns_ = 0;
+            refills_ = 0;
+            lastRefillMs_ = 0.0;
+            maxRefillMs_ = 0.0;
+            totalRefillMs_ = 0.0;
+        }
+
+        int getBufferSizeInSamples() const{
+            return buffer_.getNumSamples();
+        }
+
+    private:
+        juce::OptionalScopedPointer<juce::PositionableAudioSource> source_;
+        juce::TimeSliceThread& backgroundThread_;
+        int numberOfSamplesToBuffer_, numberOfChannels_;
+        static constexpr int maxChunkSize = 2048;
+
+        juce::AudioBuffer<float> buffer_;
+        juce::AudioBuffer<float> loopHead_;     // start of the source for the loop crossfade, background thread only
+        juce::SpinLock bufferRangeLock_;
+        std::atomic<juce::int64> bufferValidStart_ { 0 }, bufferValidEnd_ { 0 }, nextPlayPos_ { 0 };
+        double sampleRate_ = 0.0;
+        bool isPrepared_ = false;
+        int idleWaitMs_ = 100;
+        std::atomic<bool> nonRealtime_ { false }, looping_ { false };
+        std::atomic<int> loopCrossfade_ { 0 }, loopChanges_ { 0 };
+        std::atomic<juce::int64> loopLength_ { 0 };
+        juce::WaitableEvent bufferReadyEvent_;
+
+        std::atomic<juce::int64> underruns_ { 0 }, refills_ { 0 };
+        std::atomic<double> lastRefillMs_ { 0.0 }, maxRefillMs_ { 0.0 }, totalRefillMs_ { 0.0 };
+
+        void waitForBufferedRange_(int numSamples){
+            auto pos = nextPlayPos_.load();
+            auto samplesNeeded = looping_.load() ? (juce::int64) numSamples
+                                                      : juce::jlimit((juce::int64) 0, (juce::int64) numSamples, source_->getTotalLength() - pos);
+            auto deadline = juce::Time::getMillisecondCounter() + 5000;
+
+            while(juce::Time::getMillisecondCounter() < deadline){
+                {
+                    const juce::SpinLock::ScopedLockType sl(bufferRangeLock_);
+
+                    if(bufferValidStart_.load() <= pos && bufferValidEnd_.load() >= pos + samplesNeeded)
+                        return;
+                }
+
+                backgroundThread_.moveToFrontOfQueue(this);
+                bufferReadyEvent_.wait(2);
+            }
+        }
+
+        int useTimeSlice() override{
+            return readNextBufferChunk() ? 1 : idleWaitMs_;
+        }
+
+        bool readNextBufferChunk(){
+            /*
+            * work out which part of the circular buffer is stale, read it from the source
+            * without holding the lock, then publish the new valid range.
+            */
+            juce::int64 newBVS, newBVE, sectionToReadStart, sectionToReadEnd;
+            int loopChanges;
+
+            {
+                const juce::SpinLock::ScopedLockType sl(bufferRangeLock_);
+
+                loopChanges = loopChanges_.load();
+                newBVS = juce::jmax((juce::int64) 0, nextPlayPos_.load());
+                newBVE = newBVS + buffer_.getNumSamples() - 4;
+                sectionToReadStart = 0;
+                sectionToReadEnd = 0;
+
+                if(newBVS < bufferValidStart_ || newBVS >= bufferValidEnd_){
+                    newBVE = juce::jmin(newBVE, newBVS + maxChunkSize);
+
+                    sectionToReadStart = newBVS;
+                    sectionToReadEnd = newBVE;
+
+                    bufferValidStart_ = 0;
+                    bufferValidEnd_ = 0;
+                }
+                else if(std::abs((int) (newBVS - bufferValidStart_)) > 512
+                        || std::abs((int) (newBVE - bufferValidEnd_)) > 512){
+                    newBVE = juce::jmin(newBVE, bufferValidEnd_ + maxChunkSize);
+
+                    sectionToReadStart = bufferValidEnd_;
+                    sectionToReadEnd = newBVE;
+
+                    bufferValidStart_ = newBVS;
+                    bufferValidEnd_ = juce::jmin(bufferValidEnd_.load(), newBVE);
+                }
+            }
+
+            if(sectionToReadStart == sectionToReadEnd)
+                return false;
+
+            auto startTicks = juce::Time::getHighResolutionTicks();
+
+            jassert(buffer_.getNumSamples() > 0);
+            auto bufferIndexStart = (int) (sectionToReadStart % buffer_.getNumSamples());
+            auto bufferIndexEnd = (int) (sectionToReadEnd % buffer_.getNumSamples());
+
+            if(bufferIndexStart < bufferIndexEnd){
+                readBufferSection(sectionToReadStart,
+                                  (int) (sectionToReadEnd - sectionToReadStart),
+                                  bufferIndexStart);
+            }
+            else{
+                auto initialSize = buffer_.getNumSamples() - bufferIndexStart;
+
+                readBufferSection(sectionToReadStart, initialSize, bufferIndexStart);
+                readBufferSection(sectionToReadStart + initialSize,
+                                  (int) (sectionToReadEnd - sectionToReadStart) - initialSize,
+                                  0);
+            }
+
+            recordRefill(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0);
+
+            {
+                const juce::SpinLock::ScopedLockType sl(bufferRangeLock_);
+
+                bufferValidStart_ = newBVS;
+                bufferValidEnd_ = newBVE;
+
+                // looping was toggled while the section was read, so its joint may be the wrong way round
+                if(loopChanges != loopChanges_.load())
+                    keepBufferBeforeJoint_();
+            }
+
+            bufferReadyEvent_.signal();
+            return true;
+        }
+
+        /*
+        * called under bufferRangeLock_ when looping changes: positions before the joint map
+        * to the same samples looped or not, so only the buffered part from the joint on is dropped
+        */
+        void keepBufferBeforeJoint_(){
+            auto joint = getLoopLength_() - getLoopCrossfade();
+
+            if(bufferValidStart_.load() >= joint){
+                bufferValidStart_ = 0;
+                bufferValidEnd_ = 0;
+            }
+            else{
+                bufferValidEnd_ = juce::jmin(bufferValidEnd_.load(), joint);
+            }
+        }
+
+        juce::int64 getLoopLength_() const noexcept{
+            auto length = loopLength_.load();
+            return length > 0 ? length : source_->getTotalLength();
+        }
+
+        /*
+        * where position `position` reads from in the source: straight through on the first
+        * pass, then from the end of the crossfade on, one crossfade shorter each pass
+        */
+        juce::int64 toSourcePosition_(juce::int64 position) const noexcept{
+            auto total = getLoopLength_();
+
+            if(! looping_.load() || position < total || total <= 0)
+                return position;
+
+            auto fade = getLoopCrossfade();
+            return fade + (position - total) % (total - fade);
+        }
+
+        void readBufferSection(juce::int64 start, int length, int bufferOffset){
+            auto total = getLoopLength_();
+
+            if(! looping_.load() || total <= 0){
+                readSource_(buffer_, start, length, bufferOffset);
+                return;
+            }
+
+            auto fade = getLoopCrossfade();
+            auto fadeStart = total - fade;
+
+            while(length > 0){
+                auto position = toSourcePosition_(start);
+                auto samplesThisTime = (int) juce::jmin((juce::int64) length, position < fadeStart ? fadeStart - position : total - position);
+
+                if(position >= fadeStart)
+                    samplesThisTime = juce::jmin(samplesThisTime, loopHead_.getNumSamples());
+
+                readSource_(buffer_, position, samplesThisTime, bufferOffset);
+
+                if(position >= fadeStart){
+                    // the joint: the end of the source fades out while its start fades in
+                    auto headPosition = position - fadeStart;
+                    auto gainStart = (float) headPosition / (float) fade;
+                    auto gainEnd = (float) (headPosition + samplesThisTime) / (float) fade;
+
+                    readSource_(loopHead_, headPosition, samplesThisTime, 0);
+
+                    for(auto channel = 0; channel < numberOfChannels_; ++channel){
+                        buffer_.applyGainRamp(channel, bufferOffset, samplesThisTime, 1.0f - gainStart, 1.0f - gainEnd);
+                        buffer_.addFromWithRamp(channel, bufferOffset, loopHead_.getReadPointer(channel), samplesThisTime, gainStart, gainEnd);
+                    }
+                }
+
+                start += samplesThisTime;
+                length -= samplesThisTime;
+                bufferOffset += samplesThisTime;
+            }
+        }
+
+        void readSource_(juce::AudioBuffer<float>& dest, juce::int64 start, int length, int destOffset){
+            if(source_->getNextReadPosition() != start)
+                source_->setNextReadPosition(start);
+
+            juce::AudioSourceChannelInfo info(&dest, destOffset, length);
+            source_->getNextAudioBlock(info);
+        }
+
+        void recordRefill(double ms){
+            lastRefillMs_ = ms;
+            totalRefillMs_ = totalRefillMs_.load() + ms;
+            refills_.fetch_add(1);
+
+            if(ms > maxRefillMs_.load())
+                maxRefillMs_ = ms;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReadAheadAudioSource)
+};
@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+
+    seekIndex.h
+    Created: 17 Oct 2026 12:24:17am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+/*
+* Seek points for files whose readers are slow to seek (FLAC, Ogg Vorbis, MP3...).
+*
+* When a track opens, a background thread visits each anchor in order with its own reader
+* and keeps the first prerollSamples of audio after it. A seek that lands on an anchor can
+* then start playing that decoded audio in the same block, while the read-ahead buffer
+* catches up behind it.
+*
+* Anchors are anchorSpacingSeconds apart, but a track never has more than maxAnchors: a
+* long file spreads them evenly instead. Memory is at most maxAnchors x prerollSamples per
+* channel, 8 MB for stereo, and only the preroll is decoded, never the audio in between.
+*
+* Anchors are published in order through an atomic count, so the audio thread can look
+* them up without locking while the later ones are still being decoded.
+*/
+class SeekIndex: private juce::Thread
+{
+    public:
+        static constexpr double anchorSpacingSeconds = 0.5;     // closest spacing
+        static constexpr int maxAnchors = 256;
+        static constexpr int prerollSamples = 4096;
+
+        struct Anchor{
+            juce::int64 position = 0;           // in source samples
+            juce::AudioBuffer<float> preroll;   // decoded audio starting at position
+        };
+
+        explicit SeekIndex(juce::AudioFormatReader* reader)    // takes ownership
+            : juce::Thread("Seek index"), reader_(reader)
+        {
+            jassert(reader != nullptr);
+
+            spacing_ = juce::jmax((juce::int64) prerollSamples, (juce::int64) (reader_->sampleRate * anchorSpacingSeconds),
+                                  (reader_->lengthInSamples + maxAnchors - 1) / maxAnchors);
+            anchors_.resize((size_t) ((reader_->lengthInSamples + spacing_ - 1) / spacing_));
+
+            // decoding competes with the read-ahead thread, which must win
+            startThread(juce::Thread::Priority::low);
+        }
+
+        ~SeekIndex() override{
+            stopThread(4000);
+        }
+
+        /* true for readers that have to decode from a distant sync point on a random seek */
+        static bool isWorthBuilding(const juce::AudioFormatReader& reader){
+            if(dynamic_cast<const juce::MemoryMappedAudioFormatReader*>(&reader) != nullptr)
+                return false;
+
+            auto format = reader.getFormatName();
+            return ! (format.startsWithIgnoreCase("WAV") || format.startsWithIgnoreCase("AIFF"));
+        }
+
+        bool isComplete() const noexcept            { return anchorsReady_.load() == (int) anchors_.size(); }
+        juce::int64 getSpacing() const noexcept     { return spacing_; }       // in source samples
+        double getBuildTimeMs() const noexcept      { return buildTimeMs_.load(); }
+
+        /*
+        * the anchor closest to `position` if it is no further than `tolerance` samples away
+        * and already decoded, otherwise nullptr. Lock-free and allocation-free.
+        */
+        const Anchor* findNearest(juce::int64 position, juce::int64 tolerance) const noexcept{
+            auto index = (int) ((position + spacing_ / 2) / spacing_);
+
+            if(index < 0 || index >= anchorsReady_.load(std::memory_order_acquire))
+                return nullptr;
+
+            const auto& anchor = anchors_[(size_t) index];
+            return std::abs(anchor.position - position) <= tolerance ? &anchor : nullptr;
+        }
+
+    private:
+        std::unique_ptr<juce::AudioFormatReader> reader_;
+        juce::int64 spacing_ = 0;
+        std::vector<Anchor> anchors_;       // sized up front and never reallocated
+        std::atomic<int> anchorsReady_ { 0 };
+        std::atomic<double> buildTimeMs_ { 0.0 };
+
+        void run() override{
+            // forward only, so each seek of the reader is a short one from the anchor before
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            auto numChannels = juce::jmax(1, (int) reader_->numChannels);
+
+            for(size_t i = 0; i < anchors_.size(); ++i){
+                if(threadShouldExit())
+                    return;
+
+                auto& anchor = anchors_[i];
+                anchor.position = (juce::int64) i * spacing_;
+
+                // spacing_ is never shorter than the preroll, so anchors never overlap
+                auto prerollLength = (int) juce::jmin((juce::int64) prerollSamples, reader_->lengthInSamples - anchor.position);
+                anchor.preroll.setSize(numChannels, prerollLength);
+                reader_->read(&anchor.preroll, 0, prerollLength, anchor.position, true, true);
+
+                anchorsReady_.store((int) i + 1, std::memory_order_release);
+            }
+
+            buildTimeMs_ = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SeekIndex)
+};
+
+
+/*
+* Sits between a track's read-ahead buffer and its resampler. After startPreroll() it plays
+* an anchor's decoded audio first and then carries on from the read-ahead buffer, which was
+* told to continue right after the preroll. Audio thread only.
+*/
+class SeekPrerollSource: public juce::PositionableAudioSource
+{
+    public:
+        explicit SeekPrerollSource(juce::PositionableAudioSource& input): input_(input) {}
+
+        void startPreroll(const SeekIndex::Anchor& anchor){
+            preroll_ = &anchor.preroll;
+            prerollStart_ = anchor.position;
+            prerollOffset_ = 0;
+            input_.setNextReadPosition(anchor.position + anchor.preroll.getNumSamples());
+        }
+
+        void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override{
+            input_.prepareToPlay(samplesPerBlockExpected, sampleRate);
+        }
+
+        void releaseResources() override{
+            input_.releaseResources();
+        }
+
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override{
+            auto start = info.startSample;
+            auto numSamples = info.numSamples;
+
+            if(preroll_ != nullptr){
+                auto samplesThisTime = juce::jmin(numSamples, preroll_->getNumSamples() - prerollOffset_);
+                auto numInputChannels = preroll_->getNumChannels();
+
+                for(auto channel = 0; channel < info.buffer->getNumChannels(); ++channel)
+                    info.buffer->copyFrom(channel, start, *preroll_, channel % numInputChannels, prerollOffset_, samplesThisTime);
+
+                prerollOffset_ += samplesThisTime;
+                start += samplesThisTime;
+                numSamples -= samplesThisTime;
+
+                if(prerollOffset_ >= preroll_->getNumSamples())
+                    preroll_ = nullptr;
+            }
+
+            if(numSamples > 0)
+                input_.getNextAudioBlock(juce::AudioSourceChannelInfo(info.buffer, start, numSamples));
+        }
+
+        bool isPlayingPreroll() const noexcept{
+            return preroll_ != nullptr;
+        }
+
+        void setNextReadPosition(juce::int64 newPosition) override{
+            preroll_ = nullptr;
+            input_.setNextReadPosition(newPosition);
+        }
+
+        juce::int64 getNextReadPosition() const override{
+            return preroll_ != nullptr ? prerollStart_ + prerollOffset_ : input_.getNextReadPosition();
+        }
+
+        juce::int64 getTotalLength() const override   { return input_.getTotalLength(); }
+        bool isLooping() const override                { return input_.isLooping(); }
+        void setLooping(bool shouldLoop) override      { input_.setLooping(shouldLoop); }
+
+    private:
+        juce::PositionableAudioSource& input_;
+        const juce::AudioBuffer<float>* preroll_ = nullptr;
+        juce::int64 prerollStart_ = 0;
+        int prerollOffset_ = 0;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SeekPrerollSource)
+};
@@ -0,0 +1,331 @@
+/*
+  ==============================================================================
+
+    spectrumAnalyser.h
+    Created: 17 Oct 2026 12:34:11am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+/*
+* Spectrum and levels of whatever the audio callback plays.
+*
+* The audio thread only copies its output block into a single-producer/single-consumer
+* FIFO (pushBlock()), dropping samples when the FIFO is full, and times that copy. A low
+* priority worker drains the FIFO. Every hopSize samples it takes a Hann-windowed FFT of
+* the last fftSize samples and publishes a Frame through a triple buffer. Frames the UI
+* did not pick up in time are overwritten, so nothing ever backs up.
+*/
+class SpectrumAnalyser: private juce::Thread
+{
+    public:
+        static constexpr int fftOrder = 11;
+        static constexpr int fftSize = 1 << fftOrder;
+        static constexpr int numBins = fftSize / 2;
+        static constexpr int hopSize = fftSize / 4;
+        static constexpr int fifoSize = 1 << 15;        // ~0.7 s at 44.1 kHz before samples are dropped
+
+        struct Frame{
+            std::array<float, numBins> magnitudesDb {};
+            std::array<float, 2> peak {}, rms {};        // linear, over the hop that ended this frame
+            double sampleRate = 44100.0;
+            juce::int64 index = 0;
+        };
+
+        struct Cost{
+            juce::int64 pushes = 0;
+            double averageUs = 0.0, maxUs = 0.0;
+            juce::int64 droppedSamples = 0;              // the FIFO was full: the worker fell behind
+            juce::int64 droppedFrames = 0;               // published but replaced before the UI read them
+        };
+
+        SpectrumAnalyser(): juce::Thread("Spectrum analyser"){
+            startThread(juce::Thread::Priority::low);
+        }
+
+        ~SpectrumAnalyser() override{
+            stopThread(2000);
+        }
+
+        void prepare(double sampleRate) noexcept{
+            sampleRate_ = sampleRate;
+        }
+
+        void setEnabled(bool shouldBeEnabled) noexcept{
+            enabled_ = shouldBeEnabled;
+        }
+
+        /*
+
+                                    AUDIO THREAD
+
+        */
+
+        /* copies the first two channels of a block into the FIFO; never blocks or allocates */
+        void pushBlock(const juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept{
+            if(! enabled_.load(std::memory_order_relaxed) || buffer.getNumChannels() == 0)
+                return;
+
+            auto startTicks = juce::Time::getHighResolutionTicks();
+            auto numChannels = buffer.getNumChannels();
+
+            {
+                const auto scope = fifo_.write(numSamples);
+                auto written = scope.blockSize1 + scope.blockSize2;
+
+                for(auto channel = 0; channel < 2; ++channel){
+                    const auto* source = buffer.getReadPointer(juce::jmin(channel, numChannels - 1), startSample);
+
+                    if(scope.blockSize1 > 0)
+                        juce::FloatVectorOperations::copy(fifoData_[(size_t) channel].data() + scope.startIndex1, source, scope.blockSize1);
+
+                    if(scope.blockSize2 > 0)
+                        juce::FloatVectorOperations::copy(fifoData_[(size_t) channel].data() + scope.startIndex2, source + scope.blockSize1, scope.blockSize2);
+                }
+
+                if(written < numSamples)
+                    droppedSamples_.fetch_add(numSamples - written, std::memory_order_relaxed);
+            }
+
+            auto ticks = juce::Time::getHighResolutionTicks() - startTicks;
+            pushTicks_.fetch_add(ticks, std::memory_order_relaxed);
+            pushes_.fetch_add(1, std::memory_order_relaxed);
+
+            if(ticks > maxPushTicks_.load(std::memory_order_relaxed))
+                maxPushTicks_.store(ticks, std::memory_order_relaxed);
+        }
+
+        /*
+
+                                    UI THREAD
+
+        */
+
+        /* copies the newest frame into `frame`; false if nothing new was published since the last call */
+        bool readLatestFrame(Frame& frame) noexcept{
+            if((middle_.load(std::memory_order_acquire) & newFrameBit) == 0)
+                return false;
+
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & indexMask;
+            frame = frames_[(size_t) front_];
+            return true;
+        }
+
+        Cost getCost() const noexcept{
+            Cost cost;
+            auto ticksPerUs = (double) juce::Time::getHighResolutionTicksPerSecond() / 1.0e6;
+
+            cost.pushes = pushes_.load();
+            cost.averageUs = cost.pushes > 0 ? (double) pushTicks_.load() / ticksPerUs / (double) cost.pushes : 0.0;
+            cost.maxUs = (double) maxPushTicks_.load() / ticksPerUs;
+            cost.droppedSamples = droppedSamples_.load();
+            cost.droppedFrames = droppedFrames_.load();
+            return cost;
+        }
+
+    private:
+        static constexpr int newFrameBit = 4;
+        static constexpr int indexMask = 3;
+
+        // audio thread -> worker
+        juce::AbstractFifo fifo_ { fifoSize };
+        std::array<std::array<float, (size_t) fifoSize>, 2> fifoData_ {};
+        std::atomic<bool> enabled_ { true };
+        std::atomic<double> sampleRate_ { 44100.0 };
+        std::atomic<juce::int64> pushes_ { 0 }, pushTicks_ { 0 }, maxPushTicks_ { 0 }, droppedSamples_ { 0 };
+
+        // worker -> UI: frames_[back_] is written, middle_ is handed over, frames_[front_] is read
+        std::array<Frame, 3> frames_;
+        int back_ = 0, front_ = 1;
+        std::atomic<int> middle_ { 2 };
+        std::atomic<juce::int64> droppedFrames_ { 0 };
+
+        // worker only
+        juce::dsp::FFT fft_ { fftOrder };
+        juce::dsp::WindowingFunction<float> window_ { (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+        std::array<std::array<float, (size_t) fftSize>, 2> history_ {};     // the last fftSize samples, oldest first
+        std::array<float, (size_t) fftSize * 2> fftData_ {};
+        int samplesSinceFrame_ = 0;
+        juce::int64 frameIndex_ = 0;
+        std::array<float, 2> hopPeak_ {}, hopSumSquares_ {};
+
+        void run() override{
+            while(! threadShouldExit()){
+                auto numReady = fifo_.getNumReady();
+
+                // far behind: skip what can no longer be shown and keep only the newest window
+                if(numReady > fftSize + hopSize){
+                    fifo_.finishedRead(numReady - fftSize);
+                    numReady = fftSize;
+                }
+
+                if(numReady > 0)
+                    consume_(numReady);
+
+                wait(juce::jmax(1, (int) (1000.0 * hopSize / sampleRate_.load() / 2.0)));
+            }
+        }
+
+        void consume_(int numSamples){
+            const auto scope = fifo_.read(numSamples);
+
+            append_(scope.startIndex1, scope.blockSize1);
+            append_(scope.startIndex2, scope.blockSize2);
+        }
+
+        void append_(int fifoStart, int numSamples){
+            while(numSamples > 0){
+                auto samplesThisTime = juce::jmin(numSamples, hopSize - samplesSinceFrame_);
+
+                for(auto channel = 0; channel < 2; ++channel){
+                    auto& history = history_[(size_t) channel];
+                    const auto* source = fifoData_[(size_t) channel].data() + fifoStart;
+
+                    std::memmove(history.data(), history.data() + samplesThisTime, sizeof(float) * (size_t) (fftSize - samplesThisTime));
+                    std::memcpy(history.data() + fftSize - samplesThisTime, source, sizeof(float) * (size_t) samplesThisTime);
+
+                    auto range = juce::FloatVectorOperations::findMinAndMax(source, samplesThisTime);
+                    hopPeak_[(size_t) channel] = juce::jmax(hopPeak_[(size_t) channel], std::abs(range.getStart()), std::abs(range.getEnd()));
+
+                    for(auto i = 0; i < samplesThisTime; ++i)
+                        hopSumSquares_[(size_t) channel] += source[i] * source[i];
+                }
+
+                fifoStart += samplesThisTime;
+                numSamples -= samplesThisTime;
+                samplesSinceFrame_ += samplesThisTime;
+
+                if(samplesSinceFrame_ == hopSize){
+                    publishFrame_();
+                    samplesSinceFrame_ = 0;
+                }
+            }
+        }
+
+        void publishFrame_(){
+            auto& frame = frames_[(size_t) back_];
+
+            // mid signal: the spectrum of what both speakers play together
+            for(auto i = 0; i < fftSize; ++i)
+                fftData_[(size_t) i] = 0.5f * (history_[0][(size_t) i] + history_[1][(size_t) i]);
+
+            window_.multiplyWithWindowingTable(fftData_.data(), (size_t) fftSize);
+            fft_.performFrequencyOnlyForwardTransform(fftData_.data(), true);
+
+            // a full-scale sine through a Hann window peaks at fftSize / 4
+            constexpr auto scale = 4.0f / (float) fftSize;
+
+            for(auto bin = 0; bin < numBins; ++bin)
+                frame.magnitudesDb[(size_t) bin] = juce::Decibels::gainToDecibels(fftData_[(size_t) bin] * scale, -120.0f);
+
+            for(size_t channel = 0; channel < 2; ++channel){
+                frame.peak[channel] = hopPeak_[channel];
+                frame.rms[channel] = std::sqrt(hopSumSquares_[channel] / (float) hopSize);
+                hopPeak_[channel] = hopSumSquares_[channel] = 0.0f;
+            }
+
+            frame.sampleRate = sampleRate_.load();
+            frame.index = ++frameIndex_;
+
+            auto previous = middle_.exchange(back_ | newFrameBit, std::memory_order_acq_rel);
+            back_ = previous & indexMask;
+
+            if((previous & newFrameBit) != 0)
+                droppedFrames_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyser)
+};
+
+
+/*
+* Draws the latest SpectrumAnalyser frame on a log frequency axis, with a peak/RMS meter
+* per channel on the right. Call refresh() from a timer; it only repaints on a new frame.
+*/
+class SpectrumDisplay: public juce::Component
+{
+    public:
+        explicit SpectrumDisplay(SpectrumAnalyser& analyser): analyser_(analyser) {}
+
+        void refresh(){
+            if(analyser_.readLatestFrame(frame_)){
+                // the meter falls back slowly, the way level meters usually do
+                for(size_t channel = 0; channel < 2; ++channel)
+                    heldPeak_[channel] = juce::jmax(frame_.peak[channel], heldPeak_[channel] * 0.9f);
+
+                repaint();
+            }
+        }
+
+        void paint(juce::Graphics& g) override{
+            auto bounds = getLocalBounds().toFloat();
+            auto meterArea = bounds.removeFromRight(28.0f);
+
+            g.setColour(juce::Colours::black);
+            g.fillRect(bounds);
+
+            // decade lines at 100 Hz, 1 kHz and 10 kHz
+            g.setColour(juce::Colours::darkgrey);
+
+            for(auto frequency : {100.0f, 1000.0f, 10000.0f})
+                g.drawVerticalLine(juce::roundToInt(frequencyToX_(frequency, bounds)), bounds.getY(), bounds.getBottom());
+
+            juce::Path path;
+            auto binWidth = (float) frame_.sampleRate / (float) SpectrumAnalyser::fftSize;
+
+            for(auto bin = 1; bin < SpectrumAnalyser::numBins; ++bin){
+                auto x = frequencyToX_(bin * binWidth, bounds);
+
+                if(x < bounds.getX())
+                    continue;
+
+                auto y = juce::jmap(juce::jlimit(minDb, 0.0f, frame_.magnitudesDb[(size_t) bin]), minDb, 0.0f, bounds.getBottom(), bounds.getY());
+
+                if(path.isEmpty())
+                    path.startNewSubPath(x, y);
+                else
+                    path.lineTo(x, y);
+            }
+
+            g.setColour(juce::Colours::lightgreen);
+            g.strokePath(path, juce::PathStrokeType(1.0f));
+
+            auto barWidth = meterArea.getWidth() / 2.0f;
+
+            for(size_t channel = 0; channel < 2; ++channel){
+                auto bar = meterArea.removeFromLeft(barWidth).reduced(2.0f, 0.0f);
+                auto levelToY = [&bar] (float level){
+                    auto db = juce::jlimit(minDb, 0.0f, juce::Decibels::gainToDecibels(level, minDb));
+                    return juce::jmap(db, minDb, 0.0f, bar.getBottom(), bar.getY());
+                };
+
+                g.setColour(juce::Colours::darkgrey);
+                g.fillRect(bar);
+                g.setColour(juce::Colours::green);
+                g.fillRect(bar.withTop(levelToY(frame_.rms[channel])));
+                g.setColour(heldPeak_[channel] >= 1.0f ? juce::Colours::red : juce::Colours::yellow);
+                g.drawHorizontalLine(juce::roundToInt(levelToY(heldPeak_[channel])), bar.getX(), bar.getRight());
+            }
+        }
+
+    private:
+        static constexpr float minDb = -90.0f;
+
+        SpectrumAnalyser& analyser_;
+        SpectrumAnalyser::Frame frame_;
+        std::array<float, 2> heldPeak_ {};
+
+        static float frequencyToX_(float frequency, juce::Rectangle<float> area){
+            auto proportion = std::log(juce::jmax(1.0f, frequency) / 20.0f) / std::log(20000.0f / 20.0f);
+            return area.getX() + proportion * area.getWidth();
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumDisplay)
+};
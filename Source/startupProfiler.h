@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    startupProfiler.h
+    Created: 17 Oct 2026 12:52:32am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+/*
+* Milliseconds from application start to each named startup phase, plus the two that
+* matter to a user: the first painted frame and the first audio callback.
+*
+* The application holds the first juce::SharedResourcePointer<StartupProfiler>, so the
+* clock starts when it is constructed; the component and the bench hold their own pointers
+* to the same instance. mark() is for the message thread. markFirstAudio() is called from
+* every audio callback and costs one relaxed load once the first one has been recorded.
+*/
+class StartupProfiler
+{
+    public:
+        struct Phase{
+            juce::String name;
+            double ms = 0.0;                            // since reset()
+        };
+
+        StartupProfiler(){
+            reset();
+        }
+
+        /* restarts the clock and forgets every phase */
+        void reset(){
+            const juce::ScopedLock sl(lock_);
+            startMs_ = juce::Time::getMillisecondCounterHiRes();
+            phases_.clear();
+            firstFrameMs_ = -1.0;
+            firstAudioMs_ = -1.0;
+        }
+
+        void mark(const juce::String& phase){
+            const juce::ScopedLock sl(lock_);
+            phases_.push_back({ phase, juce::Time::getMillisecondCounterHiRes() - startMs_ });
+        }
+
+        /* the first call after reset() counts, later ones are ignored */
+        void markFirstFrame(){
+            if(firstFrameMs_.load() >= 0.0)
+                return;
+
+            mark("first frame");
+            const juce::ScopedLock sl(lock_);
+            firstFrameMs_ = phases_.back().ms;
+        }
+
+        /* audio thread; the first call after reset() counts */
+        void markFirstAudio() noexcept{
+            if(firstAudioMs_.load(std::memory_order_relaxed) >= 0.0)
+                return;
+
+            auto expected = -1.0;
+            firstAudioMs_.compare_exchange_strong(expected, juce::Time::getMillisecondCounterHiRes() - startMs_.load());
+        }
+
+        /* -1 until it has happened */
+        double getFirstFrameMs() const noexcept{ return firstFrameMs_.load(); }
+        double getFirstAudioMs() const noexcept{ return firstAudioMs_.load(); }
+
+        std::vector<Phase> getPhases() const{
+            const juce::ScopedLock sl(lock_);
+            return phases_;
+        }
+
+        /* one line per phase, in the order they were marked, then the first audio callback */
+        juce::String getReport() const{
+            juce::String report("startup:");
+
+            for(const auto& phase : getPhases())
+                report << juce::newLine << "  " << phase.name << ": " << juce::String(phase.ms, 1) << " ms";
+
+            auto firstAudioMs = getFirstAudioMs();
+            report << juce::newLine << "  first audio: " << (firstAudioMs >= 0.0 ? juce::String(firstAudioMs, 1) + " ms" : juce::String("not yet"));
+            return report;
+        }
+
+    private:
+        juce::CriticalSection lock_;
+        std::atomic<double> startMs_ { 0.0 };
+        std::vector<Phase> phases_;
+        std::atomic<double> firstFrameMs_ { -1.0 }, firstAudioMs_ { -1.0 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StartupProfiler)
+};
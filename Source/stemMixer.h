@@ -0,0 +1,736 @@
+/*
+  ==============================================================================
+
+    stemMixer.h
+    Created: 17 Oct 2026 12:46:46am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <vector>
+#include "readAheadSource.h"
+#include "polyphaseResampler.h"
+#include "preparedHandoff.h"
+
+/*
+* Plays several files at once in sample sync, for auditioning stems together.
+*
+* Every track has its own read-ahead buffer and resampler to the device rate, a gain, a
+* pan, a mute and a routing matrix (input channel -> output channel gain). By default
+* output channel c takes input channel c % numInputChannels. All tracks share one
+* position, so seeks move them together.
+*
+* The tracks' gain, pan, mute and routing become one coefficient per (input, output)
+* pair at the start of each block. They are ramped from the previous block's value, and
+* the mix is a single pass over each output: every vector of output samples accumulates
+* input * ramped coefficient from every contributing track before it is stored. The
+* pass runs on juce::dsp::SIMDRegister<float>; mixScalar_() is the reference.
+*
+* setFiles() returns at once: a loader thread opens the files and hands the whole set to
+* the audio thread through a PreparedHandoff, read-ahead buffers prefilled, where it
+* starts from the beginning. A change message follows. The set it replaces is freed by
+* the loader.
+*
+* With looping on, every track loops through its read-ahead buffer, with the joint
+* crossfaded over loopCrossfadeMs. The loop is the longest track rounded up so that each
+* pass is a whole number of samples at every track's own rate, which keeps stems at
+* different rates from drifting apart.
+*/
+class StemMixerSource: public juce::PositionableAudioSource,
+                       public juce::ChangeBroadcaster,
+                       private juce::Thread
+{
+    public:
+        using ReaderFactory = std::function<juce::AudioFormatReader* (const juce::File&)>;
+
+        static constexpr int maxTracks = 64, maxInputs = 8, maxOutputs = 8;
+        static constexpr int loopCrossfadeMs = 10;
+
+        explicit StemMixerSource(juce::TimeSliceThread& readAheadThread)
+            : juce::Thread("Stem loader"), readAheadThread_(readAheadThread)
+        {
+            startThread();
+        }
+
+        ~StemMixerSource() override{
+            stopThread(4000);
+
+            delete pending_.withdraw();
+            delete retired_.exchange(nullptr);
+            delete active_;
+        }
+
+        /*
+
+                                    MESSAGE THREAD
+
+        */
+
+        /*
+        * replaces every track once the loader has opened and buffered `files`; files
+        * `readerFactory` can't open are skipped. `readerFactory` is called on the loader thread
+        */
+        void setFiles(const juce::Array<juce::File>& files, ReaderFactory readerFactory){
+            {
+                const juce::ScopedLock sl(requestLock_);
+                requestedFiles_ = files;
+                requestedFactory_ = std::move(readerFactory);
+                requestPending_ = true;
+                loading_ = true;
+            }
+
+            notify();
+        }
+
+        /* true from setFiles() until its tracks have been handed to the audio thread */
+        bool isLoading() const noexcept{
+            return loading_.load();
+        }
+
+        /* tracks that are already at the device rate, e.g. generated ones for the bench; built on the calling thread */
+        int setSources(std::vector<std::unique_ptr<juce::PositionableAudioSource>> sources, int numChannels){
+            auto set = std::make_unique<TrackSet>();
+
+            for(auto& source : sources){
+                if((int) set->tracks.size() == maxTracks)
+                    break;
+
+                auto track = std::make_unique<Track>("Track " + juce::String(set->tracks.size() + 1), numChannels);
+                track->sourceLength = source->getTotalLength();
+                track->ownedSource = std::move(source);
+                track->positionable = track->ownedSource.get();
+                set->tracks.push_back(std::move(track));
+            }
+
+            return publish_(std::move(set));
+        }
+
+        /*
+        * the track accessors work on the newest set and hold publishLock_, so the loader
+        * can't free a set while one of them is looking at it
+        */
+        int getNumTracks() const{
+            const juce::ScopedLock sl(publishLock_);
+            return published_ != nullptr ? (int) published_->tracks.size() : 0;
+        }
+
+        juce::String getTrackName(int track) const{
+            const juce::ScopedLock sl(publishLock_);
+            auto* t = getTrack_(track);
+            return t != nullptr ? t->name : juce::String();
+        }
+
+        int getTrackNumChannels(int track) const{
+            const juce::ScopedLock sl(publishLock_);
+            auto* t = getTrack_(track);
+            return t != nullptr ? t->numChannels : 0;
+        }
+
+        void setTrackGain(int track, float gain)            { const juce::ScopedLock sl(publishLock_); if(auto* t = getTrack_(track)) t->gain = juce::jmax(0.0f, gain); }
+        float getTrackGain(int track) const                 { const juce::ScopedLock sl(publishLock_); auto* t = getTrack_(track); return t != nullptr ? t->gain.load() : 0.0f; }
+
+        /* -1 is hard left, 1 hard right; balance law, so the centre leaves both outputs at unity */
+        void setTrackPan(int track, float pan)              { const juce::ScopedLock sl(publishLock_); if(auto* t = getTrack_(track)) t->pan = juce::jlimit(-1.0f, 1.0f, pan); }
+        float getTrackPan(int track) const                  { const juce::ScopedLock sl(publishLock_); auto* t = getTrack_(track); return t != nullptr ? t->pan.load() : 0.0f; }
+
+        void setTrackMute(int track, bool shouldMute)       { const juce::ScopedLock sl(publishLock_); if(auto* t = getTrack_(track)) t->mute = shouldMute; }
+        bool isTrackMuted(int track) const                  { const juce::ScopedLock sl(publishLock_); auto* t = getTrack_(track); return t != nullptr && t->mute.load(); }
+
+        /* gain from `inputChannel` of `track` into `outputChannel`, 0 to disconnect them */
+        void setRouting(int track, int inputChannel, int outputChannel, float gain){
+            const juce::ScopedLock sl(publishLock_);
+
+            if(auto* t = getTrack_(track))
+                if(juce::isPositiveAndBelow(inputChannel, maxInputs) && juce::isPositiveAndBelow(outputChannel, maxOutputs))
+                    t->routing[(size_t) (outputChannel * maxInputs + inputChannel)] = gain;
+        }
+
+        float getRouting(int track, int inputChannel, int outputChannel) const{
+            const juce::ScopedLock sl(publishLock_);
+            auto* t = getTrack_(track);
+
+            if(t == nullptr || ! juce::isPositiveAndBelow(inputChannel, maxInputs) || ! juce::isPositiveAndBelow(outputChannel, maxOutputs))
+                return 0.0f;
+
+            return t->routing[(size_t) (outputChannel * maxInputs + inputChannel)].load();
+        }
+
+        void setReadAheadMs(int milliseconds)               { readAheadMs_ = juce::jmax(50, milliseconds); }
+
+        /* waits for the read-ahead buffers instead of playing silence, for offline renders */
+        void setNonRealtime(bool isNonRealtime){
+            nonRealtime_ = isNonRealtime;
+
+            const juce::ScopedLock sl(publishLock_);
+
+            if(published_ != nullptr)
+                for(auto& track : published_->tracks)
+                    if(track->readAhead != nullptr)
+                        track->readAhead->setNonRealtime(isNonRealtime);
+        }
+
+        void setResamplingQuality(PolyphaseResamplingSource::Quality quality){
+            resamplingQuality_ = quality;
+        }
+
+        /* the bench compares the two mixing kernels */
+        void setUseVectorKernel(bool shouldUseVectorKernel){
+            useVectorKernel_ = shouldUseVectorKernel;
+        }
+
+        /*
+
+                                    AudioSource
+
+        */
+
+        void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override{
+            const juce::ScopedLock sl(pending_.getPrepareLock());
+
+            blockSize_ = juce::jmax(16, samplesPerBlockExpected);
+            sampleRate_ = sampleRate;
+
+            // a whole number of vectors, so the kernel never needs a scalar tail
+            stride_ = (blockSize_ + lanes - 1) / lanes * lanes;
+
+            for(auto& mix : mix_)
+                mix.allocate((size_t) stride_);
+
+            contributions_.resize((size_t) maxTracks * maxInputs);
+           #if JUCE_USE_SIMD
+            gains_.resize((size_t) maxTracks * maxInputs);
+           #endif
+
+            // called while the audio thread is stopped, so every set can be touched here
+            for(auto* set : { active_, pending_.getWaiting() })
+                if(set != nullptr)
+                    prepareSet_(*set);
+
+            if(active_ != nullptr)
+                reportedLength_ = active_->length;
+        }
+
+        void releaseResources() override{
+            const juce::ScopedLock sl(pending_.getPrepareLock());
+
+            for(auto* set : { active_, pending_.getWaiting() })
+                if(set != nullptr)
+                    for(auto& track : set->tracks)
+                        track->resampler->releaseResources();
+        }
+
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override{
+            swapInPendingSet_();
+
+            if(active_ == nullptr || active_->tracks.empty() || ! active_->prepared){
+                info.clearActiveBufferRegion();
+                position_ += info.numSamples;
+                reportedPosition_ = position_;
+                return;
+            }
+
+            auto seek = pendingSeek_.exchange(-1);
+
+            if(seek >= 0)
+                seekTracks_(seek);
+
+            if(active_->loopApplied != looping_.load())
+                applyLooping_(looping_.load());
+
+            // blocks bigger than announced are mixed in prepared-size pieces
+            for(auto done = 0; done < info.numSamples;){
+                auto numSamples = juce::jmin(blockSize_, info.numSamples - done);
+                renderBlock_(*info.buffer, info.startSample + done, numSamples);
+                done += numSamples;
+            }
+
+            position_ += info.numSamples;
+
+            // the read-ahead buffers have already carried on past the crossfade into the start
+            if(active_->loopApplied && active_->loopLength > active_->loopCrossfade)
+                while(position_ >= active_->loopLength)
+                    position_ -= active_->loopLength - active_->loopCrossfade;
+
+            reportedPosition_ = position_;
+        }
+
+        /*
+
+                                    PositionableAudioSource
+
+        */
+
+        void setNextReadPosition(juce::int64 newPosition) override{
+            pendingSeek_ = newPosition;
+            reportedPosition_ = newPosition;
+        }
+
+        juce::int64 getNextReadPosition() const override{
+            return reportedPosition_.load();
+        }
+
+        /* the longest track */
+        juce::int64 getTotalLength() const override{
+            return reportedLength_.load();
+        }
+
+        bool isLooping() const override{
+            return looping_.load();
+        }
+
+        /* picked up by the audio thread at its next block */
+        void setLooping(bool shouldLoop) override{
+            looping_ = shouldLoop;
+        }
+
+    private:
+       #if JUCE_USE_SIMD
+        using Vec = juce::dsp::SIMDRegister<float>;
+        static constexpr int lanes = (int) Vec::SIMDNumElements;
+       #else
+        static constexpr int lanes = 1;
+       #endif
+
+        struct Track{
+            Track(const juce::String& trackName, int channels)
+                : name(trackName), numChannels(juce::jlimit(1, maxInputs, channels))
+            {
+                // output c takes input c % numChannels, like a plain channel copy
+                for(auto output = 0; output < maxOutputs; ++output)
+                    for(auto input = 0; input < maxInputs; ++input)
+                        routing[(size_t) (output * maxInputs + input)] = input == output % numChannels ? 1.0f : 0.0f;
+            }
+
+            juce::String name;
+            int numChannels;
+            double sourceSampleRate = 0.0;      // 0 for sources already at the device rate
+            juce::int64 sourceLength = 0;
+
+            std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
+            std::unique_ptr<ReadAheadAudioSource> readAhead;
+            std::unique_ptr<juce::PositionableAudioSource> ownedSource;
+            juce::PositionableAudioSource* positionable = nullptr;
+            std::unique_ptr<PolyphaseResamplingSource> resampler;
+
+            std::atomic<float> gain { 1.0f }, pan { 0.0f };
+            std::atomic<bool> mute { false };
+            std::array<std::atomic<float>, maxOutputs * maxInputs> routing;
+
+            // audio thread only
+            AlignedFloats scratch;              // numChannels rows of stride_ samples
+            juce::AudioBuffer<float> view;      // refers to scratch
+            std::array<float, maxOutputs * maxInputs> lastCoefficients {};
+            bool hasPlayed = false;
+            juce::int64 length = 0;             // in device-rate samples
+        };
+
+        struct TrackSet{
+            std::vector<std::unique_ptr<Track>> tracks;
+            juce::int64 length = 0;
+            juce::int64 loopLength = 0;         // in device-rate samples, see prepareSet_()
+            juce::int64 loopCrossfade = 0;      // each pass after the first is this much shorter
+            bool prepared = false;
+            bool loopApplied = false;           // audio thread only
+        };
+
+        struct Contribution{
+            const float* source;
+            float startGain, gainStep;          // gain at the first sample, and per sample after it
+        };
+
+        juce::TimeSliceThread& readAheadThread_;
+        std::atomic<int> readAheadMs_ { 500 };
+        std::atomic<bool> nonRealtime_ { false }, looping_ { false };
+
+        juce::CriticalSection requestLock_;
+        juce::Array<juce::File> requestedFiles_;
+        ReaderFactory requestedFactory_;
+        std::atomic<bool> requestPending_ { false }, loading_ { false };
+
+        juce::CriticalSection publishLock_;             // published_ and the message thread's track accessors
+        std::atomic<PolyphaseResamplingSource::Quality> resamplingQuality_ { PolyphaseResamplingSource::Quality::standard };
+        bool useVectorKernel_ = true;
+
+        TrackSet* published_ = nullptr;                 // the newest set, under publishLock_
+        PreparedHandoff<TrackSet> pending_;             // waiting for the audio thread
+        std::atomic<TrackSet*> retired_ { nullptr };    // swapped out, freed by the loader
+        TrackSet* active_ = nullptr;                    // audio thread
+
+        int blockSize_ = 512, stride_ = 512;
+        double sampleRate_ = 0.0;
+        std::array<AlignedFloats, maxOutputs> mix_;
+        std::vector<Contribution> contributions_;
+       #if JUCE_USE_SIMD
+        std::vector<Vec> gains_;
+       #endif
+
+        juce::int64 position_ = 0;                      // audio thread
+        std::atomic<juce::int64> pendingSeek_ { -1 }, reportedPosition_ { 0 }, reportedLength_ { 0 };
+
+        Track* getTrack_(int index) const{
+            if(published_ == nullptr || ! juce::isPositiveAndBelow(index, (int) published_->tracks.size()))
+                return nullptr;
+
+            return published_->tracks[(size_t) index].get();
+        }
+
+        void run() override{
+            while(! threadShouldExit()){
+                delete retired_.exchange(nullptr);
+
+                if(requestPending_.load()){
+                    juce::Array<juce::File> files;
+                    ReaderFactory readerFactory;
+
+                    {
+                        const juce::ScopedLock sl(requestLock_);
+                        files.swapWith(requestedFiles_);
+                        std::swap(readerFactory, requestedFactory_);
+                        requestPending_ = false;
+                    }
+
+                    loadFiles_(files, readerFactory);
+
+                    const juce::ScopedLock sl(requestLock_);
+
+                    if(! requestPending_.load())
+                        loading_ = false;
+
+                    continue;
+                }
+
+                // the audio thread doesn't wake the loader, so retired sets are freed within this wait
+                wait(100);
+            }
+        }
+
+        void loadFiles_(const juce::Array<juce::File>& files, const ReaderFactory& readerFactory){
+            auto set = std::make_unique<TrackSet>();
+
+            for(const auto& file : files){
+                // a newer request replaces this one before it is heard
+                if(threadShouldExit() || requestPending_.load())
+                    return;
+
+                if((int) set->tracks.size() == maxTracks)
+                    break;
+
+                auto* reader = readerFactory != nullptr ? readerFactory(file) : nullptr;
+
+                if(reader == nullptr || reader->lengthInSamples <= 0 || reader->sampleRate <= 0.0){
+                    delete reader;
+                    continue;
+                }
+
+                auto track = std::make_unique<Track>(file.getFileNameWithoutExtension(), (int) reader->numChannels);
+                track->sourceSampleRate = reader->sampleRate;
+                track->sourceLength = reader->lengthInSamples;
+                track->readerSource = std::make_unique<juce::AudioFormatReaderSource>(reader, true);
+                track->readAhead = std::make_unique<ReadAheadAudioSource>(track->readerSource.get(), readAheadThread_, false,
+                                                                          (int) (readAheadMs_.load() * reader->sampleRate / 1000.0),
+                                                                          track->numChannels);
+                track->readAhead->setNonRealtime(nonRealtime_.load());
+                track->positionable = track->readAhead.get();
+                set->tracks.push_back(std::move(track));
+            }
+
+            publish_(std::move(set));
+        }
+
+        int publish_(std::unique_ptr<TrackSet> set){
+            auto numTracks = (int) set->tracks.size();
+
+            auto* replaced = pending_.offer(set.get(), [this] (TrackSet& s){
+                if(sampleRate_ > 0.0)
+                    prepareSet_(s);
+
+                // the accessors move on before the set they were using can be freed
+                const juce::ScopedLock sl(publishLock_);
+                published_ = &s;
+            });
+
+            set.release();
+            delete replaced;
+            sendChangeMessage();
+            return numTracks;
+        }
+
+        void prepareSet_(TrackSet& set){
+            set.length = 0;
+
+            for(auto& track : set.tracks){
+                if(track->resampler == nullptr)
+                    track->resampler = std::make_unique<PolyphaseResamplingSource>(track->positionable, false, track->numChannels,
+                                                                                   resamplingQuality_.load());
+
+                auto rate = track->sourceSampleRate > 0.0 ? track->sourceSampleRate : sampleRate_;
+                track->resampler->setResamplingRatio(rate / sampleRate_);
+                track->resampler->prepareToPlay(blockSize_, sampleRate_);
+                track->length = (juce::int64) ((double) track->sourceLength * sampleRate_ / rate);
+
+                track->scratch.allocate((size_t) (track->numChannels * stride_));
+                std::array<float*, maxInputs> channels {};
+
+                for(auto channel = 0; channel < track->numChannels; ++channel)
+                    channels[(size_t) channel] = track->scratch.get() + channel * stride_;
+
+                track->view.setDataToReferTo(channels.data(), track->numChannels, blockSize_);
+                set.length = juce::jmax(set.length, track->length);
+            }
+
+            /*
+            * each pass after the first is loopLength - loopCrossfade samples long. rounded up to
+            * a multiple of getLoopStep_(), it is a whole number of samples at every track's rate,
+            * so every read-ahead buffer wraps after exactly the same time and the tracks stay
+            * in sync pass after pass. the first pass differs by under a sample at most
+            */
+            auto step = getLoopStep_(set);
+            set.loopCrossfade = juce::jmin((juce::int64) (loopCrossfadeMs * sampleRate_ / 1000.0), set.length / 2);
+            auto pass = (set.length - set.loopCrossfade + step - 1) / step * step;
+            set.loopLength = pass + set.loopCrossfade;
+
+            for(auto& track : set.tracks){
+                if(track->readAhead == nullptr)
+                    continue;
+
+                auto ratio = track->sourceSampleRate / sampleRate_;
+                auto sourceLoopLength = (juce::int64) std::llround((double) set.loopLength * ratio);
+                auto sourcePass = (juce::int64) std::llround((double) pass * ratio);
+                track->readAhead->setLoopLength(sourceLoopLength);
+                track->readAhead->setLoopCrossfade((int) (sourceLoopLength - sourcePass));
+            }
+
+            set.prepared = true;
+        }
+
+        /* the smallest number of device samples that is a whole number of samples at every track's rate */
+        juce::int64 getLoopStep_(const TrackSet& set) const{
+            auto deviceRate = (juce::int64) std::llround(sampleRate_);
+            juce::int64 step = 1;
+
+            for(auto& track : set.tracks){
+                if(track->readAhead == nullptr)
+                    continue;
+
+                // deviceRate / gcd divides deviceRate, so the step never grows past one second
+                auto sourceRate = (juce::int64) std::llround(track->sourceSampleRate);
+                auto trackStep = deviceRate / std::gcd(deviceRate, juce::jmax((juce::int64) 1, sourceRate));
+                step = std::lcm(step, trackStep);
+            }
+
+            return juce::jmax((juce::int64) 1, step);
+        }
+
+        void applyLooping_(bool shouldLoop){
+            active_->loopApplied = shouldLoop;
+
+            // sources without a read-ahead buffer (the bench's) loop on their own
+            for(auto& track : active_->tracks){
+                if(track->readAhead != nullptr)
+                    track->readAhead->setLooping(shouldLoop);
+                else
+                    track->positionable->setLooping(shouldLoop);
+            }
+        }
+
+        void swapInPendingSet_(){
+            // the old set goes to retired_, so nothing is freed here; if the loader hasn't
+            // freed the previous one yet, the swap waits for a later block
+            if(pending_.getWaiting() == nullptr || retired_.load() != nullptr)
+                return;
+
+            retired_ = active_;
+            active_ = pending_.take();
+
+            // new stems start from the top, like a new playlist
+            if(active_ != nullptr){
+                reportedLength_ = active_->length;
+                reportedPosition_ = 0;
+                seekTracks_(0);
+            }
+        }
+
+        void seekTracks_(juce::int64 position){
+            position_ = position;
+
+            for(auto& track : active_->tracks){
+                auto rate = track->sourceSampleRate > 0.0 ? track->sourceSampleRate : sampleRate_;
+                track->positionable->setNextReadPosition((juce::int64) ((double) position * rate / sampleRate_));
+                track->resampler->flushBuffers();
+            }
+        }
+
+        void renderBlock_(juce::AudioBuffer<float>& buffer, int start, int numSamples){
+            auto numOutputs = juce::jmin(buffer.getNumChannels(), maxOutputs);
+
+            for(auto& track : active_->tracks)
+                track->resampler->getNextAudioBlock(juce::AudioSourceChannelInfo(&track->view, 0, numSamples));
+
+            for(auto output = 0; output < numOutputs; ++output){
+                // one entry per (track, input) that feeds this output in this block
+                auto numContributions = 0;
+
+                for(auto& track : active_->tracks){
+                    auto level = track->mute.load() ? 0.0f : track->gain.load();
+                    auto pan = track->pan.load();
+
+                    if(numOutputs >= 2 && output < 2)
+                        level *= output == 0 ? juce::jmin(1.0f, 1.0f - pan) : juce::jmin(1.0f, 1.0f + pan);
+
+                    for(auto input = 0; input < track->numChannels; ++input){
+                        auto index = (size_t) (output * maxInputs + input);
+                        auto target = level * track->routing[index].load();
+                        auto previous = track->hasPlayed ? track->lastCoefficients[index] : target;
+                        track->lastCoefficients[index] = target;
+
+                        if(previous == 0.0f && target == 0.0f)
+                            continue;
+
+                        contributions_[(size_t) numContributions++] = { track->scratch.get() + input * stride_, previous,
+                                                                        (target - previous) / (float) numSamples };
+                    }
+                }
+
+                auto* mix = mix_[(size_t) output].get();
+
+                if(useVectorKernel_)
+                    mixVector_(mix, numContributions, numSamples);
+                else
+                    mixScalar_(mix, numContributions, numSamples);
+
+                buffer.copyFrom(output, start, mix, numSamples);
+            }
+
+            for(auto& track : active_->tracks)
+                track->hasPlayed = true;
+
+            for(auto output = numOutputs; output < buffer.getNumChannels(); ++output)
+                buffer.clear(output, start, numSamples);
+        }
+
+        void mixScalar_(float* mix, int numContributions, int numSamples) const noexcept{
+            for(auto i = 0; i < numSamples; ++i){
+                auto sum = 0.0f;
+
+                for(auto c = 0; c < numContributions; ++c){
+                    const auto& contribution = contributions_[(size_t) c];
+                    sum += contribution.source[i] * (contribution.startGain + contribution.gainStep * (float) i);
+                }
+
+                mix[i] = sum;
+            }
+        }
+
+        void mixVector_(float* mix, int numContributions, int numSamples) noexcept{
+           #if JUCE_USE_SIMD
+            alignas(Vec) float laneIndex[lanes];
+
+            for(auto lane = 0; lane < lanes; ++lane)
+                laneIndex[lane] = (float) lane;
+
+            auto offsets = Vec::fromRawArray(laneIndex);
+
+            for(auto c = 0; c < numContributions; ++c){
+                const auto& contribution = contributions_[(size_t) c];
+                gains_[(size_t) c] = Vec::expand(contribution.startGain) + offsets * contribution.gainStep;
+            }
+
+            // the running gains step a whole vector at a time; the accumulator is stored once per vector
+            for(auto i = 0; i < numSamples; i += lanes){
+                auto sum = Vec::expand(0.0f);
+
+                for(auto c = 0; c < numContributions; ++c){
+                    const auto& contribution = contributions_[(size_t) c];
+                    auto& gain = gains_[(size_t) c];
+                    sum += Vec::fromRawArray(contribution.source + i) * gain;
+                    gain += Vec::expand(contribution.gainStep * (float) lanes);
+                }
+
+                sum.copyToRawArray(mix + i);
+            }
+           #else
+            mixScalar_(mix, numContributions, numSamples);
+           #endif
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StemMixerSource)
+};
+
+/*
+* One row per track of a StemMixerSource: name, gain, pan and mute. Shown over the
+* waveform; refresh() after the tracks change.
+*/
+class StemMixerPanel: public juce::Component
+{
+    public:
+        explicit StemMixerPanel(StemMixerSource& mixer): mixer_(mixer) {}
+
+        void refresh(){
+            rows_.clear();
+
+            for(auto track = 0; track < mixer_.getNumTracks(); ++track){
+                auto* row = rows_.add(new Row());
+                row->name.setText(mixer_.getTrackName(track), juce::dontSendNotification);
+
+                row->gain.setSliderStyle(juce::Slider::LinearHorizontal);
+                row->gain.setTextBoxStyle(juce::Slider::TextBoxRight, false, 60, 20);
+                row->gain.setRange(-60.0, 12.0, 0.1);
+                row->gain.setTextValueSuffix(" dB");
+                row->gain.setValue(juce::Decibels::gainToDecibels(mixer_.getTrackGain(track), -60.0f), juce::dontSendNotification);
+                row->gain.onValueChange = [this, track, row]{
+                    mixer_.setTrackGain(track, juce::Decibels::decibelsToGain((float) row->gain.getValue(), -60.0f));
+                };
+
+                row->pan.setSliderStyle(juce::Slider::LinearHorizontal);
+                row->pan.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+                row->pan.setRange(-1.0, 1.0, 0.01);
+                row->pan.setDoubleClickReturnValue(true, 0.0);
+                row->pan.setValue(mixer_.getTrackPan(track), juce::dontSendNotification);
+                row->pan.onValueChange = [this, track, row]{mixer_.setTrackPan(track, (float) row->pan.getValue());};
+
+                row->mute.setButtonText("Mute");
+                row->mute.setToggleState(mixer_.isTrackMuted(track), juce::dontSendNotification);
+                row->mute.onClick = [this, track, row]{mixer_.setTrackMute(track, row->mute.getToggleState());};
+
+                for(auto* component : std::initializer_list<juce::Component*> { &row->name, &row->gain, &row->pan, &row->mute })
+                    addAndMakeVisible(component);
+            }
+
+            resized();
+        }
+
+        void paint(juce::Graphics& g) override{
+            g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+        }
+
+        void resized() override{
+            auto bounds = getLocalBounds().reduced(4);
+
+            for(auto* row : rows_){
+                auto line = bounds.removeFromTop(26);
+                row->name.setBounds(line.removeFromLeft(juce::jmin(160, line.getWidth() / 4)));
+                row->mute.setBounds(line.removeFromRight(70));
+                row->pan.setBounds(line.removeFromRight(juce::jmin(120, line.getWidth() / 3)));
+                row->gain.setBounds(line);
+            }
+        }
+
+    private:
+        struct Row{
+            juce::Label name;
+            juce::Slider gain, pan;
+            juce::ToggleButton mute;
+        };
+
+        StemMixerSource& mixer_;
+        juce::OwnedArray<Row> rows_;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StemMixerPanel)
+};
@@ -0,0 +1,185 @@
+/*
+  ==============================================================================
+
+    thumbnailDiskCache.h
+    Created: 17 Oct 2026 12:09:18am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+/*
+* FileInputSource whose hash covers the file's path, size and modification time, so a
+* thumbnail cached for a file is never reused once the file has been rewritten.
+*/
+class KeyedFileInputSource: public juce::FileInputSource
+{
+    public:
+        explicit KeyedFileInputSource(const juce::File& file)
+            : juce::FileInputSource(file), key_(makeKey(file)) {}
+
+        juce::int64 hashCode() const override{
+            return key_;
+        }
+
+        static juce::int64 makeKey(const juce::File& file){
+            auto hash = (juce::uint64) file.getFullPathName().hashCode64();
+            hash ^= (juce::uint64) file.getSize() * 0x9e3779b97f4a7c15ULL;
+            hash ^= (juce::uint64) file.getLastModificationTime().toMilliseconds() * 0xc2b2ae3d27d4eb4fULL;
+            return (juce::int64) hash;
+        }
+
+    private:
+        juce::int64 key_;
+};
+
+
+/*
+* AudioThumbnailCache that keeps finished thumbnails on disk, one file per key, and holds
+* recently used ones in memory up to a byte budget with least-recently-used eviction.
+*
+* AudioThumbnail asks the cache before scanning a file, so a file seen in any earlier
+* session shows its complete waveform straight from the cache without reading audio.
+*/
+class PersistentThumbnailCache: public juce::AudioThumbnailCache
+{
+    public:
+        PersistentThumbnailCache(const juce::File& directory, size_t memoryBudgetBytes, juce::int64 diskBudgetBytes = 512 * 1024 * 1024)
+            : juce::AudioThumbnailCache(1), // the base class only needs to remember the thumbnail being built
+              directory_(directory), memoryBudget_(memoryBudgetBytes)
+        {
+            directory_.createDirectory();
+            pruneDirectory_(diskBudgetBytes);
+        }
+
+        static juce::File getDefaultDirectory(){
+            return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                       .getChildFile("audio_player")
+                       .getChildFile("thumbnails");
+        }
+
+        size_t getMemoryUsed() const{
+            const juce::ScopedLock sl(entriesLock_);
+            return memoryUsed_;
+        }
+
+    protected:
+        bool loadNewThumb(juce::AudioThumbnailBase& thumb, juce::int64 hashCode) override{
+            const juce::ScopedLock sl(entriesLock_);
+
+            auto* entry = findEntry_(hashCode);
+
+            if(entry == nullptr){
+                auto file = getFileFor_(hashCode);
+                juce::MemoryBlock data;
+
+                if(! file.existsAsFile() || ! file.loadFileAsData(data) || data.isEmpty())
+                    return false;
+
+                file.setLastAccessTime(juce::Time::getCurrentTime());
+                entry = addEntry_(hashCode, std::move(data));
+            }
+
+            entry->lastUsed = ++useCounter_;
+            juce::MemoryInputStream in(entry->data, false);
+            thumb.loadFrom(in);
+            return true;
+        }
+
+        void saveNewlyFinishedThumbnail(const juce::AudioThumbnailBase& thumb, juce::int64 hashCode) override{
+            juce::MemoryBlock data;
+
+            {
+                juce::MemoryOutputStream out(data, false);
+                thumb.saveTo(out);
+            }
+
+            getFileFor_(hashCode).replaceWithData(data.getData(), data.getSize());
+
+            const juce::ScopedLock sl(entriesLock_);
+
+            if(auto* existing = findEntry_(hashCode)){
+                memoryUsed_ -= existing->data.getSize();
+                entries_.removeObject(existing);
+            }
+
+            addEntry_(hashCode, std::move(data))->lastUsed = ++useCounter_;
+        }
+
+    private:
+        struct Entry{
+            juce::int64 hash;
+            juce::MemoryBlock data;
+            juce::uint32 lastUsed = 0;
+        };
+
+        juce::File directory_;
+        size_t memoryBudget_, memoryUsed_ = 0;
+        juce::uint32 useCounter_ = 0;
+        juce::OwnedArray<Entry> entries_;
+        juce::CriticalSection entriesLock_;
+
+        juce::File getFileFor_(juce::int64 hashCode) const{
+            return directory_.getChildFile(juce::String::toHexString(hashCode) + ".thumb");
+        }
+
+        Entry* findEntry_(juce::int64 hashCode) const{
+            for(auto* entry : entries_)
+                if(entry->hash == hashCode)
+                    return entry;
+
+            return nullptr;
+        }
+
+        Entry* addEntry_(juce::int64 hashCode, juce::MemoryBlock&& data){
+            memoryUsed_ += data.getSize();
+            auto* entry = entries_.add(new Entry { hashCode, std::move(data) });
+
+            // drop least recently used thumbnails until we are back inside the budget,
+            // always keeping the one that was just added
+            while(memoryUsed_ > memoryBudget_ && entries_.size() > 1){
+                Entry* oldest = nullptr;
+
+                for(auto* e : entries_)
+                    if(e != entry && (oldest == nullptr || e->lastUsed < oldest->lastUsed))
+                        oldest = e;
+
+                memoryUsed_ -= oldest->data.getSize();
+                entries_.removeObject(oldest);
+            }
+
+            return entry;
+        }
+
+        void pruneDirectory_(juce::int64 diskBudgetBytes){
+            /*
+            * thumbnails of rewritten or deleted files are never looked up again, so keep the
+            * directory bounded by deleting the least recently accessed files first. the
+            * waveform pyramids kept under the same keys count against the same budget
+            */
+            auto files = directory_.findChildFiles(juce::File::findFiles, false, "*.thumb;*.pyramid");
+            juce::int64 total = 0;
+
+            for(auto& f : files)
+                total += f.getSize();
+
+            if(total <= diskBudgetBytes)
+                return;
+
+            std::sort(files.begin(), files.end(), [] (const juce::File& a, const juce::File& b){
+                return a.getLastAccessTime() < b.getLastAccessTime();
+            });
+
+            for(auto& f : files){
+                if(total <= diskBudgetBytes)
+                    break;
+
+                total -= f.getSize();
+                f.deleteFile();
+            }
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PersistentThumbnailCache)
+};
@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    timecodeDisplay.h
+    Created: 17 Oct 2026 12:11:32am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <cstring>
+
+/*
+* Draws "mm:ss:mmm/mm:ss:mmm" (or a fixed message) from a plain char buffer.
+*
+* A Label would need a new juce::String on every timer tick. Here the text is formatted
+* into a fixed buffer, compared with the previous one, and drawn from glyph images that
+* are rendered once per character, so updating the time does not allocate.
+*/
+class TimecodeDisplay: public juce::Component
+{
+    public:
+        explicit TimecodeDisplay(float fontHeight = 20.0f): font_(fontHeight){
+            setOpaque(false);
+            text_[0] = 0;
+        }
+
+        void setTime(double positionSeconds, double lengthSeconds){
+            char newText[sizeof(text_)];
+            auto* p = newText;
+
+            p = writeTime_(p, positionSeconds);
+            *p++ = '/';
+            p = writeTime_(p, lengthSeconds);
+            *p = 0;
+
+            setText_(newText);
+        }
+
+        /* copied into the fixed text buffer, truncated to fit */
+        void setMessage(const char* message){
+            setText_(message);
+        }
+
+        void paint(juce::Graphics& g) override{
+            auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+            if(scale != glyphScale_){
+                for(auto& glyph : glyphs_)
+                    glyph = {};
+
+                glyphScale_ = scale;
+            }
+
+            auto x = 0.0f;
+            auto height = (float) getHeight();
+
+            for(auto* c = text_; *c != 0; ++c){
+                auto& glyph = getGlyph_((unsigned char) *c);
+
+                if(glyph.image.isValid())
+                    g.drawImage(glyph.image, { x, (height - glyph.height) * 0.5f, glyph.width, glyph.height });
+
+                x += glyph.width;
+            }
+        }
+
+        void colourChanged() override{
+            glyphScale_ = 0.0f;
+            repaint();
+        }
+
+    private:
+        struct Glyph{
+            juce::Image image;
+            float width = 0.0f, height = 0.0f;
+        };
+
+        juce::Font font_;
+        char text_[32];
+        std::array<Glyph, 128> glyphs_;
+        float glyphScale_ = 0.0f;
+
+        void setText_(const char* newText){
+            if(std::strncmp(newText, text_, sizeof(text_)) == 0)
+                return;
+
+            std::strncpy(text_, newText, sizeof(text_) - 1);
+            text_[sizeof(text_) - 1] = 0;
+            repaint();
+        }
+
+        static char* writeTime_(char* p, double seconds){
+            // same fields as the old "%02d:%02d:%03d" label text
+            auto totalMillis = (juce::int64) (juce::jmax(0.0, seconds) * 1000.0);
+            auto minutes = (int) ((totalMillis / 60000) % 60);
+            auto secs = (int) ((totalMillis / 1000) % 60);
+            auto millis = (int) (totalMillis % 1000);
+
+            *p++ = (char) ('0' + minutes / 10);
+            *p++ = (char) ('0' + minutes % 10);
+            *p++ = ':';
+            *p++ = (char) ('0' + secs / 10);
+            *p++ = (char) ('0' + secs % 10);
+            *p++ = ':';
+            *p++ = (char) ('0' + millis / 100);
+            *p++ = (char) ('0' + (millis / 10) % 10);
+            *p++ = (char) ('0' + millis % 10);
+            return p;
+        }
+
+        Glyph& getGlyph_(unsigned char c){
+            auto& glyph = glyphs_[c & 0x7f];
+
+            if(glyph.width == 0.0f || ! glyph.image.isValid()){
+                // rendered once per character (and per display scale), then reused on every paint
+                auto character = juce::String::charToString((juce::juce_wchar) (c & 0x7f));
+                glyph.width = font_.getStringWidthFloat(character);
+                glyph.height = font_.getHeight();
+
+                auto w = juce::jmax(1, juce::roundToInt(glyph.width * glyphScale_));
+                auto h = juce::jmax(1, juce::roundToInt(glyph.height * glyphScale_));
+
+                glyph.image = juce::Image(juce::Image::ARGB, w, h, true);
+                juce::Graphics ig(glyph.image);
+                ig.addTransform(juce::AffineTransform::scale(glyphScale_));
+                ig.setFont(font_);
+                ig.setColour(findColour(juce::Label::textColourId));
+                ig.drawSingleLineText(character, 0, juce::roundToInt(font_.getAscent()));
+            }
+
+            return glyph;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TimecodeDisplay)
+};
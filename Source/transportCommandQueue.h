@@ -0,0 +1,382 @@
+/*
+  ==============================================================================
+
+    transportCommandQueue.h
+    Created: 17 Oct 2026 12:42:44am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+/*
+* Transport for a PositionableAudioSource that is driven entirely from the audio thread.
+*
+* play(), pause(), stop(), seek() and setLooping() don't touch the source. They push a
+* command into a lock-free FIFO, stamped with the sample time it should take effect at
+* (see getSampleClock()), or `now` for the start of the next block. The audio thread
+* splits its block at that exact sample, applies the command and fades in or out over
+* fadeMs so nothing clicks; a seek while playing fades out, jumps and fades back in.
+*
+* Every change the audio thread makes is reported back through a second FIFO, which the
+* message thread drains with collectEvents(). The UI shows what the audio thread did
+* rather than what it was asked to do.
+*
+* The commands come from one thread (the message thread), the events are read by one.
+*/
+class QueuedTransportSource: public juce::AudioSource
+{
+    public:
+        static constexpr juce::int64 now = -1;
+
+        struct Event{
+            enum Type{ started, paused, stopped, reachedEnd, seeked, loopingChanged };
+
+            Type type = stopped;
+            juce::int64 sampleTime = 0;     // on the sample clock, where it happened
+            juce::int64 position = 0;       // of the source, after the change
+            bool looping = false;
+        };
+
+        explicit QueuedTransportSource(juce::PositionableAudioSource& source, double fadeMs = 5.0)
+            : source_(source), fadeMs_(fadeMs) {}
+
+        /*
+
+                                    MESSAGE THREAD
+
+        */
+
+        void play(juce::int64 atSample = now){
+            // counted before it is sent, so isPlaying() is true from this call on
+            ++pendingStarts_;
+
+            if(! send_({CommandType::play, atSample}))
+                --pendingStarts_;
+        }
+
+        void pause(juce::int64 atSample = now)      { send_({CommandType::pause, atSample}); }
+
+        /* fades out and rewinds to the start */
+        void stop(juce::int64 atSample = now)       { send_({CommandType::stop, atSample}); }
+
+        void seek(juce::int64 position, juce::int64 atSample = now){
+            send_({CommandType::seek, atSample, juce::jmax((juce::int64) 0, position)});
+        }
+
+        void setPosition(double seconds){
+            seek((juce::int64) (seconds * sampleRate_.load()));
+        }
+
+        void setLooping(bool shouldLoop, juce::int64 atSample = now){
+            send_({CommandType::setLooping, atSample, 0, shouldLoop});
+        }
+
+        /* playing, fading out, or about to start because of a play() that is still in the queue */
+        bool isPlaying() const noexcept{
+            return playing_.load() || pendingStarts_.load() > 0;
+        }
+
+        double getCurrentPosition() const{
+            auto sampleRate = sampleRate_.load();
+            return sampleRate > 0.0 ? (double) source_.getNextReadPosition() / sampleRate : 0.0;
+        }
+
+        double getLengthInSeconds() const{
+            auto sampleRate = sampleRate_.load();
+            return sampleRate > 0.0 ? (double) source_.getTotalLength() / sampleRate : 0.0;
+        }
+
+        /* samples rendered since prepareToPlay(); commands are timed on this clock */
+        juce::int64 getSampleClock() const noexcept{
+            return clockForReaders_.load();
+        }
+
+        /* commands lost because the queue was full; the queue holds far more than a UI can send per block */
+        int getDroppedCommands() const noexcept{
+            return droppedCommands_.load();
+        }
+
+        /* calls `callback` with every event the audio thread sent since the last call and returns how many there were */
+        template<typename Callback>
+        int collectEvents(Callback&& callback){
+            auto numEvents = 0;
+
+            for(auto ready = events_.getNumReady(); ready > 0; ready = events_.getNumReady()){
+                events_.read(ready).forEach([&] (int index){
+                    callback(eventSlots_[(size_t) index]);
+                    ++numEvents;
+                });
+            }
+
+            return numEvents;
+        }
+
+        /*
+
+                                    AudioSource
+
+        */
+
+        void prepareToPlay(int samplesPerBlockExpected, double sampleRate) override{
+            sampleRate_ = sampleRate;
+            fadeLength_ = juce::jmax(1, juce::roundToInt(fadeMs_ * sampleRate / 1000.0));
+            clock_ = 0;
+            clockForReaders_ = 0;
+            source_.prepareToPlay(samplesPerBlockExpected, sampleRate);
+        }
+
+        void releaseResources() override{
+            source_.releaseResources();
+        }
+
+        void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override{
+            receiveCommands_();
+
+            for(auto done = 0; done < info.numSamples;){
+                now_ = clock_ + done;
+
+                while(numScheduled_ > 0 && scheduled_[0].sampleTime <= now_){
+                    apply_(scheduled_[0]);
+                    std::move(scheduled_.begin() + 1, scheduled_.begin() + numScheduled_--, scheduled_.begin());
+                }
+
+                // up to the next command, or the end of the fade, whichever comes first
+                auto segmentEnd = info.numSamples;
+
+                if(numScheduled_ > 0)
+                    segmentEnd = (int) juce::jmin((juce::int64) segmentEnd, scheduled_[0].sampleTime - clock_);
+
+                if(phase_ == Phase::fadingIn || phase_ == Phase::fadingOut)
+                    segmentEnd = juce::jmin(segmentEnd, done + fadeLength_ - fadePosition_);
+
+                render_(*info.buffer, info.startSample + done, segmentEnd - done);
+                done = segmentEnd;
+            }
+
+            clock_ += info.numSamples;
+            clockForReaders_ = clock_;
+        }
+
+    private:
+        enum class CommandType{ play, pause, stop, seek, setLooping };
+        enum class Phase{ stopped, fadingIn, playing, fadingOut };
+
+        struct Command{
+            CommandType type = CommandType::play;
+            juce::int64 sampleTime = now;
+            juce::int64 position = 0;
+            bool looping = false;
+        };
+
+        static constexpr int queueSize = 256, maxScheduled = 64;
+
+        juce::PositionableAudioSource& source_;
+        double fadeMs_;
+
+        juce::AbstractFifo commands_ { queueSize };
+        std::array<Command, queueSize> commandSlots_;
+        juce::AbstractFifo events_ { queueSize };
+        std::array<Event, queueSize> eventSlots_;
+
+        std::atomic<int> pendingStarts_ { 0 }, droppedCommands_ { 0 };
+        std::atomic<bool> playing_ { false };
+        std::atomic<double> sampleRate_ { 0.0 };
+        std::atomic<juce::int64> clockForReaders_ { 0 };
+
+        // audio thread only
+        std::array<Command, maxScheduled> scheduled_;   // commands waiting for their sample time, earliest first
+        int numScheduled_ = 0;
+        juce::int64 clock_ = 0, now_ = 0;
+        Phase phase_ = Phase::stopped;
+        int fadeLength_ = 1, fadePosition_ = 0;
+        bool looping_ = false, pausePending_ = false, stopPending_ = false;
+        juce::int64 seekPending_ = -1;
+
+        bool send_(const Command& command){
+            auto sent = false;
+
+            commands_.write(1).forEach([&] (int index){
+                commandSlots_[(size_t) index] = command;
+                sent = true;
+            });
+
+            if(! sent)
+                ++droppedCommands_;
+
+            return sent;
+        }
+
+        void post_(Event::Type type){
+            // the message thread drains the events every timer tick; if it ever falls this far behind, the newest are lost
+            events_.write(1).forEach([&] (int index){
+                eventSlots_[(size_t) index] = { type, now_, source_.getNextReadPosition(), looping_ };
+            });
+        }
+
+        void receiveCommands_(){
+            commands_.read(commands_.getNumReady()).forEach([this] (int index){
+                auto command = commandSlots_[(size_t) index];
+
+                // `now` and late commands take effect at the start of this block
+                command.sampleTime = juce::jmax(command.sampleTime, clock_);
+
+                if(numScheduled_ == maxScheduled){
+                    // more commands waiting than a user can send: the oldest is applied early
+                    now_ = clock_;
+                    apply_(scheduled_[0]);
+                    std::move(scheduled_.begin() + 1, scheduled_.begin() + numScheduled_--, scheduled_.begin());
+                }
+
+                // after every command with the same time, so commands sent together keep their order
+                auto position = numScheduled_;
+
+                while(position > 0 && scheduled_[(size_t) position - 1].sampleTime > command.sampleTime){
+                    scheduled_[(size_t) position] = scheduled_[(size_t) position - 1];
+                    --position;
+                }
+
+                scheduled_[(size_t) position] = command;
+                ++numScheduled_;
+            });
+        }
+
+        void setPhase_(Phase phase){
+            phase_ = phase;
+            playing_ = phase != Phase::stopped;
+        }
+
+        void startFadeOut_(){
+            // a fade-in that is cut short fades out from the gain it had reached
+            fadePosition_ = phase_ == Phase::fadingIn ? fadeLength_ - fadePosition_ : 0;
+            setPhase_(Phase::fadingOut);
+        }
+
+        void apply_(const Command& command){
+            switch(command.type){
+                case CommandType::play:
+                    --pendingStarts_;
+                    pausePending_ = stopPending_ = false;
+
+                    if(phase_ == Phase::stopped){
+                        fadePosition_ = 0;
+                        setPhase_(Phase::fadingIn);
+                    }
+                    else if(phase_ == Phase::fadingOut && seekPending_ < 0){
+                        fadePosition_ = fadeLength_ - fadePosition_;
+                        setPhase_(Phase::fadingIn);
+                    }
+
+                    post_(Event::started);
+                    break;
+
+                case CommandType::pause:
+                case CommandType::stop:
+                    if(command.type == CommandType::stop)
+                        seekPending_ = 0;
+
+                    if(phase_ == Phase::stopped){
+                        finishSeek_();
+                        post_(command.type == CommandType::stop ? Event::stopped : Event::paused);
+                        break;
+                    }
+
+                    if(phase_ != Phase::fadingOut)
+                        startFadeOut_();
+
+                    stopPending_ = stopPending_ || command.type == CommandType::stop;
+                    pausePending_ = ! stopPending_;
+                    break;
+
+                case CommandType::seek:
+                    seekPending_ = command.position;
+
+                    if(phase_ == Phase::stopped)
+                        finishSeek_();
+                    else if(phase_ != Phase::fadingOut)
+                        startFadeOut_();
+
+                    break;
+
+                case CommandType::setLooping:
+                    looping_ = command.looping;
+                    source_.setLooping(looping_);
+                    post_(Event::loopingChanged);
+                    break;
+            }
+        }
+
+        void finishSeek_(){
+            if(seekPending_ < 0)
+                return;
+
+            source_.setNextReadPosition(seekPending_);
+            seekPending_ = -1;
+            post_(Event::seeked);
+        }
+
+        void finishFade_(){
+            if(phase_ == Phase::fadingIn){
+                setPhase_(Phase::playing);
+                return;
+            }
+
+            // faded out: jump, then either stay stopped or fade back in at the new position
+            finishSeek_();
+
+            if(stopPending_ || pausePending_){
+                setPhase_(Phase::stopped);
+                post_(stopPending_ ? Event::stopped : Event::paused);
+                stopPending_ = pausePending_ = false;
+            }
+            else{
+                fadePosition_ = 0;
+                setPhase_(Phase::fadingIn);
+            }
+        }
+
+        void render_(juce::AudioBuffer<float>& buffer, int start, int numSamples){
+            if(phase_ == Phase::stopped){
+                buffer.clear(start, numSamples);
+                return;
+            }
+
+            source_.getNextAudioBlock(juce::AudioSourceChannelInfo(&buffer, start, numSamples));
+
+            if(phase_ == Phase::fadingIn || phase_ == Phase::fadingOut){
+                auto gainStart = (float) fadePosition_ / (float) fadeLength_;
+                auto gainEnd = (float) (fadePosition_ + numSamples) / (float) fadeLength_;
+
+                if(phase_ == Phase::fadingOut){
+                    gainStart = 1.0f - gainStart;
+                    gainEnd = 1.0f - gainEnd;
+                }
+
+                for(auto channel = 0; channel < buffer.getNumChannels(); ++channel)
+                    buffer.applyGainRamp(channel, start, numSamples, gainStart, gainEnd);
+
+                fadePosition_ += numSamples;
+
+                if(fadePosition_ >= fadeLength_){
+                    now_ += numSamples;
+                    finishFade_();
+                    return;
+                }
+            }
+
+            // like AudioTransportSource: the source has run past its end once the position passes length + 1
+            auto length = source_.getTotalLength();
+
+            if(phase_ != Phase::fadingOut && ! looping_ && length > 0 && source_.getNextReadPosition() > length + 1){
+                now_ += numSamples;
+                setPhase_(Phase::stopped);
+                post_(Event::reachedEnd);
+            }
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(QueuedTransportSource)
+};
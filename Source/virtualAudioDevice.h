@@ -0,0 +1,383 @@
+/*
+  ==============================================================================
+
+    virtualAudioDevice.h
+    Created: 17 Oct 2026 12:55:51am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+/*
+* An AudioIODevice without hardware, so an AudioAppComponent can run its real
+* setAudioChannels() / AudioDeviceManager path on a headless machine.
+*
+* Callbacks are driven by one of two clocks. Clock::realtime has its own thread that
+* schedules every block against the wall clock, optionally sped up. Clock::manual renders
+* blocks only when process() is called, which makes a run deterministic. Blocks can cycle
+* through several sizes. Every start can be delayed by random jitter, and every Nth one
+* forced late, to see how the code under test copes.
+*
+* Everything the callback writes is recorded into a buffer allocated at open(), so the
+* output can be checked sample by sample and getLatencyMs() can find the first audible
+* sample after an event. A block counts as a glitch when it is finished after its output
+* was due (one block after its ideal start). It is the code's own glitch when the callback
+* alone took longer than the block lasts, whatever the device did.
+*
+* Install it with VirtualAudioDeviceType before calling setAudioChannels():
+*
+*     deviceManager.addAudioDeviceType(std::make_unique<VirtualAudioDeviceType>(settings));
+*     deviceManager.setCurrentAudioDeviceType(VirtualAudioDeviceType::typeName, true);
+*/
+class VirtualAudioDevice: public juce::AudioIODevice, private juce::Thread
+{
+    public:
+        enum class Clock{ realtime, manual };
+
+        struct Settings{
+            Clock clock = Clock::realtime;
+            double speed = 1.0;                         // realtime clock: 2 runs twice as fast, 0 as fast as possible
+            double sampleRate = 44100.0;
+            int numOutputChannels = 2;
+            int bufferSize = 512;                       // the largest block, reported as the output latency
+            std::vector<int> blockSizes;                // cycled through when not empty
+            double jitterMs = 0.0;                      // every start is delayed by up to this much, at random
+            int lateEvery = 0;                          // every lateEvery-th start is delayed by lateMs on top
+            double lateMs = 0.0;
+            double recordSeconds = 60.0;
+            juce::int64 seed = 1;
+        };
+
+        struct Stats{
+            juce::int64 callbacks = 0, samples = 0;
+            juce::int64 glitches = 0;                   // blocks finished after their output was due
+            juce::int64 ownGlitches = 0;                // callbacks that took longer than their block lasts
+            juce::int64 forcedLate = 0;
+            double maxCallbackMs = 0.0, maxLatenessMs = 0.0;
+        };
+
+        VirtualAudioDevice(const juce::String& deviceName, const Settings& settings)
+            : juce::AudioIODevice(deviceName, "Virtual"), juce::Thread("Virtual audio device"),
+              settings_(settings), random_(settings.seed) {}
+
+        ~VirtualAudioDevice() override{
+            close();
+        }
+
+        /*
+
+                                    AudioIODevice
+
+        */
+
+        juce::StringArray getOutputChannelNames() override{
+            juce::StringArray names;
+
+            for(auto channel = 0; channel < settings_.numOutputChannels; ++channel)
+                names.add("Output " + juce::String(channel + 1));
+
+            return names;
+        }
+
+        juce::StringArray getInputChannelNames() override              { return {}; }
+        juce::Array<double> getAvailableSampleRates() override          { return { settings_.sampleRate }; }
+        juce::Array<int> getAvailableBufferSizes() override             { return { settings_.bufferSize }; }
+        int getDefaultBufferSize() override                             { return settings_.bufferSize; }
+
+        juce::String open(const juce::BigInteger&, const juce::BigInteger& outputChannels, double, int) override{
+            close();
+
+            activeOutputs_ = outputChannels;
+            activeOutputs_.setRange(settings_.numOutputChannels, activeOutputs_.getHighestBit() + 1 - settings_.numOutputChannels, false);
+
+            // the rate and block size are the device's own, like hardware with a fixed clock
+            outputs_.setSize(settings_.numOutputChannels, settings_.bufferSize);
+            recording_.setSize(settings_.numOutputChannels, juce::jmax(1, (int) (settings_.recordSeconds * settings_.sampleRate)));
+            recording_.clear();
+            recorded_ = 0;
+            rendered_ = 0;
+            blockIndex_ = 0;
+            stats_ = {};
+            isOpen_ = true;
+            return {};
+        }
+
+        void close() override{
+            stop();
+            isOpen_ = false;
+        }
+
+        bool isOpen() override                                          { return isOpen_; }
+
+        void start(juce::AudioIODeviceCallback* callback) override{
+            if(! isOpen_ || callback == nullptr || isPlaying_)
+                return;
+
+            callback->audioDeviceAboutToStart(this);
+
+            {
+                const juce::ScopedLock sl(callbackLock_);
+                callback_ = callback;
+            }
+
+            isPlaying_ = true;
+            startMs_ = juce::Time::getMillisecondCounterHiRes();
+
+            if(settings_.clock == Clock::realtime)
+                startThread(juce::Thread::Priority::highest);
+        }
+
+        void stop() override{
+            stopThread(4000);
+
+            juce::AudioIODeviceCallback* callback = nullptr;
+
+            {
+                const juce::ScopedLock sl(callbackLock_);
+                std::swap(callback, callback_);
+            }
+
+            isPlaying_ = false;
+
+            if(callback != nullptr)
+                callback->audioDeviceStopped();
+        }
+
+        bool isPlaying() override                                       { return isPlaying_; }
+        juce::String getLastError() override                            { return {}; }
+        int getCurrentBufferSizeSamples() override                      { return settings_.bufferSize; }
+        double getCurrentSampleRate() override                          { return settings_.sampleRate; }
+        int getCurrentBitDepth() override                               { return 32; }
+        juce::BigInteger getActiveOutputChannels() const override       { return activeOutputs_; }
+        juce::BigInteger getActiveInputChannels() const override        { return {}; }
+        int getOutputLatencyInSamples() override                        { return settings_.bufferSize; }
+        int getInputLatencyInSamples() override                         { return 0; }
+
+        /*
+
+                                    DRIVING AND CHECKING
+
+        */
+
+        /* manual clock: renders `numBlocks` callbacks on the calling thread */
+        void process(int numBlocks){
+            jassert(settings_.clock == Clock::manual);
+
+            for(auto block = 0; block < numBlocks && isPlaying_; ++block){
+                auto delayMs = nextStartDelayMs_();
+                renderBlock_(delayMs);
+            }
+        }
+
+        /*
+        * the stream position the device clock has reached, in samples: what the next callback
+        * renders on the manual clock, where the wall clock says playback should be otherwise
+        */
+        juce::int64 getClockPosition() const{
+            if(settings_.clock == Clock::manual || settings_.speed <= 0.0 || ! isPlaying_)
+                return rendered_.load();
+
+            auto elapsedMs = juce::Time::getMillisecondCounterHiRes() - startMs_.load();
+            return (juce::int64) (elapsedMs * settings_.speed * settings_.sampleRate / 1000.0);
+        }
+
+        /* samples of getRecording() that hold output; the rest of it is silence */
+        juce::int64 getNumRecordedSamples() const noexcept{
+            return recorded_.load();
+        }
+
+        const juce::AudioBuffer<float>& getRecording() const noexcept{
+            return recording_;
+        }
+
+        /* first recorded sample at or after `position` louder than `threshold` on any channel, -1 if none */
+        juce::int64 findFirstAudible(juce::int64 position, float threshold = 1.0e-4f) const{
+            auto numRecorded = recorded_.load();
+
+            for(auto i = juce::jmax((juce::int64) 0, position); i < numRecorded; ++i)
+                for(auto channel = 0; channel < recording_.getNumChannels(); ++channel)
+                    if(std::abs(recording_.getSample(channel, (int) i)) > threshold)
+                        return i;
+
+            return -1;
+        }
+
+        /*
+        * time from an event at clock position `eventPosition` (see getClockPosition()) until the
+        * first audible sample left the device, including the block of output latency. -1 when
+        * nothing audible has been recorded since
+        */
+        double getLatencyMs(juce::int64 eventPosition, float threshold = 1.0e-4f) const{
+            // a sample at position p is heard one buffer after the clock reaches p
+            auto latency = (juce::int64) settings_.bufferSize;
+            auto first = findFirstAudible(eventPosition - latency, threshold);
+
+            return first < 0 ? -1.0 : (double) (first + latency - eventPosition) * 1000.0 / settings_.sampleRate;
+        }
+
+        Stats getStats() const{
+            const juce::ScopedLock sl(statsLock_);
+            return stats_;
+        }
+
+    private:
+        Settings settings_;
+        juce::Random random_;
+
+        juce::CriticalSection callbackLock_;
+        juce::AudioIODeviceCallback* callback_ = nullptr;
+        juce::BigInteger activeOutputs_;
+        juce::AudioBuffer<float> outputs_, recording_;
+        std::atomic<bool> isOpen_ { false }, isPlaying_ { false };
+        std::atomic<double> startMs_ { 0.0 };
+        std::atomic<juce::int64> rendered_ { 0 }, recorded_ { 0 };
+        size_t blockIndex_ = 0;
+
+        juce::CriticalSection statsLock_;
+        Stats stats_;
+
+        void run() override{
+            while(! threadShouldExit()){
+                auto delayMs = nextStartDelayMs_();
+
+                if(settings_.speed > 0.0){
+                    // ideal start from the samples already played, so the clock never drifts
+                    auto idealMs = startMs_.load() + (double) rendered_.load() * 1000.0 / (settings_.sampleRate * settings_.speed);
+                    auto startAtMs = idealMs + delayMs;
+
+                    for(auto remainingMs = startAtMs - juce::Time::getMillisecondCounterHiRes(); remainingMs > 0.0 && ! threadShouldExit();
+                        remainingMs = startAtMs - juce::Time::getMillisecondCounterHiRes()){
+                        // sleep most of the way, then spin for the last millisecond
+                        if(remainingMs > 1.5)
+                            wait((int) (remainingMs - 1.0));
+                        else
+                            juce::Thread::yield();
+                    }
+
+                    if(threadShouldExit())
+                        break;
+
+                    // measured, so the sleep's own inaccuracy counts as the device's
+                    delayMs = juce::jmax(0.0, juce::Time::getMillisecondCounterHiRes() - idealMs);
+                }
+
+                renderBlock_(delayMs);
+            }
+        }
+
+        double nextStartDelayMs_(){
+            auto delayMs = settings_.jitterMs > 0.0 ? random_.nextDouble() * settings_.jitterMs : 0.0;
+
+            if(settings_.lateEvery > 0 && (getStats().callbacks + 1) % settings_.lateEvery == 0){
+                delayMs += settings_.lateMs;
+
+                const juce::ScopedLock sl(statsLock_);
+                ++stats_.forcedLate;
+            }
+
+            return delayMs;
+        }
+
+        void renderBlock_(double startDelayMs){
+            auto numSamples = settings_.bufferSize;
+
+            if(! settings_.blockSizes.empty())
+                numSamples = juce::jlimit(1, settings_.bufferSize, settings_.blockSizes[blockIndex_++ % settings_.blockSizes.size()]);
+
+            outputs_.clear();
+
+            auto startMs = juce::Time::getMillisecondCounterHiRes();
+
+            {
+                const juce::ScopedLock sl(callbackLock_);
+
+                if(callback_ != nullptr)
+                    callback_->audioDeviceIOCallbackWithContext(nullptr, 0, outputs_.getArrayOfWritePointers(), outputs_.getNumChannels(),
+                                                                numSamples, {});
+            }
+
+            auto callbackMs = juce::Time::getMillisecondCounterHiRes() - startMs;
+
+            // the recording buffer was allocated at open(), so nothing here allocates
+            auto position = recorded_.load();
+            auto numToRecord = (int) juce::jmin((juce::int64) numSamples, (juce::int64) recording_.getNumSamples() - position);
+
+            for(auto channel = 0; numToRecord > 0 && channel < outputs_.getNumChannels(); ++channel)
+                recording_.copyFrom(channel, (int) position, outputs_, channel, 0, numToRecord);
+
+            if(numToRecord > 0)
+                recorded_ = position + numToRecord;
+
+            rendered_ += numSamples;
+
+            // the output was due one block after the ideal start; a real clock is scaled by the speed
+            auto blockMs = numSamples * 1000.0 / settings_.sampleRate;
+
+            if(settings_.clock == Clock::realtime && settings_.speed > 0.0)
+                blockMs /= settings_.speed;
+
+            auto latenessMs = startDelayMs + callbackMs - blockMs;
+
+            const juce::ScopedLock sl(statsLock_);
+            ++stats_.callbacks;
+            stats_.samples += numSamples;
+            stats_.maxCallbackMs = juce::jmax(stats_.maxCallbackMs, callbackMs);
+
+            if(latenessMs > 0.0){
+                ++stats_.glitches;
+                stats_.maxLatenessMs = juce::jmax(stats_.maxLatenessMs, latenessMs);
+            }
+
+            if(callbackMs > blockMs)
+                ++stats_.ownGlitches;
+        }
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VirtualAudioDevice)
+};
+
+/*
+* Offers one VirtualAudioDevice to an AudioDeviceManager. Added as the only type, it keeps
+* the manager from probing the real drivers at all.
+*/
+class VirtualAudioDeviceType: public juce::AudioIODeviceType
+{
+    public:
+        static constexpr const char* typeName = "Virtual";
+        static constexpr const char* deviceName = "Virtual output";
+
+        explicit VirtualAudioDeviceType(const VirtualAudioDevice::Settings& settings)
+            : juce::AudioIODeviceType(typeName), settings_(settings) {}
+
+        void scanForDevices() override {}
+
+        juce::StringArray getDeviceNames(bool wantInputNames) const override{
+            return wantInputNames ? juce::StringArray() : juce::StringArray(juce::String(deviceName));
+        }
+
+        int getDefaultDeviceIndex(bool forInput) const override{
+            return forInput ? -1 : 0;
+        }
+
+        int getIndexOfDevice(juce::AudioIODevice* device, bool asInput) const override{
+            return ! asInput && dynamic_cast<VirtualAudioDevice*>(device) != nullptr ? 0 : -1;
+        }
+
+        bool hasSeparateInputsAndOutputs() const override{
+            return true;
+        }
+
+        juce::AudioIODevice* createDevice(const juce::String& outputDeviceName, const juce::String&) override{
+            return outputDeviceName == deviceName ? new VirtualAudioDevice(deviceName, settings_) : nullptr;
+        }
+
+    private:
+        VirtualAudioDevice::Settings settings_;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VirtualAudioDeviceType)
+};
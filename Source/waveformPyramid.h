@@ -0,0 +1,448 @@
+/*
+  ==============================================================================
+
+    waveformPyramid.h
+    Created: 17 Oct 2026 12:10:38am
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "thumbnailDiskCache.h"
+
+/*
+* Min/max/RMS summary of a whole file at several resolutions.
+*
+* Level 0 summarises baseSamplesPerBin samples per bin, every level above merges
+* levelFactor bins of the one below. Level 0 is built by splitting the file into ranges
+* that a ThreadPool decodes in parallel, each job with its own reader; the upper levels
+* are merged by whichever job finishes last. A change message is sent when it is complete.
+*
+* Every build() owns its own state and the jobs share it, so a new build never waits for
+* the jobs of the old one: they see the generation change at their next block and their
+* results are dropped. With a cache directory, level 0 of each finished pyramid is kept
+* there under the thumbnail's key, and a file opened again is loaded instead of decoded.
+*/
+class WaveformPyramid: public juce::ChangeBroadcaster
+{
+    public:
+        static constexpr int baseSamplesPerBin = 256;
+        static constexpr int levelFactor = 4;
+
+        struct Bin{
+            float min = 0.0f, max = 0.0f;
+            float sumSquares = 0.0f;    // RMS over the bin is sqrt(sumSquares / samplesPerBin)
+        };
+
+        /* without a `cacheDirectory` every build decodes the file */
+        WaveformPyramid(juce::AudioFormatManager& formatManager, int numThreads = juce::SystemStats::getNumCpus(), const juce::File& cacheDirectory = {})
+            : formatManager_(formatManager), pool_(juce::jmax(1, numThreads)), cacheDirectory_(cacheDirectory) {}
+
+        ~WaveformPyramid() override{
+            // the jobs call back into this object, so here they have to be gone before it is
+            ++generation_;
+            pool_.removeAllJobs(true, 10000);
+        }
+
+        /*
+        * starts building the pyramid for `file` in the background, abandoning any
+        * build that is still running. Must be called from the message thread.
+        */
+        bool build(const juce::File& file){
+            clear();
+
+            std::unique_ptr<juce::AudioFormatReader> reader(formatManager_.createReaderFor(file));
+
+            if(reader == nullptr || reader->lengthInSamples <= 0)
+                return false;
+
+            auto state = std::make_shared<Build>();
+            state->generation = generation_.load();
+            state->file = file;
+            state->numChannels = (int) reader->numChannels;
+            state->lengthInSamples = reader->lengthInSamples;
+            state->sampleRate = reader->sampleRate;
+
+            if(cacheDirectory_ != juce::File())
+                state->cacheFile = cacheDirectory_.getChildFile(juce::String::toHexString(KeyedFileInputSource::makeKey(file)) + ".pyramid");
+
+            // allocate every level up front, workers only ever write into their own bins
+            auto samplesPerBin = (juce::int64) baseSamplesPerBin;
+
+            for(;;){
+                auto* level = state->levels.add(new Level());
+                level->samplesPerBin = samplesPerBin;
+                level->numBins = (int) ((state->lengthInSamples + samplesPerBin - 1) / samplesPerBin);
+                level->bins.resize((size_t) (level->numBins * state->numChannels));
+
+                if(level->numBins <= 1)
+                    break;
+
+                samplesPerBin *= levelFactor;
+            }
+
+            state->startTicks = juce::Time::getHighResolutionTicks();
+            current_ = state;
+
+            if(state->cacheFile.existsAsFile())
+                pool_.addJob(new LoadJob(*this, state), true);
+            else
+                startRanges_(state);
+
+            return true;
+        }
+
+        /* doesn't wait for running jobs, they stop at their next block */
+        void clear(){
+            ++generation_;
+            pool_.removeAllJobs(true, 0);
+            current_.reset();
+        }
+
+        bool isComplete() const               { return current_ != nullptr && current_->complete.load(); }
+        bool hasFailed() const                { return current_ != nullptr && current_->failed.load(); }
+        int getNumChannels() const            { return current_ != nullptr ? current_->numChannels : 0; }
+        juce::int64 getLengthInSamples() const{ return current_ != nullptr ? current_->lengthInSamples : 0; }
+        double getSampleRate() const          { return current_ != nullptr ? current_->sampleRate : 0.0; }
+        int getNumLevels() const              { return current_ != nullptr ? current_->levels.size() : 0; }
+        int getNumThreads() const             { return pool_.getNumThreads(); }
+        double getBuildTimeMs() const         { return current_ != nullptr ? current_->buildTimeMs.load() : 0.0; }
+        bool wasLoadedFromCache() const       { return current_ != nullptr && current_->fromCache.load(); }
+
+        /*
+        * the coarsest level whose bins are still no wider than one pixel, so a column
+        * never has to merge more than levelFactor bins of the level above it
+        */
+        int getLevelFor(double samplesPerPixel) const{
+            auto best = 0;
+
+            for(auto i = 1; i < getNumLevels(); ++i)
+                if((double) current_->levels[i]->samplesPerBin <= samplesPerPixel)
+                    best = i;
+
+            return best;
+        }
+
+        /*
+        * draws every channel stacked in `area`, like AudioThumbnail::drawChannels(), with the
+        * RMS drawn inside the min/max envelope in a lighter shade of the current colour
+        */
+        void drawChannels(juce::Graphics& g, juce::Rectangle<int> area, double startTime, double endTime, float verticalZoom) const{
+            if(! isComplete() || current_->numChannels == 0 || area.isEmpty() || endTime <= startTime)
+                return;
+
+            const auto& state = *current_;
+            auto envelopeColour = g.getCurrentColour();
+            auto channelHeight = area.getHeight() / state.numChannels;
+            auto samplesPerPixel = (endTime - startTime) * state.sampleRate / area.getWidth();
+            const auto& level = *state.levels[getLevelFor(samplesPerPixel)];
+
+            for(auto channel = 0; channel < state.numChannels; ++channel){
+                auto channelArea = area.withTrimmedTop(channel * channelHeight).withHeight(channelHeight);
+                auto midY = (float) channelArea.getCentreY();
+                auto scale = (float) channelHeight * 0.5f * verticalZoom;
+                const auto* bins = level.bins.data() + (size_t) channel * (size_t) level.numBins;
+
+                juce::RectangleList<float> envelope, rms;
+
+                for(auto x = 0; x < area.getWidth(); ++x){
+                    auto firstSample = (juce::int64) ((startTime + (endTime - startTime) * x / area.getWidth()) * state.sampleRate);
+                    auto lastSample = (juce::int64) ((startTime + (endTime - startTime) * (x + 1) / area.getWidth()) * state.sampleRate);
+
+                    auto firstBin = (int) juce::jlimit((juce::int64) 0, (juce::int64) level.numBins - 1, firstSample / level.samplesPerBin);
+                    auto lastBin = (int) juce::jlimit((juce::int64) firstBin, (juce::int64) level.numBins - 1, (lastSample - 1) / level.samplesPerBin);
+
+                    if(firstSample >= state.lengthInSamples)
+                        break;
+
+                    auto low = bins[firstBin].min, high = bins[firstBin].max;
+                    auto sumSquares = 0.0f;
+
+                    for(auto b = firstBin; b <= lastBin; ++b){
+                        low = juce::jmin(low, bins[b].min);
+                        high = juce::jmax(high, bins[b].max);
+                        sumSquares += bins[b].sumSquares;
+                    }
+
+                    auto rmsValue = std::sqrt(sumSquares / (float) ((lastBin - firstBin + 1) * level.samplesPerBin));
+                    auto px = (float) (area.getX() + x);
+
+                    envelope.addWithoutMerging({ px, midY - high * scale, 1.0f, juce::jmax(1.0f, (high - low) * scale) });
+                    rms.addWithoutMerging({ px, midY - rmsValue * scale, 1.0f, juce::jmax(1.0f, 2.0f * rmsValue * scale) });
+                }
+
+                g.setColour(envelopeColour);
+                g.fillRectList(envelope);
+                g.setColour(envelopeColour.brighter(0.6f));
+                g.fillRectList(rms);
+            }
+
+            g.setColour(envelopeColour);
+        }
+
+    private:
+        static constexpr int cacheMagic = 0x52595057; // "WPYR"
+
+        struct Level{
+            juce::int64 samplesPerBin = 0;
+            int numBins = 0;
+            std::vector<Bin> bins;      // channel-major: bins[channel * numBins + index]
+        };
+
+        /* one build() call; shared by the jobs working on it, so it outlives a newer build */
+        struct Build{
+            int generation = 0;
+            juce::File file, cacheFile;
+            int numChannels = 0;
+            juce::int64 lengthInSamples = 0;
+            double sampleRate = 0.0;
+            juce::OwnedArray<Level> levels;
+
+            std::atomic<int> rangesRemaining { 0 };
+            std::atomic<bool> complete { false }, failed { false }, fromCache { false };
+            juce::int64 startTicks = 0;
+            std::atomic<double> buildTimeMs { 0.0 };
+        };
+
+        class RangeJob: public juce::ThreadPoolJob
+        {
+            public:
+                RangeJob(WaveformPyramid& owner, std::shared_ptr<Build> build, int firstBin, int endBin)
+                    : juce::ThreadPoolJob("Waveform range"), owner_(owner), build_(std::move(build)), firstBin_(firstBin), endBin_(endBin) {}
+
+                JobStatus runJob() override{
+                    // every exit path counts the range, so the last one always finishes the build
+                    if(! summariseRange_())
+                        build_->failed = true;
+
+                    if(--build_->rangesRemaining == 0)
+                        owner_.finishBuild_(*build_);
+
+                    return jobHasFinished;
+                }
+
+            private:
+                WaveformPyramid& owner_;
+                std::shared_ptr<Build> build_;
+                int firstBin_, endBin_;
+
+                /* false unless every bin of the range was filled */
+                bool summariseRange_(){
+                    std::unique_ptr<juce::AudioFormatReader> reader(owner_.formatManager_.createReaderFor(build_->file));
+
+                    if(reader == nullptr)
+                        return false;
+
+                    auto& level = *build_->levels[0];
+                    constexpr int binsPerRead = 64;
+                    juce::AudioBuffer<float> block(build_->numChannels, binsPerRead * baseSamplesPerBin);
+
+                    for(auto bin = firstBin_; bin < endBin_; bin += binsPerRead){
+                        if(shouldExit() || owner_.isStale_(*build_))
+                            return false;
+
+                        auto binsThisTime = juce::jmin(binsPerRead, endBin_ - bin);
+                        auto startSample = (juce::int64) bin * baseSamplesPerBin;
+                        auto numSamples = (int) juce::jmin((juce::int64) binsThisTime * baseSamplesPerBin, build_->lengthInSamples - startSample);
+
+                        if(! reader->read(&block, 0, numSamples, startSample, true, true))
+                            return false;
+
+                        for(auto channel = 0; channel < build_->numChannels; ++channel){
+                            const auto* samples = block.getReadPointer(channel);
+                            auto* out = level.bins.data() + (size_t) channel * (size_t) level.numBins + (size_t) bin;
+
+                            for(auto b = 0; b < binsThisTime; ++b){
+                                auto offset = b * baseSamplesPerBin;
+                                auto count = juce::jmin(baseSamplesPerBin, numSamples - offset);
+
+                                if(count <= 0)
+                                    break;
+
+                                out[b] = summarise(samples + offset, count);
+                            }
+                        }
+                    }
+
+                    return true;
+                }
+
+                static Bin summarise(const float* samples, int count) noexcept{
+                    Bin bin;
+
+                    // vectorised min/max reduction from FloatVectorOperations (SSE/NEON)
+                    auto range = juce::FloatVectorOperations::findMinAndMax(samples, count);
+                    bin.min = range.getStart();
+                    bin.max = range.getEnd();
+
+                    // four independent accumulators so the compiler can keep the lanes busy
+                    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+                    auto i = 0;
+
+                    for(; i + 4 <= count; i += 4){
+                        s0 += samples[i] * samples[i];
+                        s1 += samples[i + 1] * samples[i + 1];
+                        s2 += samples[i + 2] * samples[i + 2];
+                        s3 += samples[i + 3] * samples[i + 3];
+                    }
+
+                    for(; i < count; ++i)
+                        s0 += samples[i] * samples[i];
+
+                    bin.sumSquares = (s0 + s1) + (s2 + s3);
+                    return bin;
+                }
+        };
+
+        /* reads level 0 from the cache, or falls back to decoding when the entry doesn't fit the file */
+        class LoadJob: public juce::ThreadPoolJob
+        {
+            public:
+                LoadJob(WaveformPyramid& owner, std::shared_ptr<Build> build)
+                    : juce::ThreadPoolJob("Waveform cache"), owner_(owner), build_(std::move(build)) {}
+
+                JobStatus runJob() override{
+                    if(shouldExit() || owner_.isStale_(*build_))
+                        return jobHasFinished;
+
+                    if(readCache_(*build_)){
+                        build_->fromCache = true;
+                        owner_.finishBuild_(*build_);
+                    }
+                    else{
+                        build_->cacheFile.deleteFile();
+                        owner_.startRanges_(build_);
+                    }
+
+                    return jobHasFinished;
+                }
+
+            private:
+                WaveformPyramid& owner_;
+                std::shared_ptr<Build> build_;
+
+                static bool readCache_(Build& build){
+                    juce::FileInputStream in(build.cacheFile);
+                    auto& level = *build.levels[0];
+                    auto numBytes = level.bins.size() * sizeof(Bin);
+
+                    if(in.failedToOpen() || in.getTotalLength() != 20 + (juce::int64) numBytes
+                        || in.readInt() != cacheMagic || in.readInt() != baseSamplesPerBin
+                        || in.readInt() != build.numChannels || in.readInt64() != build.lengthInSamples)
+                        return false;
+
+                    auto* dest = reinterpret_cast<char*>(level.bins.data());
+
+                    for(size_t done = 0; done < numBytes;){
+                        auto chunk = (int) juce::jmin((size_t) 1 << 24, numBytes - done);
+
+                        if(in.read(dest + done, chunk) != chunk)
+                            return false;
+
+                        done += (size_t) chunk;
+                    }
+
+                    return true;
+                }
+        };
+
+        bool isStale_(const Build& build) const{
+            return build.generation != generation_.load();
+        }
+
+        /* callable from a job, which is how a cache miss found by LoadJob gets decoded */
+        void startRanges_(const std::shared_ptr<Build>& build){
+            // ranges are whole level-0 bins; several per thread keeps the cores busy to the end
+            auto numBins = build->levels[0]->numBins;
+            auto numRanges = juce::jlimit(1, numBins, pool_.getNumThreads() * 4);
+            auto binsPerRange = (numBins + numRanges - 1) / numRanges;
+
+            build->rangesRemaining = (numBins + binsPerRange - 1) / binsPerRange;
+
+            for(auto firstBin = 0; firstBin < numBins; firstBin += binsPerRange)
+                pool_.addJob(new RangeJob(*this, build, firstBin, juce::jmin(numBins, firstBin + binsPerRange)), true);
+        }
+
+        void finishBuild_(Build& build){
+            // cleared or replaced while it ran: nobody is going to look at it
+            if(isStale_(build))
+                return;
+
+            if(build.failed.load()){
+                // the thumbnail stays up; listeners still hear that the build is over
+                sendChangeMessage();
+                return;
+            }
+
+            // merge levelFactor bins of each level into one bin of the level above
+            for(auto l = 1; l < build.levels.size(); ++l){
+                const auto& below = *build.levels[l - 1];
+                auto& level = *build.levels[l];
+
+                for(auto channel = 0; channel < build.numChannels; ++channel){
+                    const auto* in = below.bins.data() + (size_t) channel * (size_t) below.numBins;
+                    auto* out = level.bins.data() + (size_t) channel * (size_t) level.numBins;
+
+                    for(auto b = 0; b < level.numBins; ++b){
+                        auto first = b * levelFactor;
+                        auto last = juce::jmin(below.numBins, first + levelFactor);
+                        Bin merged = in[first];
+
+                        for(auto i = first + 1; i < last; ++i){
+                            merged.min = juce::jmin(merged.min, in[i].min);
+                            merged.max = juce::jmax(merged.max, in[i].max);
+                            merged.sumSquares += in[i].sumSquares;
+                        }
+
+                        out[b] = merged;
+                    }
+                }
+            }
+
+            build.buildTimeMs = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - build.startTicks) * 1000.0;
+            build.complete = true;
+            sendChangeMessage();
+
+            // the bins are only read from here on, so the cache is written while they are drawn
+            if(build.cacheFile != juce::File() && ! build.fromCache.load())
+                writeCache_(build);
+        }
+
+        static void writeCache_(const Build& build){
+            const auto& level = *build.levels[0];
+            build.cacheFile.getParentDirectory().createDirectory();
+            juce::TemporaryFile temporary(build.cacheFile);
+
+            {
+                juce::FileOutputStream out(temporary.getFile());
+
+                if(out.failedToOpen())
+                    return;
+
+                out.writeInt(cacheMagic);
+                out.writeInt(baseSamplesPerBin);
+                out.writeInt(build.numChannels);
+                out.writeInt64(build.lengthInSamples);
+                out.write(level.bins.data(), level.bins.size() * sizeof(Bin));
+                out.flush();
+
+                if(out.getStatus().failed())
+                    return;
+            }
+
+            temporary.overwriteTargetFileWithTemporary();
+        }
+
+        juce::AudioFormatManager& formatManager_;
+        juce::ThreadPool pool_;
+        juce::File cacheDirectory_;
+
+        std::atomic<int> generation_ { 0 };
+        std::shared_ptr<Build> current_;        // message thread only
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformPyramid)
+};